@@ -5,4 +5,25 @@
 constexpr bool VERBOSE = true; // Set to false to disable verbose debugging
 constexpr bool DEBUG = true;   // Set to false to disable debug-specific features
 
+// CPU opcode dispatch: per-opcode handler table (default) or the legacy instruction switch
+#ifdef NES_CPU_SWITCH_DISPATCH
+constexpr bool TABLE_DISPATCH = false;
+#else
+constexpr bool TABLE_DISPATCH = true;
+#endif
+
+// CPU idle loops: fast-forward loops spinning on PPUSTATUS or WRAM to the next PPU or APU event
+#ifdef NES_CPU_NO_IDLE_SKIP
+constexpr bool IDLE_LOOP_SKIP = false;
+#else
+constexpr bool IDLE_LOOP_SKIP = true;
+#endif
+
+// CPU decoded-instruction cache: run straight-line code from blocks decoded once per PRG bank
+#ifdef NES_CPU_NO_DECODE_CACHE
+constexpr bool DECODE_CACHE = false;
+#else
+constexpr bool DECODE_CACHE = true;
+#endif
+
 #endif // CONFIG_H
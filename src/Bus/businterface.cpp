@@ -1,10 +1,85 @@
 #include "businterface.h"
 #include "Cpu/cpu6502_memory_map.h"
+#include "snapshot.h"
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 
-BusInterface::BusInterface(std::shared_ptr<Cartridge> cartridge, std::shared_ptr<PPU> ppu)
-    : cartridge(cartridge), ppu(ppu) {}
+/* Master clock section, between the cartridge and the PPU */
+static constexpr uint32_t BUS_SECTION = sectionID("BUS ");
+static constexpr uint32_t BUS_SECTION_VERSION = 2;
+
+struct BusState {
+    uint64_t cpuCycle;
+    uint8_t frameCompleted;
+    uint8_t controllerShift[2];
+    uint8_t controllerStrobe;
+    uint8_t reserved[4];
+};
+
+BusInterface::BusInterface(std::shared_ptr<Cartridge> cartridge, std::shared_ptr<PPU> ppu,
+                           std::shared_ptr<APU> apu)
+    : cartridge(cartridge), ppu(ppu), apu(apu)
+{
+    ppu->connectCartridge(cartridge);
+
+    /* DMC samples are always fetched from $8000 - $FFFF */
+    apu->setMemoryReader([cartridge](uint16_t address) { return cartridge->readPRGROM(address); });
+    apuDeadline = apu->nextEventCycle();
+}
+
+bool BusInterface::clockPPU(uint32_t cpuCycles)
+{
+    cpuCycle += cpuCycles;
+
+    /* Only run the PPU once its next VBlank event (and NMI) is due */
+    if (cpuCycle * 3 >= ppuDeadline) {
+        syncPPU();
+    }
+    if (cpuCycle >= apuDeadline) {
+        syncAPU();
+    }
+
+    /* Report frames completed here or during a register access catch-up */
+    bool completed = frameCompleted;
+    frameCompleted = false;
+    if (completed) {
+        cartridge->flushSaveRAM(); // Battery RAM is synced at frame boundaries only
+        apu->endFrame(cpuCycle);     // Hand the frame's audio to the output buffer
+        apuDeadline = apu->nextEventCycle();
+    }
+    return completed;
+}
+
+void BusInterface::syncPPU() const
+{
+    frameCompleted |= ppu->catchUp(cpuCycle * 3);
+    ppuDeadline = ppu->nextEventCycle();
+}
+
+void BusInterface::syncAPU() const
+{
+    apu->catchUp(cpuCycle);
+    apuDeadline = apu->nextEventCycle();
+}
+
+uint64_t BusInterface::nextEventCPUCycle(bool ppuStatus) const
+{
+    uint64_t ppuEvent = ppuStatus ? std::min(ppuDeadline, ppu->nextStatusChangeCycle()) : ppuDeadline;
+
+    /* First CPU cycle whose PPU time reaches the event: that is where clockPPU() or a read would see it */
+    return std::min((ppuEvent + 2) / 3, apuDeadline);
+}
+
+bool BusInterface::isIRQAsserted() const
+{
+    return apu->isIRQAsserted() || cartridge->isIRQAsserted();
+}
+
+uint64_t BusInterface::getCPUCycle() const
+{
+    return cpuCycle;
+}
 
 uint8_t BusInterface::ppuBusRead(uint16_t address) const
 {
@@ -24,35 +99,71 @@ void BusInterface::ppuBusWrite(uint16_t address, uint8_t data)
     return; // TODO:
 }
 
-uint8_t BusInterface::cpuBusRead(uint16_t address) const
+const uint8_t* BusInterface::cpuReadPage(uint16_t address) const
 {
-    /* PPU register access: $2000 - $2007 */
-    if (address >= PPU_REGISTERS_STARTADDR && address < PPU_REGISTERS_ENDADDR) {
-        return ppu->readRegister(address);
+    /* Cartridge SRAM space access: $6000 - $7FFF */
+    if (address >= CARTRIDGE_SRAM_STARTADDR && address < CARTRIDGE_SRAM_ENDADDR) {
+        return cartridge->getPRGRAMPage(address);
     }
 
-    /* PPU register mirrored access: $2008 - $3FFF */
-    if (address >= PPU_MIRRORS_STARTADDR && address < PPU_MIRRORS_ENDADDR) {
-        uint16_t mirroredAddress = PPU_REGISTERS_STARTADDR + (address % 8);
-        return 0xFF; //TODO: ppu.readRegister(mirroredAddress);
+    /* Registers and unmapped space; cartridge ROM is read through cpuPRGWindows() */
+    return nullptr;
+}
+
+const std::array<const uint8_t*, 4>& BusInterface::cpuPRGWindows() const
+{
+    return cartridge->getPRGWindows();
+}
+
+uint8_t* BusInterface::cpuWritePage(uint16_t address)
+{
+    /* Cartridge SRAM space access: $6000 - $7FFF */
+    if (address >= CARTRIDGE_SRAM_STARTADDR && address < CARTRIDGE_SRAM_ENDADDR) {
+        return cartridge->getPRGRAMWritePage(address);
+    }
+
+    /* Registers and ROM: everything else goes through cpuBusWrite */
+    return nullptr;
+}
+
+void BusInterface::cpuOAMDMA(const uint8_t* data)
+{
+    /* Sprites of lines the PPU has yet to draw still use the old OAM */
+    syncPPU();
+    ppu->writeOAMDMA(data);
+}
+
+uint8_t BusInterface::cpuBusRead(uint16_t address) const
+{
+    /* PPU registers and their mirrors: $2000 - $3FFF */
+    if (address >= PPU_REGISTERS_STARTADDR && address < PPU_MIRRORS_ENDADDR) {
+        syncPPU();
+        return ppu->readRegister(address & 0x2007);
     }
 
     /* APU and I/O register access: $4000 - $401F */
     if (address >= APU_IO_STARTADDR && address < APU_IO_ENDADDR) {
-        // Placeholder for future APU/IO implementation
-        return 0xFF; //TODO: apu.readRegister(address);
-        std::stringstream ss;
-        ss << std::string(__PRETTY_FUNCTION__) << " - "
-         << "Unsupported APU IO REG bus write at address 0x"
-           << std::hex << std::uppercase << address;
-        throw std::runtime_error(ss.str());
+        if (address == APU_STATUS_ADDR) {
+            syncAPU();
+            return apu->readStatus(); // Length counters and IRQ flags as of this cycle
+        }
+        if (address == CONTROLLER1_ADDR || address == CONTROLLER2_ADDR) {
+            /* One button per read, A first; ones once all eight have been shifted out. Bit 6 is open bus */
+            int port = address - CONTROLLER1_ADDR;
+            if (controllerStrobe) {
+                return 0x40 | (controllerButtons[port] & 0x01);
+            }
+            uint8_t bit = controllerShift[port] & 0x01;
+            controllerShift[port] = (controllerShift[port] >> 1) | 0x80;
+            return 0x40 | bit;
+        }
         return 0xFF;
     }
 
     /* Cartridge SRAM space access: $6000 - $7FFF */
     if (address >= CARTRIDGE_SRAM_STARTADDR && address < CARTRIDGE_SRAM_ENDADDR) {
-        // Placeholder for cartridge handling
-        return 0xFF; //TODO:
+        const uint8_t* page = cartridge->getPRGRAMPage(address);
+        return page ? page[address & 0xFF] : 0xFF; // Open bus without PRG-RAM
     }
 
     /* Cartridge ROM space access: $8000 - $FFFF */
@@ -66,46 +177,92 @@ uint8_t BusInterface::cpuBusRead(uint16_t address) const
 
 void BusInterface::cpuBusWrite(uint16_t address, uint8_t data)
 {
-    /* PPU register access: $2000 - $2007 */
-    if (address >= PPU_REGISTERS_STARTADDR && address < PPU_REGISTERS_ENDADDR) {
-        ppu->writeRegister(address, data);
-    }
-
-    /* PPU register mirrored access: $2008 - $3FFF */
-    if (address >= PPU_MIRRORS_STARTADDR && address < PPU_MIRRORS_ENDADDR) {
-        uint16_t mirroredAddress = PPU_REGISTERS_STARTADDR + (address % 8);
-        std::stringstream ss;
-        ss << std::string(__PRETTY_FUNCTION__) << " - "
-        << "Unsupported PPU MIRROR REG bus write at address 0x"
-        << std::hex << std::uppercase << address;
-        throw std::runtime_error(ss.str());
+    /* PPU registers and their mirrors: $2000 - $3FFF */
+    if (address >= PPU_REGISTERS_STARTADDR && address < PPU_MIRRORS_ENDADDR) {
+        syncPPU();
+        ppu->writeRegister(address & 0x2007, data);
+        ppuDeadline = ppu->nextEventCycle(); // The write may enable NMI or rendering
         return;
     }
 
     /* APU and I/O register access: $4000 - $401F */
     if (address >= APU_IO_STARTADDR && address < APU_IO_ENDADDR) {
-        return; //TODO: remove
-        std::stringstream ss;
-        ss << std::string(__PRETTY_FUNCTION__) << " - "
-         << "Unsupported APU IO REG bus write at address 0x"
-           << std::hex << std::uppercase << address;
-        throw std::runtime_error(ss.str());
+        if (address < APU_CHANNELS_ENDADDR || address == APU_STATUS_ADDR || address == APU_FRAME_COUNTER_ADDR) {
+            syncAPU();
+            apu->writeRegister(address, data);
+            apuDeadline = apu->nextEventCycle(); // The write may start the DMC or change the frame IRQ
+        }
+        if (address == CONTROLLER1_ADDR) {
+            /* Both controllers latch their buttons while the strobe is high */
+            controllerStrobe = data & 0x01;
+            if (controllerStrobe) {
+                controllerShift = controllerButtons;
+            }
+        }
         return;
     }
 
     /* Cartridge SRAM space access: $6000 - $7FFF */
     if (address >= CARTRIDGE_SRAM_STARTADDR && address < CARTRIDGE_SRAM_ENDADDR) {
-        std::stringstream ss;
-        ss << std::string(__PRETTY_FUNCTION__) << " - "
-         << "Unsupported CARTRIDGE SRAM bus write at address 0x"
-           << std::hex << std::uppercase << address;
-        throw std::runtime_error(ss.str());
+        if (uint8_t* page = cartridge->getPRGRAMWritePage(address)) {
+            page[address & 0xFF] = data;
+        }
         return;
     }
 
     /* Cartridge ROM space access: $8000 - $FFFF */
     if (address >= CARTRIDGE_ROM_STARTADDR && address <= CARTRIDGE_ROM_ENDADDR) {
-        // ROM write ignored
+        /* Mapper registers: draw the pixels output with the old banks before switching */
+        syncPPU();
+        ppu->flushScanline();
+        cartridge->writeMapperRegister(address, data);
+        ppu->updateMirroring();
+        ppuDeadline = ppu->nextEventCycle(); // The write may enable the mapper IRQ
         return;
     }
-}
\ No newline at end of file
+}
+
+void BusInterface::saveState(SnapshotWriter& writer) const
+{
+    syncPPU();
+    syncAPU();
+
+    cartridge->saveState(writer);
+
+    BusState state{cpuCycle, frameCompleted, {controllerShift[0], controllerShift[1]}, controllerStrobe, {}};
+    writer.beginSection(BUS_SECTION, BUS_SECTION_VERSION);
+    writer.write(state);
+    writer.endSection();
+
+    ppu->saveState(writer);
+    apu->saveState(writer);
+}
+
+void BusInterface::loadState(SnapshotReader& reader)
+{
+    /* The cartridge first: the PPU's nametable mapping follows the restored mirroring */
+    cartridge->loadState(reader);
+
+    BusState state;
+    reader.beginSection(BUS_SECTION, BUS_SECTION_VERSION);
+    reader.read(state);
+    reader.endSection();
+    cpuCycle = state.cpuCycle;
+    frameCompleted = state.frameCompleted != 0;
+    controllerShift = {state.controllerShift[0], state.controllerShift[1]};
+    controllerStrobe = state.controllerStrobe != 0;
+
+    ppu->loadState(reader);
+    apu->loadState(reader);
+
+    ppuDeadline = ppu->nextEventCycle();
+    apuDeadline = apu->nextEventCycle();
+}
+
+void BusInterface::setControllerButtons(int port, uint8_t buttons)
+{
+    controllerButtons[port & 0x01] = buttons;
+    if (controllerStrobe) {
+        controllerShift[port & 0x01] = buttons;
+    }
+}
@@ -6,10 +6,12 @@
 #ifndef BUSINTERFACE_H
 #define BUSINTERFACE_H
 
+#include <array>
 #include <cstdint>
 #include "cartridge.h"
 #include <memory>
 #include "ppu.h"
+#include "apu.h"
 
 
 /**
@@ -31,8 +33,11 @@ public:
     /**
      * @brief Constructs the BusInterface with a Cartridge instance.
      * @param cartridge Unique pointer to the Cartridge instance.
+     * @param ppu The PPU on the bus.
+     * @param apu The APU on the bus; DMC sample fetches are served from the cartridge.
      */
-    explicit BusInterface(std::shared_ptr<Cartridge> cartridge, std::shared_ptr<PPU> ppu);
+    explicit BusInterface(std::shared_ptr<Cartridge> cartridge, std::shared_ptr<PPU> ppu,
+                          std::shared_ptr<APU> apu = std::make_shared<APU>());
 
     /**
      * @brief Reads a byte from the CPU bus at the specified address.
@@ -48,6 +53,45 @@ public:
      */
     void cpuBusWrite(uint16_t address, uint8_t data);
 
+    /**
+     * @brief Returns a direct read pointer to the 256-byte CPU page containing an address.
+     * @param address Any address within the page.
+     * @return Pointer to the start of the page, or nullptr if the page is memory-mapped I/O.
+     */
+    const uint8_t* cpuReadPage(uint16_t address) const;
+
+    /**
+     * @brief Returns a direct write pointer to the 256-byte CPU page containing an address.
+     * @param address Any address within the page.
+     * @return Pointer to the start of the page, or nullptr if writes must go through cpuBusWrite().
+     */
+    uint8_t* cpuWritePage(uint16_t address);
+
+    /**
+     * @brief Returns true while the APU or the mapper asserts the CPU IRQ line.
+     *
+     * Both are up to date between CPU instructions: IRQ flags are only set
+     * at predicted deadlines, which the bus runs them to, and only cleared
+     * by register accesses, which catch them up first.
+     */
+    bool isIRQAsserted() const;
+
+    /**
+     * @brief Gets the cartridge's four 8 KB PRG window pointers for $8000-$FFFF.
+     *
+     * The array is updated in place on bank switches, so the CPU can keep a
+     * reference to it and read ROM without going through the bus.
+     *
+     * @return The PRG window base pointers, indexed by (address >> 13) & 3.
+     */
+    const std::array<const uint8_t*, 4>& cpuPRGWindows() const;
+
+    /**
+     * @brief Copies a 256-byte page into PPU OAM (the transfer of an OAM DMA).
+     * @param data The source page.
+     */
+    void cpuOAMDMA(const uint8_t* data);
+
     /**
      * @brief Reads a byte from the PPU bus at the specified address.
      * @param address Memory address to read from.
@@ -62,9 +106,85 @@ public:
      */
     void ppuBusWrite(uint16_t address, uint8_t data);
 
+    /**
+     * @brief Advances the master clock by the given number of elapsed CPU cycles.
+     *
+     * The PPU is not run here unless its next predicted event (VBlank start or
+     * end, or a mapper scanline IRQ) has been reached; otherwise it is caught up lazily on the next
+     * access to one of its registers. The APU is run in the same way up to
+     * its next IRQ, and at the end of every frame to emit that frame's audio.
+     *
+     * @param cpuCycles Number of CPU cycles elapsed (three PPU cycles each).
+     * @return True if the PPU completed a frame since the previous call.
+     */
+    bool clockPPU(uint32_t cpuCycles);
+
+    /**
+     * @brief Runs the PPU up to the current master clock and predicts its next event.
+     */
+    void syncPPU() const;
+
+    /**
+     * @brief Gets the master clock in CPU cycles since power-on.
+     * @return The number of CPU cycles elapsed.
+     */
+    uint64_t getCPUCycle() const;
+
+    /**
+     * @brief Runs the APU up to the current master clock and predicts its next IRQ.
+     */
+    void syncAPU() const;
+
+    /**
+     * @brief Predicts the first CPU cycle at which an interrupt may be raised or, optionally, PPUSTATUS may change.
+     *
+     * Until then the CPU observes nothing but its own memory accesses, so a
+     * loop that only reads memory (and PPUSTATUS) runs the same on every pass.
+     *
+     * @param ppuStatus Include changes of the PPUSTATUS flags (VBlank, sprite 0 hit, sprite overflow).
+     * @return The master clock cycle of the earliest such event.
+     */
+    uint64_t nextEventCPUCycle(bool ppuStatus) const;
+
+    /**
+     * @brief Writes the cartridge, master clock, PPU and APU to a snapshot, in that order.
+     *
+     * The PPU and APU are caught up to the master clock first, so the
+     * snapshot holds the whole machine at one instant.
+     *
+     * @param writer The snapshot being written.
+     */
+    void saveState(SnapshotWriter& writer) const;
+
+    /**
+     * @brief Restores the sections written by saveState() and predicts the next PPU and APU events.
+     * @param reader The snapshot being read.
+     */
+    void loadState(SnapshotReader& reader);
+
+    /**
+     * @brief Sets the buttons held on a standard controller.
+     *
+     * The game sees the new state the next time it strobes the controllers.
+     *
+     * @param port Controller port, 0 or 1.
+     * @param buttons A (bit 0), B, Select, Start, Up, Down, Left, Right (bit 7); set bits are pressed.
+     */
+    void setControllerButtons(int port, uint8_t buttons);
+
 private:
     std::shared_ptr<Cartridge> cartridge; /**< Pointer to the loaded NES cartridge. */
     std::shared_ptr<PPU> ppu;
+    std::shared_ptr<APU> apu;
+
+    uint64_t cpuCycle = 0;              /**< Master clock, in CPU cycles. */
+    mutable uint64_t ppuDeadline = 0;   /**< PPU timestamp of the next predicted PPU event. */
+    mutable uint64_t apuDeadline = 0;   /**< CPU cycle of the next predicted APU IRQ. */
+    mutable bool frameCompleted = false; /**< A frame completed since the last clockPPU() report. */
+
+    std::array<uint8_t, 2> controllerButtons{};         /**< Buttons held on each controller. */
+    mutable std::array<uint8_t, 2> controllerShift{};   /**< Serial shift register of each controller. */
+    bool controllerStrobe = false;                      /**< Strobe high: the shift registers keep reloading. */
 };
 
 #endif // BUSINTERFACE_H
@@ -1,8 +1,86 @@
 #include "cartridge.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 
-Cartridge::Cartridge(const std::string& filepath)
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CARTRIDGE_HAVE_MMAP 1
+#endif
+
+/* Identifies the cartridge a snapshot was taken from */
+struct CartridgeIdentity {
+    uint32_t PRGSize;
+    uint32_t CHRSize;
+    uint32_t PRGRAMSize;
+    uint16_t mapperID;
+    uint8_t CHRRAM;
+    uint8_t reserved;
+    uint64_t ROMHash;
+};
+
+static constexpr uint32_t CARTRIDGE_SECTION = sectionID("CART");
+static constexpr uint32_t CARTRIDGE_SECTION_VERSION = 4;
+
+/* NES 2.0 ROM size: MSB/LSB in units, or 2^E * (MM * 2 + 1) bytes when the MSB nibble is $F */
+static size_t decodeROMSize(uint8_t lsb, uint8_t msb, size_t unit)
+{
+    if (msb == 0x0F) {
+        unsigned exponent = lsb >> 2;
+        if (exponent >= 32) {
+            throw std::runtime_error("ROM size in header is too large.");
+        }
+        return (size_t(1) << exponent) * ((lsb & 0x03) * 2 + 1);
+    }
+    return ((size_t(msb) << 8) | lsb) * unit;
+}
+
+/* NES 2.0 RAM size: 64 << shift bytes, or none for a zero shift */
+static size_t decodeRAMSize(uint8_t shift)
+{
+    return shift ? size_t(64) << shift : 0;
+}
+
+Cartridge::Cartridge(const std::string& filepath, RomLoadMode mode, SaveRAMMode saveMode)
+{
+    if (mode != RomLoadMode::MemoryMap || !mapFile(filepath)) {
+        loadFile(filepath);
+    }
+    initialise();
+    initialisePRGRAM(filepath, saveMode);
+}
+
+Cartridge::~Cartridge()
+{
+    /* Battery RAM held in a plain buffer is written back once, at shutdown */
+    if (!savePath.empty() && !saveMapping.address) {
+        std::ofstream file(savePath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(PRGRAMData), PRGRAMSize);
+        if (!file) {
+            std::cerr << "Failed to write save file: " << savePath << std::endl;
+        }
+    }
+}
+
+Cartridge::FileMapping::~FileMapping()
+{
+#ifdef CARTRIDGE_HAVE_MMAP
+    if (address) {
+        if (shared) {
+            msync(address, size, MS_SYNC);
+        }
+        munmap(address, size);
+    }
+#endif
+}
+
+void Cartridge::loadFile(const std::string& filepath)
 {
     /* 1, Open .nes file in binary mode */
     std::ifstream file(filepath, std::ios::binary);
@@ -15,32 +93,19 @@ Cartridge::Cartridge(const std::string& filepath)
     if (!file) {
         throw std::runtime_error("Failed to read ROM header from file: " + filepath);
     }
+    decodeHeader();
 
-    /* Verify the magic number */
-    if (std::strncmp(RomHeader.magic, "NES\x1A", 4) != 0) {
-        throw std::runtime_error("Invalid NES magic number.");
-    }
-
-    /* Check for NES 2.0 format */
-    if (((RomHeader.flags7 >> 2) & 0x03) == 0x02) {
-        throw std::runtime_error("NES 2.0 format is not supported.");
-    }
-
-    /* Assign specific flags */
-    mapperID = (RomHeader.flags6 >> 4) | (RomHeader.flags7 & 0xF0);
+    /* PRG-ROM size in bytes */
+    PRGROM.resize(layout.PRGROMSize);
 
-    /* PRG-ROM size in bytes (16 KB units) */
-    size_t PRGROM_size = RomHeader.PRGROM_size * 16 * 1024;
-    PRGROM.resize(PRGROM_size);
-
-    /* CHR-ROM size in bytes (8 KB units; if zero, CHR-RAM is used) */
-    size_t CHRROM_size = RomHeader.CHRROM_size * 8 * 1024;
+    /* CHR-ROM size in bytes (if zero, CHR-RAM is used) */
+    size_t CHRROM_size = layout.CHRROMSize;
     if (CHRROM_size > 0) {
         CHRROM.resize(CHRROM_size);
     }
 
     /* 3. Read trainer data, if any */
-    if(RomHeader.flags6 & (1 << 2))
+    if (layout.trainer)
     {
         trainer.resize(512);
         file.read(reinterpret_cast<char*>(trainer.data()), trainer.size());
@@ -66,62 +131,389 @@ Cartridge::Cartridge(const std::string& filepath)
     /* Close the file explicitly (destructor will handle it) */
     file.close();
 
+    PRGData = PRGROM.data();
+    PRGSize = PRGROM.size();
+    CHRData = CHRROM.data();
+    CHRSize = CHRROM.size();
+}
+
+bool Cartridge::mapFile(const std::string& filepath)
+{
+#ifdef CARTRIDGE_HAVE_MMAP
+    /* 1. Map the whole file read-only; any failure falls back to copying */
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(RomHeaderType))) {
+        close(fd);
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(fileStat.st_size);
+    void* address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    mapping.address = address;
+    mapping.size = fileSize;
+
+    /* 2. Parse the header in place */
+    const uint8_t* image = static_cast<const uint8_t*>(mapping.address);
+    std::memcpy(&RomHeader, image, sizeof(RomHeaderType));
+    decodeHeader();
+    size_t offset = sizeof(RomHeaderType);
+
+    /* 3. Copy the trainer, if any (512 bytes) */
+    if (layout.trainer) {
+        if (offset + 512 > mapping.size) {
+            throw std::runtime_error("Failed to read trainer data.");
+        }
+        trainer.assign(image + offset, image + offset + 512);
+        offset += 512;
+    }
+
+    /* 4. PRG-ROM and CHR-ROM are used directly from the mapping */
+    PRGSize = layout.PRGROMSize;
+    if (offset + PRGSize > mapping.size) {
+        throw std::runtime_error("Failed to read PRG-ROM data.");
+    }
+    PRGData = image + offset;
+    offset += PRGSize;
+
+    CHRSize = layout.CHRROMSize;
+    if (offset + CHRSize > mapping.size) {
+        throw std::runtime_error("Failed to read CHR-ROM data.");
+    }
+    CHRData = image + offset;
+
+    return true;
+#else
+    (void)filepath;
+    return false;
+#endif
+}
+
+void Cartridge::decodeHeader()
+{
+    /* Verify the magic number */
+    if (std::strncmp(RomHeader.magic, "NES\x1A", 4) != 0) {
+        throw std::runtime_error("Invalid NES magic number.");
+    }
+
+    /* Fields common to both formats */
+    layout = CartridgeLayout();
+    layout.NES20 = ((RomHeader.flags7 >> 2) & 0x03) == 0x02;
+    layout.battery = RomHeader.flags6 & (1 << 1);
+    layout.trainer = RomHeader.flags6 & (1 << 2);
+    layout.mirroring = (RomHeader.flags6 & (1 << 3)) ? Mirroring::FourScreen
+                     : (RomHeader.flags6 & (1 << 0)) ? Mirroring::Vertical
+                     : Mirroring::Horizontal;
+
+    if (layout.NES20) {
+        /* NES 2.0: 12-bit mapper number, submapper and exact memory sizes */
+        layout.mapperID = (RomHeader.flags6 >> 4) | (RomHeader.flags7 & 0xF0) | ((RomHeader.flags8 & 0x0F) << 8);
+        layout.submapper = RomHeader.flags8 >> 4;
+        layout.PRGROMSize = decodeROMSize(RomHeader.PRGROM_size, RomHeader.flags9 & 0x0F, 16 * 1024);
+        layout.CHRROMSize = decodeROMSize(RomHeader.CHRROM_size, RomHeader.flags9 >> 4, 8 * 1024);
+        layout.PRGRAMSize = decodeRAMSize(RomHeader.flags10 & 0x0F);
+        layout.PRGNVRAMSize = decodeRAMSize(RomHeader.flags10 >> 4);
+        layout.CHRRAMSize = decodeRAMSize(RomHeader.flags11 & 0x0F);
+        layout.CHRNVRAMSize = decodeRAMSize(RomHeader.flags11 >> 4);
+        layout.timing = static_cast<TimingRegion>(RomHeader.flags12 & 0x03);
+    } else {
+        /* iNES: dumps with junk in bytes 12-15 (e.g. "DiskDude!") also corrupt the mapper's high nibble */
+        bool dirty = RomHeader.flags12 || RomHeader.flags13 || RomHeader.flags14 || RomHeader.flags15;
+        layout.mapperID = (RomHeader.flags6 >> 4) | (dirty ? 0 : (RomHeader.flags7 & 0xF0));
+        layout.PRGROMSize = RomHeader.PRGROM_size * 16 * 1024;
+        layout.CHRROMSize = RomHeader.CHRROM_size * 8 * 1024;
+
+        /* PRG-RAM size in 8 KB units, where 0 means 8 KB; the battery backs all of it */
+        size_t PRGRAMSize = std::max<size_t>(RomHeader.flags8, 1) * 8 * 1024;
+        (layout.battery ? layout.PRGNVRAMSize : layout.PRGRAMSize) = PRGRAMSize;
+        layout.timing = (RomHeader.flags9 & 0x01) ? TimingRegion::PAL : TimingRegion::NTSC;
+    }
+
+    /* Boards without CHR-ROM use CHR-RAM; assume 8 KB if the header does not size it */
+    if (layout.CHRROMSize == 0 && layout.CHRRAMSize + layout.CHRNVRAMSize == 0) {
+        layout.CHRRAMSize = 8 * 1024;
+    }
+}
+
+void Cartridge::initialise()
+{
+    /* No CHR-ROM: provide the CHR-RAM declared by the header */
+    if (CHRSize == 0) {
+        CHRROM.resize(layout.CHRRAMSize + layout.CHRNVRAMSize, 0);
+        CHRRAM = true;
+        CHRData = CHRROM.data();
+        CHRSize = CHRROM.size();
+    }
+
     // Instantiate the appropriate mapper
+    uint16_t mapperID = layout.mapperID;
+    Mirroring mirroring = layout.mirroring;
     switch (mapperID) {
         case 0:
-            mapper = std::make_unique<Mapper000>(RomHeader.PRGROM_size, RomHeader.CHRROM_size);
+            mapper = std::make_unique<Mapper000>(PRGData, PRGSize, CHRData, CHRSize, mirroring);
+            break;
+        case 1:
+            mapper = std::make_unique<Mapper001>(PRGData, PRGSize, CHRData, CHRSize, mirroring);
+            break;
+        case 2:
+            mapper = std::make_unique<Mapper002>(PRGData, PRGSize, CHRData, CHRSize, mirroring);
+            break;
+        case 3:
+            mapper = std::make_unique<Mapper003>(PRGData, PRGSize, CHRData, CHRSize, mirroring);
+            break;
+        case 4:
+            mapper = std::make_unique<Mapper004>(PRGData, PRGSize, CHRData, CHRSize, mirroring);
             break;
         default:
             throw std::runtime_error("Unsupported mapper: " + std::to_string(mapperID));
     }
 }
 
-uint8_t Cartridge::getMapperID() const
+void Cartridge::initialisePRGRAM(const std::string& filepath, SaveRAMMode saveMode)
 {
-    return mapperID;
+    /* One RAM chip in $6000-$7FFF: the battery-backed one if there is one */
+    PRGRAMSize = layout.PRGNVRAMSize ? layout.PRGNVRAMSize : layout.PRGRAMSize;
+    if (PRGRAMSize == 0) {
+        return;
+    }
+    PRGRAMSize = std::max<size_t>(PRGRAMSize, 256); // At least one CPU page
+
+    /* Battery-backed RAM is the .sav file itself where it can be mapped */
+    if (layout.PRGNVRAMSize && saveMode == SaveRAMMode::File) {
+        savePath = std::filesystem::path(filepath).replace_extension(".sav").string();
+    }
+    if (savePath.empty() || !mapSaveFile()) {
+        PRGRAM.assign(PRGRAMSize, 0);
+        PRGRAMData = PRGRAM.data();
+
+        std::ifstream file(savePath, std::ios::binary);
+        if (file) {
+            file.read(reinterpret_cast<char*>(PRGRAMData), PRGRAMSize);
+        }
+    }
+
+    /* The trainer is loaded at $7000 */
+    if (!trainer.empty() && PRGRAMSize >= 0x1000 + trainer.size()) {
+        std::memcpy(PRGRAMData + 0x1000, trainer.data(), trainer.size());
+    }
+}
+
+bool Cartridge::mapSaveFile()
+{
+#ifdef CARTRIDGE_HAVE_MMAP
+    /* 1. Open or create the save file and grow it to the RAM size */
+    int fd = open(savePath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0
+        || (fileStat.st_size < static_cast<off_t>(PRGRAMSize) && ftruncate(fd, PRGRAMSize) != 0)) {
+        close(fd);
+        return false;
+    }
+
+    /* 2. Map it shared: CPU writes land in the page cache with no copy or flush in the hot path */
+    void* address = mmap(nullptr, PRGRAMSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    saveMapping.address = address;
+    saveMapping.size = PRGRAMSize;
+    saveMapping.shared = true;
+    PRGRAMData = static_cast<uint8_t*>(address);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Cartridge::isMemoryMapped() const
+{
+    return mapping.address != nullptr;
+}
+
+const CartridgeLayout& Cartridge::getLayout() const
+{
+    return layout;
+}
+
+uint16_t Cartridge::getMapperID() const
+{
+    return layout.mapperID;
 }
 
 bool Cartridge::hasBatteryBackedRAM() const
 {
-    // TODO:
-    
-    return 1;
+    return layout.battery;
 }
 
 bool Cartridge::isFourScreenVRAM() const
 {
-    // TODO:
-    
-    return 1;
+    return layout.mirroring == Mirroring::FourScreen;
 }
 
 bool Cartridge::isVerticalMirroring() const
 {
-    // TODO:
-
-    return 1;
+    return layout.mirroring == Mirroring::Vertical;
 }
 
-uint8_t Cartridge::getPRGBankCount() const {
-    return RomHeader.PRGROM_size; // Already in 16 KB units
+size_t Cartridge::getPRGBankCount() const {
+    return layout.PRGROMSize / (16 * 1024);
 }
 
-uint8_t Cartridge::getCHRBankCount() const {
-    return RomHeader.CHRROM_size; // Already in 8 KB units
+size_t Cartridge::getCHRBankCount() const {
+    return layout.CHRROMSize / (8 * 1024);
 }
 
 uint8_t Cartridge::readPRGROM(uint16_t address) const {
-    uint16_t translatedAddr = mapper->translatePRGaddr(address);
-    if (translatedAddr >= PRGROM.size()) {
-        throw std::out_of_range("PRG-ROM access out of bounds.");
-    }
-    return PRGROM[translatedAddr];
+    return mapper->PRGWindow(address)[address & 0x1FFF];
 }
 
 uint8_t Cartridge::readCHRROM(uint16_t address) const {
-    uint16_t translatedAddr = mapper->translateCHRaddr(address);
-    if (translatedAddr >= CHRROM.size()) {
-        throw std::out_of_range("CHR-ROM access out of bounds.");
+    return mapper->CHRWindow(address)[address & 0x03FF];
+}
+
+void Cartridge::writeCHRRAM(uint16_t address, uint8_t data) {
+    if (!CHRRAM) {
+        return; // CHR-ROM is read-only
+    }
+    size_t offset = (mapper->CHRWindow(address) - CHRData) + (address & 0x03FF);
+    CHRROM[offset] = data;
+    if (tileCacheBuilt) {
+        tileCache.invalidate(CHRROM.data(), offset);
     }
-    return CHRROM[translatedAddr];
-}
\ No newline at end of file
+}
+
+void Cartridge::writeMapperRegister(uint16_t address, uint8_t data) {
+    mapper->writeRegister(address, data);
+}
+
+const std::array<const uint8_t*, 4>& Cartridge::getPRGWindows() const {
+    return mapper->getPRGWindows();
+}
+
+Mirroring Cartridge::getMirroring() const {
+    return mapper->getMirroring();
+}
+
+bool Cartridge::countsA12Rises() const {
+    return mapper->countsA12Rises();
+}
+
+bool Cartridge::notifyA12Rise() {
+    return mapper->notifyA12Rise();
+}
+
+bool Cartridge::isIRQAsserted() const {
+    return mapper->isIRQAsserted();
+}
+
+uint8_t* Cartridge::getPRGRAMPage(uint16_t address) {
+    if (!PRGRAMData || !mapper->isPRGRAMEnabled()) {
+        return nullptr;
+    }
+    return PRGRAMData + (((address & 0x1FFF) % PRGRAMSize) & ~size_t(0xFF));
+}
+
+uint8_t* Cartridge::getPRGRAMWritePage(uint16_t address) {
+    return mapper->isPRGRAMWritable() ? getPRGRAMPage(address) : nullptr;
+}
+
+void Cartridge::flushSaveRAM() {
+#ifdef CARTRIDGE_HAVE_MMAP
+    if (saveMapping.address) {
+        msync(saveMapping.address, saveMapping.size, MS_ASYNC);
+    }
+#endif
+}
+
+const uint8_t* Cartridge::getCHRTileRow(uint16_t address) const {
+    /* Decode all pattern table tiles on first use rather than at load */
+    if (!tileCacheBuilt) {
+        tileCache.build(CHRData, CHRSize);
+        tileCacheBuilt = true;
+    }
+    return tileCache.row((mapper->CHRWindow(address) - CHRData) + (address & 0x03FF));
+}
+
+uint64_t Cartridge::getROMHash() const {
+    /* Hash on first use rather than at load: a memory-mapped ROM is only read where the game reads it */
+    if (!ROMHashed) {
+        uint64_t hash = 14695981039346656037ull;
+        auto hashBytes = [&hash](const uint8_t* data, size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                hash = (hash ^ data[i]) * 1099511628211ull;
+            }
+        };
+        hashBytes(PRGData, PRGSize);
+        if (!CHRRAM) {
+            hashBytes(CHRData, CHRSize);
+        }
+        ROMHash = hash;
+        ROMHashed = true;
+    }
+    return ROMHash;
+}
+
+void Cartridge::saveState(SnapshotWriter& writer) const {
+    CartridgeIdentity identity{static_cast<uint32_t>(PRGSize), static_cast<uint32_t>(CHRSize),
+                               static_cast<uint32_t>(PRGRAMSize), layout.mapperID, CHRRAM, 0, getROMHash()};
+    MapperState mapperState;
+    mapper->saveState(mapperState);
+
+    writer.beginSection(CARTRIDGE_SECTION, CARTRIDGE_SECTION_VERSION);
+    writer.write(identity);
+    writer.write(mapperState);
+    writer.writeBytes(PRGRAMData, PRGRAMSize);
+    if (CHRRAM) {
+        writer.writeBytes(CHRROM.data(), CHRSize);
+    }
+    writer.endSection();
+}
+
+void Cartridge::loadState(SnapshotReader& reader) {
+    reader.beginSection(CARTRIDGE_SECTION, CARTRIDGE_SECTION_VERSION);
+
+    CartridgeIdentity identity;
+    reader.read(identity);
+    if (identity.PRGSize != PRGSize || identity.CHRSize != CHRSize || identity.PRGRAMSize != PRGRAMSize
+        || identity.mapperID != layout.mapperID || identity.CHRRAM != CHRRAM || identity.ROMHash != getROMHash()) {
+        throw std::runtime_error("Snapshot was taken from a different cartridge.");
+    }
+
+    MapperState mapperState;
+    reader.read(mapperState);
+    mapper->loadState(mapperState);
+    reader.readBytes(PRGRAMData, PRGRAMSize);
+
+    /* CHR-RAM: only re-decode the tiles that differ, usually none */
+    if (CHRRAM) {
+        const uint8_t* saved = reader.view(CHRSize);
+        for (size_t tile = 0; tile < CHRSize; tile += 16) {
+            if (std::memcmp(&CHRROM[tile], saved + tile, 16) == 0) {
+                continue;
+            }
+            for (size_t offset = tile; offset < tile + 16; ++offset) {
+                if (CHRROM[offset] != saved[offset]) {
+                    CHRROM[offset] = saved[offset];
+                    if (tileCacheBuilt) {
+                        tileCache.invalidate(CHRROM.data(), offset);
+                    }
+                }
+            }
+        }
+    }
+    reader.endSection();
+}
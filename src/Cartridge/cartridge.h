@@ -8,14 +8,17 @@
 
 #include "cartridge_types.h"
 #include "mapper.h"
+#include "chr_tile_cache.h"
 #include <string>
 #include <vector>
 #include <memory>
 
+class SnapshotWriter;
+class SnapshotReader;
+
 /*
- * NES Cartridge Memory Organization (iNES Format)
- * ------------------------------------------------
- * Note: NES 2.0 format is currently not supported.
+ * NES Cartridge Memory Organization (iNES / NES 2.0 Format)
+ * ---------------------------------------------------------
  *
  * Address Range    Description
  * --------------------------------------------------------------
@@ -35,8 +38,8 @@
  * 5      | 1    | CHR-ROM size in 8 KB units (0 if CHR-RAM is used)
  * 6      | 1    | Flags 6:
  *                  - Bit 0: Mirroring
- *                           0 = Vertical mirroring ("horizontal arrangement")
- *                           1 = Horizontal mirroring ("vertical arrangement")
+ *                           0 = Horizontal mirroring ("vertical arrangement")
+ *                           1 = Vertical mirroring ("horizontal arrangement")
  *                  - Bit 1: Cartridge contains battery-backed PRG-RAM ($6000–$7FFF) or other persistent memory
  *                  - Bit 2: Trainer (512 bytes) present at $7000–$71FF
  *                  - Bit 3: Four-screen VRAM layout
@@ -59,6 +62,16 @@
  *                  - Bits 2-3, 6-7: Unused (must be 0)
  * 11-15  | 5    | Reserved bytes (must be 0)
  *
+ * NES 2.0 Header (flags 7 bits 2-3 = 10), bytes 8-15:
+ * --------------------------------------------------------------
+ * 8      | 1    | Bits 0-3: Mapper ID bits 8-11; Bits 4-7: Submapper
+ * 9      | 1    | Bits 0-3: PRG-ROM size MSB; Bits 4-7: CHR-ROM size MSB
+ *                  (MSB $F: byte 4/5 is EEEEEEMM, size = 2^E * (MM * 2 + 1) bytes)
+ * 10     | 1    | Bits 0-3: PRG-RAM shift; Bits 4-7: PRG-NVRAM shift (size = 64 << shift, 0 = none)
+ * 11     | 1    | Bits 0-3: CHR-RAM shift; Bits 4-7: CHR-NVRAM shift
+ * 12     | 1    | Bits 0-1: Timing (0 NTSC, 1 PAL, 2 multi-region, 3 Dendy)
+ * 13-15  | 3    | VS System/extended console type, misc. ROMs, expansion device
+ *
  * PRG-ROM: Program data for the CPU, size defined by byte 4.
  * CHR-ROM: Graphics data for the PPU, size defined by byte 5 (if 0, CHR-RAM is used).
  */
@@ -77,35 +90,225 @@ public:
     Cartridge() = delete;
 
     /**
-     * @brief Destructor.
+     * @brief Destructor. Writes battery-backed PRG-RAM to the save file if it is not memory-mapped.
      */
-    ~Cartridge() = default;
+    ~Cartridge();
 
     /**
      * @brief Constructs a Cartridge instance from a file path.
+     *
+     * With RomLoadMode::MemoryMap the file is mapped read-only and PRG/CHR-ROM
+     * are used directly from the mapping, so loading costs only the header
+     * parse and identical ROMs opened in one process share their pages.
+     *
+     * Battery-backed PRG-RAM is kept in a .sav file next to the ROM unless
+     * saveMode is SaveRAMMode::Volatile.
+     *
      * @param filepath Path to the NES ROM file.
+     * @param mode How to load the file into memory.
+     * @param saveMode Whether battery-backed PRG-RAM persists in the save file.
+     */
+    explicit Cartridge(const std::string& filepath, RomLoadMode mode = RomLoadMode::Copy,
+                       SaveRAMMode saveMode = SaveRAMMode::File);
+
+    /**
+     * @brief Checks whether PRG/CHR-ROM are used in place from a file mapping.
+     * @return True if the ROM file is memory-mapped.
      */
-    explicit Cartridge(const std::string& filepath);
+    bool isMemoryMapped() const;
+
+    /**
+     * @brief Gets the memory layout decoded from the ROM header.
+     * @return The layout, fixed for the lifetime of the cartridge.
+     */
+    const CartridgeLayout& getLayout() const;
 
     // Metadata accessors
-    uint8_t getMapperID() const;
+    uint16_t getMapperID() const;
     bool hasBatteryBackedRAM() const;
     bool isFourScreenVRAM() const;
     bool isVerticalMirroring() const;
 
-    uint8_t getPRGBankCount() const;
-    uint8_t getCHRBankCount() const;
+    size_t getPRGBankCount() const;
+    size_t getCHRBankCount() const;
 
     // Memory access functions
     uint8_t readPRGROM(uint16_t address) const;
     uint8_t readCHRROM(uint16_t address) const;
 
+    /**
+     * @brief Writes to CHR memory if the cartridge uses CHR-RAM.
+     * @param address PPU address in $0000-$1FFF.
+     * @param data The byte to write. Ignored for CHR-ROM cartridges.
+     */
+    void writeCHRRAM(uint16_t address, uint8_t data);
+
+    /**
+     * @brief Forwards a CPU write in $8000-$FFFF to the mapper's registers.
+     * @param address CPU address in $8000-$FFFF.
+     * @param data The byte written.
+     */
+    void writeMapperRegister(uint16_t address, uint8_t data);
+
+    /**
+     * @brief Gets the base pointers of the mapper's four 8 KB PRG windows ($8000-$FFFF).
+     *
+     * The returned array is updated in place by bank switches and stays valid
+     * for the lifetime of the cartridge.
+     */
+    const std::array<const uint8_t*, 4>& getPRGWindows() const;
+
+    /**
+     * @brief Gets the nametable mirroring currently selected by the mapper.
+     */
+    Mirroring getMirroring() const;
+
+    /**
+     * @brief Returns true if the mapper needs PPU A12 rise notifications (scanline IRQ).
+     */
+    bool countsA12Rises() const;
+
+    /**
+     * @brief Reports a rising edge of PPU address line A12 to the mapper.
+     * @return True if the mapper asserts its IRQ.
+     */
+    bool notifyA12Rise();
+
+    /**
+     * @brief Returns true while the mapper asserts the CPU IRQ line.
+     */
+    bool isIRQAsserted() const;
+
+    /**
+     * @brief Returns a pointer to the 256-byte PRG-RAM page mapped at a CPU address.
+     *
+     * RAM smaller than 8 KB is mirrored through $6000-$7FFF.
+     *
+     * @param address CPU address in $6000-$7FFF.
+     * @return Pointer to the start of the page, or nullptr if the cartridge has no PRG-RAM or the mapper disabled it.
+     */
+    uint8_t* getPRGRAMPage(uint16_t address);
+
+    /**
+     * @brief Returns a pointer to the PRG-RAM page a CPU write at an address lands in.
+     * @param address CPU address in $6000-$7FFF.
+     * @return Pointer to the start of the page, or nullptr if writes there are dropped (no, disabled or protected PRG-RAM).
+     */
+    uint8_t* getPRGRAMWritePage(uint16_t address);
+
+    /**
+     * @brief Schedules battery-backed PRG-RAM to be written back to the save file.
+     *
+     * Cheap enough to call once per frame: a memory-mapped save file only
+     * needs an asynchronous msync, and without a mapping the RAM is written
+     * at destruction instead.
+     */
+    void flushSaveRAM();
+
+    /**
+     * @brief Returns a pre-decoded pattern table row mapped at a PPU address.
+     * @param address PPU address of the row's low bitplane byte in $0000-$1FFF.
+     * @return Pointer to 8 pixel colour values (0-3), left to right.
+     */
+    const uint8_t* getCHRTileRow(uint16_t address) const;
+
+    /**
+     * @brief Writes the mapper state, PRG-RAM and CHR-RAM to a snapshot section.
+     * @param writer The snapshot being written.
+     */
+    void saveState(SnapshotWriter& writer) const;
+
+    /**
+     * @brief Restores the section written by saveState().
+     *
+     * The section records the ROM's mapper and memory sizes; a snapshot of
+     * a different cartridge raises std::runtime_error before anything is
+     * modified.
+     *
+     * @param reader The snapshot being read.
+     */
+    void loadState(SnapshotReader& reader);
+
 private:
-    RomHeader RomHeader;               /**< Parsed ROM header. */
-    std::vector<uint8_t> PRGROM;       /**< PRG-ROM data. */
-    std::vector<uint8_t> CHRROM;       /**< CHR-ROM data. */
+    /**
+     * @brief Reads the ROM file into the PRGROM/CHRROM buffers.
+     * @param filepath Path to the NES ROM file.
+     */
+    void loadFile(const std::string& filepath);
+
+    /**
+     * @brief Maps the ROM file read-only and points PRG/CHR-ROM into the mapping.
+     * @param filepath Path to the NES ROM file.
+     * @return False if the file could not be mapped; the copying path is used instead.
+     */
+    bool mapFile(const std::string& filepath);
+
+    /**
+     * @brief Validates the raw header and decodes it into the layout.
+     *
+     * Both iNES and NES 2.0 headers are accepted. Throws on a bad magic
+     * number or a ROM size that cannot be represented.
+     */
+    void decodeHeader();
+
+    /**
+     * @brief Sets up CHR-RAM and the mapper once PRG/CHR data are in place.
+     */
+    void initialise();
+
+    /**
+     * @brief Allocates PRG-RAM, backed by the save file for battery carts.
+     * @param filepath Path to the NES ROM file; the save file replaces its extension with .sav.
+     * @param saveMode Whether battery-backed PRG-RAM uses the save file.
+     */
+    void initialisePRGRAM(const std::string& filepath, SaveRAMMode saveMode);
+
+    /**
+     * @brief Maps the save file shared and read-write as battery-backed PRG-RAM.
+     * @return False if the file could not be mapped; an in-process buffer is used instead.
+     */
+    bool mapSaveFile();
+
+    /**
+     * @brief Hashes PRG-ROM and CHR-ROM, once, so snapshots can tell ROMs of the same layout apart.
+     * @return FNV-1a hash of the ROM contents; CHR-RAM is not included.
+     */
+    uint64_t getROMHash() const;
+
+    /**
+     * @struct FileMapping
+     * @brief Owns a mapping of the ROM or save file, unmapped on destruction.
+     */
+    struct FileMapping {
+        void* address = nullptr; /**< Start of the mapping, or nullptr if not mapped. */
+        size_t size = 0;         /**< Size of the mapping in bytes. */
+        bool shared = false;     /**< Writes go to the file; synced before unmapping. */
+        FileMapping() = default;
+        FileMapping(const FileMapping&) = delete;
+        FileMapping& operator=(const FileMapping&) = delete;
+        ~FileMapping();
+    };
+
+    RomHeaderType RomHeader;           /**< Raw ROM header. */
+    CartridgeLayout layout;            /**< Layout decoded from RomHeader. */
+    std::vector<uint8_t> PRGROM;       /**< PRG-ROM data (copying path only). */
+    std::vector<uint8_t> CHRROM;       /**< CHR-ROM data (copying path), or CHR-RAM if the header declares no CHR-ROM. */
+    const uint8_t* PRGData = nullptr;  /**< PRG-ROM, in PRGROM or in the file mapping. */
+    size_t PRGSize = 0;                /**< PRG-ROM size in bytes. */
+    const uint8_t* CHRData = nullptr;  /**< CHR memory, in CHRROM or in the file mapping. */
+    size_t CHRSize = 0;                /**< CHR memory size in bytes. */
+    FileMapping mapping;               /**< Read-only mapping of the ROM file, if memory-mapped. */
+    bool CHRRAM = false;               /**< True if CHRROM holds writable CHR-RAM. */
+    mutable CHRTileCache tileCache;    /**< CHR data decoded to one byte per pixel, built on first use. */
+    mutable bool tileCacheBuilt = false; /**< True once tileCache has been built. */
+    mutable uint64_t ROMHash = 0;      /**< Hash of the ROM contents, computed on first use. */
+    mutable bool ROMHashed = false;    /**< True once ROMHash has been computed. */
     std::vector<uint8_t> trainer;      /**< Trainer data (if present). */
-    uint8_t mapperID;                  /**< Mapper ID parsed from the header. */
+    std::vector<uint8_t> PRGRAM;       /**< PRG-RAM buffer, unless the save file is memory-mapped. */
+    uint8_t* PRGRAMData = nullptr;     /**< PRG-RAM, in PRGRAM or in the save file mapping. */
+    size_t PRGRAMSize = 0;             /**< PRG-RAM size in bytes; 0 if absent. */
+    std::string savePath;              /**< Save file for battery-backed PRG-RAM, empty if none. */
+    FileMapping saveMapping;           /**< Shared mapping of the save file, if memory-mapped. */
     std::unique_ptr<Mapper> mapper;    /**< Mapper instance for address translation. */
 };
 
@@ -6,6 +6,7 @@
 #ifndef CARTRIDGE_TYPES_H
 #define CARTRIDGE_TYPES_H
 
+#include <cstddef>
 #include <cstdint>
 
 /**
@@ -13,20 +14,88 @@
  * @brief Represents the iNES ROM header as defined in the NES file format.
  *
  * This structure contains metadata about the NES cartridge, including ROM sizes,
- * mirroring type, and mapper ID.
+ * mirroring type, and mapper ID. Bytes 8-15 are interpreted differently by
+ * iNES and NES 2.0 headers; see Cartridge::decodeHeader().
  */
 struct RomHeaderType {
     char magic[4];        /**< Magic number "NES<EOF>" - Bytes 0-3. */
-    uint8_t PRGROM_size;  /**< Size of PRG ROM in 16 KB units - Byte 4. */
-    uint8_t CHRROM_size;  /**< Size of CHR ROM in 8 KB units - Byte 5. */
+    uint8_t PRGROM_size;  /**< Size of PRG ROM in 16 KB units (LSB in NES 2.0) - Byte 4. */
+    uint8_t CHRROM_size;  /**< Size of CHR ROM in 8 KB units (LSB in NES 2.0) - Byte 5. */
     uint8_t flags6;       /**< Mapper, mirroring, battery, trainer - Byte 6. */
     uint8_t flags7;       /**< Mapper, VS/Playchoice, NES 2.0 - Byte 7. */
-    uint8_t flags8;       /**< PRG-RAM size (rarely used extension) - Byte 8. */
-    uint8_t flags9;       /**< TV system (rarely used extension) - Byte 9. */
-    uint8_t flags10;      /**< TV system, PRG-RAM presence (unofficial) - Byte 10. */
-    uint8_t unused[5];    /**< Unused padding (should be zero) - Bytes 11-15. */
+    uint8_t flags8;       /**< iNES: PRG-RAM size. NES 2.0: mapper MSB and submapper - Byte 8. */
+    uint8_t flags9;       /**< iNES: TV system. NES 2.0: PRG/CHR-ROM size MSB - Byte 9. */
+    uint8_t flags10;      /**< iNES: TV system, PRG-RAM presence (unofficial). NES 2.0: PRG-RAM/NVRAM shift - Byte 10. */
+    uint8_t flags11;      /**< NES 2.0: CHR-RAM/NVRAM shift - Byte 11. */
+    uint8_t flags12;      /**< NES 2.0: CPU/PPU timing - Byte 12. */
+    uint8_t flags13;      /**< NES 2.0: VS System type or extended console type - Byte 13. */
+    uint8_t flags14;      /**< NES 2.0: Miscellaneous ROM count - Byte 14. */
+    uint8_t flags15;      /**< NES 2.0: Default expansion device - Byte 15. */
 } __attribute__((packed));
 
 using RomHeader = struct RomHeaderType;
 
+/**
+ * @brief Nametable arrangement selected by the cartridge.
+ */
+enum class Mirroring : uint8_t {
+    Horizontal,        /**< $2000/$2400 share one page, $2800/$2C00 the other. */
+    Vertical,          /**< $2000/$2800 share one page, $2400/$2C00 the other. */
+    SingleScreenLower, /**< All four nametables use the first page. */
+    SingleScreenUpper, /**< All four nametables use the second page. */
+    FourScreen         /**< Four separate nametables (extra VRAM on the cartridge). */
+};
+
+/**
+ * @enum TimingRegion
+ * @brief CPU/PPU timing the cartridge was made for.
+ */
+enum class TimingRegion : uint8_t {
+    NTSC,        /**< RP2C02 (North America, Japan). */
+    PAL,         /**< RP2C07 (Europe, Australia). */
+    MultiRegion, /**< Runs on either. */
+    Dendy        /**< UMC 6527P clones. */
+};
+
+/**
+ * @struct CartridgeLayout
+ * @brief Memory layout of a cartridge, decoded once from its iNES or NES 2.0 header.
+ *
+ * All sizes are in bytes. RAM sizes are split into volatile and
+ * battery-backed (NVRAM) parts; a size of zero means the memory is absent.
+ */
+struct CartridgeLayout {
+    bool NES20 = false;            /**< Header is in NES 2.0 format. */
+    uint16_t mapperID = 0;         /**< Mapper number (0-4095). */
+    uint8_t submapper = 0;         /**< Submapper number (NES 2.0 only, otherwise 0). */
+    size_t PRGROMSize = 0;         /**< PRG-ROM size. */
+    size_t CHRROMSize = 0;         /**< CHR-ROM size; 0 if the board uses CHR-RAM. */
+    size_t PRGRAMSize = 0;         /**< Volatile PRG-RAM at $6000-$7FFF. */
+    size_t PRGNVRAMSize = 0;       /**< Battery-backed PRG-RAM at $6000-$7FFF. */
+    size_t CHRRAMSize = 0;         /**< Volatile CHR-RAM. */
+    size_t CHRNVRAMSize = 0;       /**< Battery-backed CHR-RAM. */
+    Mirroring mirroring = Mirroring::Horizontal; /**< Nametable mirroring wired on the board. */
+    bool battery = false;          /**< Some memory is battery-backed. */
+    bool trainer = false;          /**< A 512-byte trainer precedes PRG-ROM in the file. */
+    TimingRegion timing = TimingRegion::NTSC; /**< CPU/PPU timing. */
+};
+
+/**
+ * @enum RomLoadMode
+ * @brief Selects how a Cartridge brings the ROM file into memory.
+ */
+enum class RomLoadMode : uint8_t {
+    Copy,      /**< Read the file into separately allocated PRG/CHR buffers. */
+    MemoryMap  /**< Map the file read-only and use PRG/CHR in place; falls back to Copy if mapping fails. */
+};
+
+/**
+ * @enum SaveRAMMode
+ * @brief Selects whether battery-backed PRG-RAM persists in a save file.
+ */
+enum class SaveRAMMode : uint8_t {
+    File,     /**< Load from and save to the .sav file next to the ROM. */
+    Volatile  /**< Start cleared and never touch the file (reproducible and parallel runs). */
+};
+
 #endif // CARTRIDGE_TYPES_H
@@ -0,0 +1,30 @@
+#include "chr_tile_cache.h"
+
+void CHRTileCache::build(const uint8_t* chr, size_t size)
+{
+    pixels.assign(size * 4, 0);
+
+    for (size_t tile = 0; tile < size; tile += 16) {
+        for (size_t y = 0; y < 8; ++y) {
+            decodeRow(chr, tile + y);
+        }
+    }
+}
+
+void CHRTileCache::invalidate(const uint8_t* chr, size_t offset)
+{
+    // Both bitplanes of a row decode into the same 8 pixels
+    decodeRow(chr, offset & ~size_t(0x08));
+}
+
+void CHRTileCache::decodeRow(const uint8_t* chr, size_t offset)
+{
+    uint8_t low = chr[offset];
+    uint8_t high = chr[offset + 8];
+    uint8_t* out = &pixels[((offset & ~size_t(0x0F)) << 2) | ((offset & 0x07) << 3)];
+
+    for (int x = 0; x < 8; ++x) {
+        int bit = 7 - x;
+        out[x] = ((low >> bit) & 0x01) | (((high >> bit) & 0x01) << 1);
+    }
+}
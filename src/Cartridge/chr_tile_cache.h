@@ -0,0 +1,61 @@
+/**
+ * @file chr_tile_cache.h
+ * @brief Defines the CHRTileCache class holding pre-decoded pattern table tiles.
+ */
+
+#ifndef CHR_TILE_CACHE_H
+#define CHR_TILE_CACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class CHRTileCache
+ * @brief Stores every 8x8 tile of CHR memory decoded to one byte per pixel.
+ *
+ * CHR data keeps each tile as two bitplanes (8 bytes low plane, then 8 bytes
+ * high plane). The cache combines them once, so fetching a tile row yields
+ * 8 ready 2-bit colour values (0-3) instead of two bytes to shift apart.
+ *
+ * The cache is indexed by offset into CHR memory, not by PPU address, so bank
+ * switching only changes which rows are looked up; only writes to CHR-RAM
+ * change the decoded data.
+ */
+class CHRTileCache {
+public:
+    /**
+     * @brief Decodes all tiles of a CHR memory image.
+     * @param chr Pointer to CHR memory.
+     * @param size Size of CHR memory in bytes (a multiple of 16).
+     */
+    void build(const uint8_t* chr, size_t size);
+
+    /**
+     * @brief Re-decodes the tile row affected by a write to CHR memory.
+     * @param chr Pointer to CHR memory, already containing the written byte.
+     * @param offset Offset of the written byte in CHR memory.
+     */
+    void invalidate(const uint8_t* chr, size_t offset);
+
+    /**
+     * @brief Gets a decoded tile row.
+     * @param offset Offset in CHR memory of the row's low bitplane byte.
+     * @return Pointer to the row's 8 pixels, left to right.
+     */
+    const uint8_t* row(size_t offset) const {
+        return &pixels[((offset & ~size_t(0x0F)) << 2) | ((offset & 0x07) << 3)];
+    }
+
+private:
+    /**
+     * @brief Decodes one tile row into the cache.
+     * @param chr Pointer to CHR memory.
+     * @param offset Offset of the row's low bitplane byte.
+     */
+    void decodeRow(const uint8_t* chr, size_t offset);
+
+    std::vector<uint8_t> pixels; /**< 64 bytes per tile: 8 rows of 8 pixels. */
+};
+
+#endif // CHR_TILE_CACHE_H
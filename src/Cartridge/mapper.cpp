@@ -3,24 +3,327 @@
 #include <stdexcept>
 
 /* Mapper */
-Mapper::Mapper(uint8_t nPRGBanks, uint8_t nCHRBanks) 
-    : nPRGBanks(nPRGBanks), nCHRBanks(nCHRBanks) {}
+Mapper::Mapper(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring)
+    : PRG(PRG), CHR(CHR), nPRGBanks(PRGSize / PRG_WINDOW_SIZE), nCHRBanks(CHRSize / CHR_WINDOW_SIZE), mirroring(mirroring)
+{
+    if (nPRGBanks == 0 || nCHRBanks == 0) {
+        throw std::runtime_error("Mapper requires PRG and CHR memory.");
+    }
+}
+
+void Mapper::writeRegister(uint16_t /*address*/, uint8_t /*data*/)
+{
+    // No registers: writes to ROM are ignored
+}
+
+void Mapper::saveState(MapperState& state) const
+{
+    state = MapperState{};
+    for (size_t i = 0; i < PRGBanks.size(); ++i) {
+        state.PRGOffsets[i] = static_cast<uint32_t>(PRGBanks[i] - PRG);
+    }
+    for (size_t i = 0; i < CHRBanks.size(); ++i) {
+        state.CHROffsets[i] = static_cast<uint32_t>(CHRBanks[i] - CHR);
+    }
+    state.mirroring = static_cast<uint8_t>(mirroring);
+}
+
+void Mapper::loadState(const MapperState& state)
+{
+    /* Validate every window before changing any, so a bad state leaves the mapper untouched */
+    for (uint32_t offset : state.PRGOffsets) {
+        if (offset > (nPRGBanks - 1) * PRG_WINDOW_SIZE) {
+            throw std::runtime_error("Mapper state has a PRG window outside PRG-ROM.");
+        }
+    }
+    for (uint32_t offset : state.CHROffsets) {
+        if (offset > (nCHRBanks - 1) * CHR_WINDOW_SIZE) {
+            throw std::runtime_error("Mapper state has a CHR window outside CHR memory.");
+        }
+    }
+    if (state.mirroring > static_cast<uint8_t>(Mirroring::FourScreen)) {
+        throw std::runtime_error("Mapper state has an invalid mirroring.");
+    }
+
+    for (size_t i = 0; i < PRGBanks.size(); ++i) {
+        PRGBanks[i] = PRG + state.PRGOffsets[i];
+    }
+    for (size_t i = 0; i < CHRBanks.size(); ++i) {
+        CHRBanks[i] = CHR + state.CHROffsets[i];
+    }
+    mirroring = static_cast<Mirroring>(state.mirroring);
+}
+
+void Mapper::mapPRG8K(int window, size_t bank)
+{
+    PRGBanks[window] = PRG + (bank % nPRGBanks) * PRG_WINDOW_SIZE;
+}
+
+void Mapper::mapPRG16K(int window, size_t bank)
+{
+    mapPRG8K(window, bank * 2);
+    mapPRG8K(window + 1, bank * 2 + 1);
+}
+
+void Mapper::mapCHR1K(int window, size_t bank)
+{
+    CHRBanks[window] = CHR + (bank % nCHRBanks) * CHR_WINDOW_SIZE;
+}
+
+void Mapper::mapCHR4K(int window, size_t bank)
+{
+    for (int i = 0; i < 4; ++i) {
+        mapCHR1K(window + i, bank * 4 + i);
+    }
+}
+
+void Mapper::mapCHR8K(size_t bank)
+{
+    for (int i = 0; i < 8; ++i) {
+        mapCHR1K(i, bank * 8 + i);
+    }
+}
 
 
 /* Mapper000 */
-Mapper000::Mapper000(uint8_t nPRGBanks, uint8_t nCHRBanks)
-                : Mapper(nPRGBanks, nCHRBanks) {}
+Mapper000::Mapper000(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring)
+                : Mapper(PRG, PRGSize, CHR, CHRSize, mirroring)
+{
+    // 32 KB maps straight through; 16 KB wraps so $C000 mirrors $8000
+    for (int window = 0; window < 4; ++window) {
+        mapPRG8K(window, window);
+    }
+    mapCHR8K(0);
+}
+
+
+/* Mapper001 */
+Mapper001::Mapper001(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring)
+                : Mapper(PRG, PRGSize, CHR, CHRSize, mirroring)
+{
+    updateBanks();
+}
+
+void Mapper001::writeRegister(uint16_t address, uint8_t data)
+{
+    /* Bit 7 resets the shift register and fixes the last PRG bank at $C000 */
+    if (data & 0x80) {
+        shiftRegister = 0x10;
+        control |= 0x0C;
+        updateBanks();
+        return;
+    }
+
+    /* Shift in bit 0, LSB first; the marker bit reaching bit 0 means this is the fifth write */
+    bool complete = shiftRegister & 0x01;
+    shiftRegister = (shiftRegister >> 1) | ((data & 0x01) << 4);
+    if (!complete) {
+        return;
+    }
+
+    switch ((address >> 13) & 0x03) {
+        case 0: control = shiftRegister; break;  // $8000 - $9FFF
+        case 1: CHRBank0 = shiftRegister; break; // $A000 - $BFFF
+        case 2: CHRBank1 = shiftRegister; break; // $C000 - $DFFF
+        case 3: PRGBank = shiftRegister; break;  // $E000 - $FFFF
+    }
+    shiftRegister = 0x10;
+    updateBanks();
+}
+
+void Mapper001::saveState(MapperState& state) const
+{
+    Mapper::saveState(state);
+    state.registers[0] = shiftRegister;
+    state.registers[1] = control;
+    state.registers[2] = CHRBank0;
+    state.registers[3] = CHRBank1;
+    state.registers[4] = PRGBank;
+}
+
+void Mapper001::loadState(const MapperState& state)
+{
+    Mapper::loadState(state);
+    shiftRegister = state.registers[0];
+    control = state.registers[1];
+    CHRBank0 = state.registers[2];
+    CHRBank1 = state.registers[3];
+    PRGBank = state.registers[4];
+}
+
+void Mapper001::updateBanks()
+{
+    static constexpr Mirroring MIRRORING[4] = {
+        Mirroring::SingleScreenLower, Mirroring::SingleScreenUpper, Mirroring::Vertical, Mirroring::Horizontal
+    };
+    mirroring = MIRRORING[control & 0x03];
+
+    /* 512 KB boards (SUROM) use CHR bank 0 bit 4 to select the 256 KB PRG half */
+    size_t outer = (nPRGBanks > 32) ? (CHRBank0 & 0x10) : 0;
+    size_t bank = outer | (PRGBank & 0x0F);
+
+    switch ((control >> 2) & 0x03) {
+        case 0:
+        case 1: // 32 KB at $8000, low bit of the bank number ignored
+            mapPRG16K(0, bank & ~size_t(1));
+            mapPRG16K(2, bank | 1);
+            break;
+        case 2: // First bank fixed at $8000, 16 KB switchable at $C000
+            mapPRG16K(0, outer);
+            mapPRG16K(2, bank);
+            break;
+        case 3: // 16 KB switchable at $8000, last bank fixed at $C000
+            mapPRG16K(0, bank);
+            mapPRG16K(2, outer | 0x0F);
+            break;
+    }
+
+    if (control & 0x10) {
+        mapCHR4K(0, CHRBank0);
+        mapCHR4K(4, CHRBank1);
+    } else {
+        mapCHR8K(CHRBank0 >> 1);
+    }
+}
+
+
+/* Mapper002 */
+Mapper002::Mapper002(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring)
+                : Mapper(PRG, PRGSize, CHR, CHRSize, mirroring)
+{
+    mapPRG16K(0, 0);
+    mapPRG16K(2, nPRGBanks / 2 - 1);
+    mapCHR8K(0);
+}
 
-uint16_t Mapper000::translatePRGaddr(uint16_t address) const
+void Mapper002::writeRegister(uint16_t /*address*/, uint8_t data)
 {
-    // normalize address + BANK1 mirroring handle
-    uint32_t offset = (address - 0x8000) % (nPRGBanks * 16 * 1024);
-    return offset;
+    mapPRG16K(0, data);
 }
 
-uint16_t Mapper000::translateCHRaddr(uint16_t address) const
+
+/* Mapper003 */
+Mapper003::Mapper003(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring)
+                : Mapper(PRG, PRGSize, CHR, CHRSize, mirroring)
 {
-    // Normalize the address for CHR-ROM or CHR-RAM
-    uint32_t offset = address % (nCHRBanks * 8 * 1024); // CHR-ROM size in bytes
-    return offset;
+    for (int window = 0; window < 4; ++window) {
+        mapPRG8K(window, window);
+    }
+    mapCHR8K(0);
+}
+
+void Mapper003::writeRegister(uint16_t /*address*/, uint8_t data)
+{
+    mapCHR8K(data);
+}
+
+
+/* Mapper004 */
+Mapper004::Mapper004(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring)
+                : Mapper(PRG, PRGSize, CHR, CHRSize, mirroring), bankRegisters{0, 2, 4, 5, 6, 7, 0, 1}
+{
+    updateBanks();
+}
+
+void Mapper004::writeRegister(uint16_t address, uint8_t data)
+{
+    /* Registers are selected by the 8 KB region and whether the address is even or odd */
+    switch (address & 0xE001) {
+        case 0x8000: // Bank select
+            bankSelect = data;
+            updateBanks();
+            break;
+        case 0x8001: // Bank data
+            bankRegisters[bankSelect & 0x07] = data;
+            updateBanks();
+            break;
+        case 0xA000: // Mirroring; hard-wired on four-screen boards
+            if (mirroring != Mirroring::FourScreen) {
+                mirroring = (data & 0x01) ? Mirroring::Horizontal : Mirroring::Vertical;
+            }
+            break;
+        case 0xA001: // PRG-RAM enable and write protect
+            PRGRAMProtect = data & 0xC0;
+            break;
+        case 0xC000: // IRQ latch
+            IRQLatch = data;
+            break;
+        case 0xC001: // IRQ reload: the counter is reloaded at the next A12 rise
+            IRQCounter = 0;
+            IRQReload = true;
+            break;
+        case 0xE000: // IRQ disable and acknowledge
+            IRQEnabled = false;
+            IRQPending = false;
+            break;
+        case 0xE001: // IRQ enable
+            IRQEnabled = true;
+            break;
+    }
+}
+
+bool Mapper004::notifyA12Rise()
+{
+    if (IRQCounter == 0 || IRQReload) {
+        IRQCounter = IRQLatch;
+        IRQReload = false;
+    } else {
+        IRQCounter--;
+    }
+    if (IRQCounter == 0 && IRQEnabled) {
+        IRQPending = true;
+        return true;
+    }
+    return false;
+}
+
+void Mapper004::saveState(MapperState& state) const
+{
+    Mapper::saveState(state);
+    for (size_t i = 0; i < bankRegisters.size(); ++i) {
+        state.registers[i] = bankRegisters[i];
+    }
+    state.registers[8] = bankSelect;
+    state.registers[9] = IRQLatch;
+    state.registers[10] = IRQCounter;
+    state.registers[11] = IRQReload;
+    state.registers[12] = IRQEnabled;
+    state.registers[13] = PRGRAMProtect;
+    state.registers[14] = IRQPending;
+}
+
+void Mapper004::loadState(const MapperState& state)
+{
+    Mapper::loadState(state);
+    for (size_t i = 0; i < bankRegisters.size(); ++i) {
+        bankRegisters[i] = state.registers[i];
+    }
+    bankSelect = state.registers[8];
+    IRQLatch = state.registers[9];
+    IRQCounter = state.registers[10];
+    IRQReload = state.registers[11] != 0;
+    IRQEnabled = state.registers[12] != 0;
+    PRGRAMProtect = state.registers[13] & 0xC0;
+    IRQPending = state.registers[14] != 0;
+}
+
+void Mapper004::updateBanks()
+{
+    /* CHR: two 2 KB banks (R0, R1) and four 1 KB banks (R2-R5); inversion swaps the halves */
+    int low = (bankSelect & 0x80) ? 4 : 0;
+    int high = low ^ 4;
+    mapCHR1K(low + 0, bankRegisters[0] & 0xFE);
+    mapCHR1K(low + 1, bankRegisters[0] | 0x01);
+    mapCHR1K(low + 2, bankRegisters[1] & 0xFE);
+    mapCHR1K(low + 3, bankRegisters[1] | 0x01);
+    for (int i = 0; i < 4; ++i) {
+        mapCHR1K(high + i, bankRegisters[2 + i]);
+    }
+
+    /* PRG: R6 and the second-last bank swap between $8000 and $C000; the last bank is fixed at $E000 */
+    int swappable = (bankSelect & 0x40) ? 2 : 0;
+    mapPRG8K(swappable, bankRegisters[6] & 0x3F);
+    mapPRG8K(swappable ^ 2, nPRGBanks - 2);
+    mapPRG8K(1, bankRegisters[7] & 0x3F);
+    mapPRG8K(3, nPRGBanks - 1);
 }
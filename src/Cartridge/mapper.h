@@ -6,20 +6,50 @@
 #ifndef MAPPER_H
 #define MAPPER_H
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include "cartridge_types.h"
+
+/**
+ * @struct MapperState
+ * @brief Snapshot of a mapper: its bank windows, mirroring and board-specific registers.
+ *
+ * Windows are stored as offsets into PRG and CHR memory rather than as
+ * pointers, so a state can be loaded into another instance of the same
+ * cartridge.
+ */
+struct MapperState {
+    uint32_t PRGOffsets[4];  /**< Offsets of the PRG windows into PRG-ROM. */
+    uint32_t CHROffsets[8];  /**< Offsets of the CHR windows into CHR memory. */
+    uint8_t mirroring;       /**< Current Mirroring. */
+    uint8_t registers[15];   /**< Board registers, laid out by each mapper. */
+};
 
 /**
  * @class Mapper
- * @brief Base class for NES mappers, handling address translation for PRG and CHR data.
+ * @brief Base class for NES mappers, publishing the PRG and CHR banks currently mapped.
+ *
+ * A mapper divides the CPU cartridge space $8000-$FFFF into four 8 KB PRG
+ * windows and the PPU pattern table space $0000-$1FFF into eight 1 KB CHR
+ * windows, and keeps a base pointer for each window. Readers index these
+ * pointers directly; the mapper only recomputes them when one of its
+ * registers is written.
  */
 class Mapper {
 public:
+    static constexpr size_t PRG_WINDOW_SIZE = 8 * 1024; /**< Size of a PRG window in bytes. */
+    static constexpr size_t CHR_WINDOW_SIZE = 1024;     /**< Size of a CHR window in bytes. */
+
     /**
-     * @brief Constructs a Mapper with the given PRG and CHR bank counts.
-     * @param nPRGBanks Number of PRG-ROM banks.
-     * @param nCHRBanks Number of CHR-ROM banks.
+     * @brief Constructs a Mapper over the cartridge's PRG and CHR memory.
+     * @param PRG Pointer to PRG-ROM.
+     * @param PRGSize PRG-ROM size in bytes (a multiple of 8 KB).
+     * @param CHR Pointer to CHR-ROM or CHR-RAM.
+     * @param CHRSize CHR memory size in bytes (a multiple of 1 KB).
+     * @param mirroring Nametable mirroring selected by the cartridge header.
      */
-    Mapper(uint8_t nPRGBanks, uint8_t nCHRBanks);
+    Mapper(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring);
 
     /**
      * @brief Virtual destructor for the base class.
@@ -27,22 +57,130 @@ public:
     virtual ~Mapper() = default;
 
     /**
-     * @brief Translates a PRG-ROM address.
+     * @brief Handles a CPU write to the cartridge space ($8000-$FFFF).
+     *
+     * Bank-switching mappers override this to update their registers and
+     * bank pointers. The default ignores the write, as for ROM.
+     *
      * @param address The CPU-visible address.
-     * @return The mapped address within PRG-ROM.
+     * @param data The byte written.
+     */
+    virtual void writeRegister(uint16_t address, uint8_t data);
+
+    /**
+     * @brief Returns true if the mapper counts rising edges of PPU address line A12.
+     *
+     * The PPU only reports A12 rises (see notifyA12Rise()) to mappers that
+     * return true here.
+     */
+    virtual bool countsA12Rises() const { return false; }
+
+    /**
+     * @brief Reports a rising edge of PPU address line A12 (once per rendered scanline).
+     * @return True if the mapper asserts its IRQ as a result.
+     */
+    virtual bool notifyA12Rise() { return false; }
+
+    /**
+     * @brief Returns true while the mapper holds the CPU IRQ line low, i.e. until the IRQ is acknowledged.
      */
-    virtual uint16_t translatePRGaddr(uint16_t address) const = 0;
+    virtual bool isIRQAsserted() const { return false; }
 
     /**
-     * @brief Translates a CHR-ROM address.
-     * @param address The PPU-visible address.
-     * @return The mapped address within CHR-ROM.
+     * @brief Returns true if PRG-RAM at $6000-$7FFF responds; otherwise reads are open bus.
      */
-    virtual uint16_t translateCHRaddr(uint16_t address) const = 0;
+    virtual bool isPRGRAMEnabled() const { return true; }
+
+    /**
+     * @brief Returns true if PRG-RAM accepts writes.
+     */
+    virtual bool isPRGRAMWritable() const { return true; }
+
+    /**
+     * @brief Captures the bank windows and mirroring; mappers with registers also store those.
+     * @param state Receives the state.
+     */
+    virtual void saveState(MapperState& state) const;
+
+    /**
+     * @brief Restores a state captured by saveState() on the same cartridge.
+     *
+     * Offsets outside PRG or CHR memory raise std::runtime_error.
+     *
+     * @param state The state.
+     */
+    virtual void loadState(const MapperState& state);
+
+    /**
+     * @brief Gets the nametable mirroring currently selected.
+     */
+    Mirroring getMirroring() const { return mirroring; }
+
+    /**
+     * @brief Gets the base pointers of the four PRG windows.
+     *
+     * The array lives as long as the mapper, so callers may keep a pointer
+     * to it and see bank switches without being notified.
+     */
+    const std::array<const uint8_t*, 4>& getPRGWindows() const { return PRGBanks; }
+
+    /**
+     * @brief Gets the PRG window mapped at a CPU address.
+     * @param address CPU address in $8000-$FFFF.
+     * @return Base pointer of the 8 KB window; index it with (address & 0x1FFF).
+     */
+    const uint8_t* PRGWindow(uint16_t address) const { return PRGBanks[(address >> 13) & 0x03]; }
+
+    /**
+     * @brief Gets the CHR window mapped at a PPU address.
+     * @param address PPU address in $0000-$1FFF.
+     * @return Base pointer of the 1 KB window; index it with (address & 0x03FF).
+     */
+    const uint8_t* CHRWindow(uint16_t address) const { return CHRBanks[(address >> 10) & 0x07]; }
 
 protected:
-    uint8_t nPRGBanks; /**< Number of PRG-ROM banks. */
-    uint8_t nCHRBanks; /**< Number of CHR-ROM banks. */
+    /**
+     * @brief Maps an 8 KB PRG bank into a window.
+     * @param window Window index (0-3 for $8000, $A000, $C000, $E000).
+     * @param bank 8 KB bank number; wraps around the PRG-ROM size.
+     */
+    void mapPRG8K(int window, size_t bank);
+
+    /**
+     * @brief Maps a 16 KB PRG bank into two consecutive windows.
+     * @param window First window index (0 for $8000, 2 for $C000).
+     * @param bank 16 KB bank number; wraps around the PRG-ROM size.
+     */
+    void mapPRG16K(int window, size_t bank);
+
+    /**
+     * @brief Maps a 1 KB CHR bank into a window.
+     * @param window Window index (0-7 for $0000-$1C00).
+     * @param bank 1 KB bank number; wraps around the CHR size.
+     */
+    void mapCHR1K(int window, size_t bank);
+
+    /**
+     * @brief Maps a 4 KB CHR bank into four consecutive windows.
+     * @param window First window index (0 for $0000, 4 for $1000).
+     * @param bank 4 KB bank number; wraps around the CHR size.
+     */
+    void mapCHR4K(int window, size_t bank);
+
+    /**
+     * @brief Maps an 8 KB CHR bank into all eight windows.
+     * @param bank 8 KB bank number; wraps around the CHR size.
+     */
+    void mapCHR8K(size_t bank);
+
+    const uint8_t* PRG; /**< PRG-ROM. */
+    const uint8_t* CHR; /**< CHR-ROM or CHR-RAM. */
+    size_t nPRGBanks;   /**< Number of 8 KB PRG banks. */
+    size_t nCHRBanks;   /**< Number of 1 KB CHR banks. */
+    Mirroring mirroring; /**< Current nametable mirroring. */
+
+    std::array<const uint8_t*, 4> PRGBanks{}; /**< Base pointers of the PRG windows. */
+    std::array<const uint8_t*, 8> CHRBanks{}; /**< Base pointers of the CHR windows. */
 };
 
 /**
@@ -53,13 +191,160 @@ class Mapper000 : public Mapper {
 public:
     /**
      * @brief Constructs a Mapper000 instance.
-     * @param nPRGBanks Number of PRG-ROM banks.
-     * @param nCHRBanks Number of CHR-ROM banks.
+     *
+     * 16 KB PRG-ROMs are mirrored into $C000-$FFFF.
+     *
+     * @param PRG Pointer to PRG-ROM.
+     * @param PRGSize PRG-ROM size in bytes.
+     * @param CHR Pointer to CHR memory.
+     * @param CHRSize CHR memory size in bytes.
+     * @param mirroring Nametable mirroring from the header.
      */
-    Mapper000(uint8_t nPRGBanks, uint8_t nCHRBanks);
+    Mapper000(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring);
+};
+
+/**
+ * @class Mapper001
+ * @brief MMC1 (SxROM): serially loaded registers, switchable 16/32 KB PRG and 4/8 KB CHR banks.
+ */
+class Mapper001 : public Mapper {
+public:
+    /**
+     * @brief Constructs a Mapper001 instance in its power-on state (last PRG bank fixed at $C000).
+     * @param PRG Pointer to PRG-ROM.
+     * @param PRGSize PRG-ROM size in bytes.
+     * @param CHR Pointer to CHR memory.
+     * @param CHRSize CHR memory size in bytes.
+     * @param mirroring Nametable mirroring from the header.
+     */
+    Mapper001(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring);
+
+    /**
+     * @brief Shifts one bit into the serial port; the fifth write loads the register selected by the address.
+     * @param address The CPU-visible address.
+     * @param data The byte written; bit 7 resets the shift register, bit 0 is the data bit.
+     */
+    void writeRegister(uint16_t address, uint8_t data) override;
+
+    void saveState(MapperState& state) const override;
+    void loadState(const MapperState& state) override;
+
+private:
+    /** @brief Recomputes the bank pointers and mirroring from the registers. */
+    void updateBanks();
+
+    uint8_t shiftRegister = 0x10; // Bit 4 set marks an empty shift register
+    uint8_t control = 0x0C;       // Mirroring (bits 0-1), PRG mode (bits 2-3), CHR mode (bit 4)
+    uint8_t CHRBank0 = 0;
+    uint8_t CHRBank1 = 0;
+    uint8_t PRGBank = 0;
+};
+
+/**
+ * @class Mapper002
+ * @brief UxROM: switchable 16 KB PRG bank at $8000, last bank fixed at $C000.
+ */
+class Mapper002 : public Mapper {
+public:
+    /**
+     * @brief Constructs a Mapper002 instance.
+     * @param PRG Pointer to PRG-ROM.
+     * @param PRGSize PRG-ROM size in bytes.
+     * @param CHR Pointer to CHR memory.
+     * @param CHRSize CHR memory size in bytes.
+     * @param mirroring Nametable mirroring from the header.
+     */
+    Mapper002(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring);
+
+    /**
+     * @brief Selects the 16 KB PRG bank at $8000.
+     * @param address The CPU-visible address.
+     * @param data The bank number.
+     */
+    void writeRegister(uint16_t address, uint8_t data) override;
+};
+
+/**
+ * @class Mapper003
+ * @brief CNROM: fixed PRG, switchable 8 KB CHR bank.
+ */
+class Mapper003 : public Mapper {
+public:
+    /**
+     * @brief Constructs a Mapper003 instance.
+     * @param PRG Pointer to PRG-ROM.
+     * @param PRGSize PRG-ROM size in bytes.
+     * @param CHR Pointer to CHR memory.
+     * @param CHRSize CHR memory size in bytes.
+     * @param mirroring Nametable mirroring from the header.
+     */
+    Mapper003(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring);
+
+    /**
+     * @brief Selects the 8 KB CHR bank.
+     * @param address The CPU-visible address.
+     * @param data The bank number.
+     */
+    void writeRegister(uint16_t address, uint8_t data) override;
+};
+
+/**
+ * @class Mapper004
+ * @brief MMC3 (TxROM): 8 KB PRG and 1/2 KB CHR banks with a scanline IRQ counter.
+ *
+ * The IRQ counter is clocked by rising edges of PPU A12, which the PPU
+ * reports once per rendered scanline through notifyA12Rise(); the IRQ it
+ * raises stays asserted until a write to $E000. $A001 enables
+ * PRG-RAM (bit 7) and write-protects it (bit 6); it powers up enabled and
+ * writable. The MMC6 variant of that register is not modelled.
+ */
+class Mapper004 : public Mapper {
+public:
+    /**
+     * @brief Constructs a Mapper004 instance.
+     * @param PRG Pointer to PRG-ROM.
+     * @param PRGSize PRG-ROM size in bytes.
+     * @param CHR Pointer to CHR memory.
+     * @param CHRSize CHR memory size in bytes.
+     * @param mirroring Nametable mirroring from the header.
+     */
+    Mapper004(const uint8_t* PRG, size_t PRGSize, const uint8_t* CHR, size_t CHRSize, Mirroring mirroring);
+
+    /**
+     * @brief Handles the bank select/data, mirroring and IRQ register pairs.
+     * @param address The CPU-visible address; bits 13-14 and bit 0 select the register.
+     * @param data The byte written.
+     */
+    void writeRegister(uint16_t address, uint8_t data) override;
+
+    bool countsA12Rises() const override { return true; }
+
+    /**
+     * @brief Clocks the scanline counter, reloading it from the latch when it is zero.
+     * @return True if the counter reached zero with the IRQ enabled.
+     */
+    bool notifyA12Rise() override;
+
+    bool isIRQAsserted() const override { return IRQPending; }
+
+    bool isPRGRAMEnabled() const override { return PRGRAMProtect & 0x80; }
+    bool isPRGRAMWritable() const override { return (PRGRAMProtect & 0xC0) == 0x80; }
+
+    void saveState(MapperState& state) const override;
+    void loadState(const MapperState& state) override;
+
+private:
+    /** @brief Recomputes the bank pointers from the bank registers and mode bits. */
+    void updateBanks();
 
-    uint16_t translatePRGaddr(uint16_t address) const override;
-    uint16_t translateCHRaddr(uint16_t address) const override;
+    std::array<uint8_t, 8> bankRegisters{}; // R0-R7
+    uint8_t bankSelect = 0;                 // Register index (bits 0-2), PRG mode (bit 6), CHR inversion (bit 7)
+    uint8_t IRQLatch = 0;
+    uint8_t IRQCounter = 0;
+    bool IRQReload = false;
+    bool IRQEnabled = false;
+    bool IRQPending = false;                // IRQ asserted, until acknowledged by $E000
+    uint8_t PRGRAMProtect = 0x80;           // $A001: PRG-RAM enable (bit 7), write protect (bit 6)
 };
 
 #endif // MAPPER_H
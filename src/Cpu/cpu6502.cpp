@@ -1,25 +1,77 @@
 #include "cpu6502.h"
 #include "cpu6502_memory_map.h"
 #include "cpu6502_opcodes.h"
+#include "config.h"
+#include "snapshot.h"
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
-#include <iostream>
+#include <limits>
 #include <chrono>
 #include <thread>
 
+/* Registers of the CPU snapshot section, in a fixed layout */
+struct CPUState {
+    uint64_t instructionCount;
+    uint16_t PC;
+    uint16_t cycles;
+    uint8_t A;
+    uint8_t X;
+    uint8_t Y;
+    uint8_t SP;
+    uint8_t P;
+    uint8_t statusReg;
+    uint8_t nmiPending;
+    uint8_t irqPending;
+    uint8_t reserved[4];
+};
+
+static constexpr uint32_t CPU_SECTION = sectionID("CPU ");
+static constexpr uint32_t CPU_SECTION_VERSION = 1;
+
+/* Longest jump back that may close an idle loop, i.e. largest loop body in bytes */
+static constexpr uint16_t IDLE_LOOP_MAX_BYTES = 16;
+
 CPU6502::CPU6502(std::shared_ptr<BusInterface> bus)
-    : WRAM(2 * 1024, 0), A(0), X(0), Y(0), SP(0xFD), PC(0), P(0x34), busInterface(bus) {}
+    : WRAM(2 * 1024, 0), A(0), X(0), Y(0), SP(0xFD), PC(0), P(0x34), busInterface(bus) {
+    if constexpr (DECODE_CACHE) {
+        blockCache.resize(BLOCK_CACHE_SIZE);
+    }
+    mapMemoryPages();
+}
 
 void CPU6502::setFlag(StatusFlag flag, bool value) {
-    if (value) {
-        statusReg |= static_cast<uint8_t>(flag);
-    } else {
-        statusReg &= ~static_cast<uint8_t>(flag);
+    switch (flag) {
+        case StatusFlag::CARRY_FLAG:
+            flagCarry = value;
+            break;
+        case StatusFlag::OVERFLOW_FLAG:
+            flagOverflow = value ? 0x80 : 0x00;
+            break;
+        case StatusFlag::ZERO_FLAG: // Rebuild the result so that N is kept
+            flagResult = (value ? 0x0000 : 0x0001) | (getFlag(StatusFlag::NEGATIVE_FLAG) ? 0x8000 : 0x0000);
+            break;
+        case StatusFlag::NEGATIVE_FLAG: // Rebuild the result so that Z is kept
+            flagResult = (getFlag(StatusFlag::ZERO_FLAG) ? 0x0000 : 0x0001) | (value ? 0x8000 : 0x0000);
+            break;
+        default:
+            if (value) {
+                statusReg |= static_cast<uint8_t>(flag);
+            } else {
+                statusReg &= ~static_cast<uint8_t>(flag);
+            }
+            break;
     }
 }
 
 bool CPU6502::getFlag(StatusFlag flag) const {
-    return (statusReg & static_cast<uint8_t>(flag)) != 0;
+    switch (flag) {
+        case StatusFlag::CARRY_FLAG:    return flagCarry != 0;
+        case StatusFlag::ZERO_FLAG:     return (flagResult & 0xFF) == 0;
+        case StatusFlag::OVERFLOW_FLAG: return (flagOverflow & 0x80) != 0;
+        case StatusFlag::NEGATIVE_FLAG: return ((flagResult | flagResult >> 8) & 0x80) != 0;
+        default:                        return (statusReg & static_cast<uint8_t>(flag)) != 0;
+    }
 }
 
 
@@ -51,7 +103,12 @@ void CPU6502::reset()
     X = 0;    // Clear X Register
     Y = 0;    // Clear Y Register
     SP = 0xFD; // Reset Stack Pointer to default
-    statusReg = 0x34; // Set default status register (IRQ disabled)
+    setStatusRegister(0x34); // Set default status register (IRQ disabled)
+    cycles = 0; // Drop any instruction in flight
+    idleLoop = IdleLoop{}; // Forget the loop being watched
+
+    // Rebuild the page table against the current cartridge banks
+    mapMemoryPages();
 
     // Fetch the reset vector (little-endian)
     uint8_t lo = read(0xFFFC);
@@ -62,6 +119,10 @@ void CPU6502::reset()
         static_cast<uint8_t>(StatusFlag::UNUSED_FLAG);
 }
 
+void CPU6502::setTraceSink(std::shared_ptr<TraceSink> sink) {
+    traceSink = sink;
+}
+
 void CPU6502::triggerNMI() {
     nmiPending = true;
 }
@@ -70,428 +131,1016 @@ void CPU6502::triggerIRQ() {
     irqPending = true;
 }
 
-/* Execute single instruction */
+bool CPU6502::pollIRQ() {
+    irqPending = busInterface->isIRQAsserted();
+    return irqPending;
+}
+
+/* Execute single CPU cycle */
 void CPU6502::step() {
     if (cycles > 0) {
         --cycles; // Decrement remaining cycles for the current instruction
         return;
     }
 
+    runInstruction();
+    --cycles; // Account for the current cycle spent fetching
+}
+
+uint32_t CPU6502::runCycles(uint32_t budget) {
+    uint32_t executed = 0;
+
+    // Catch the PPU up with an instruction left in flight by step()
+    if (cycles > 0) {
+        executed = cycles;
+        cycles = 0;
+        if (busInterface->clockPPU(executed)) {
+            return executed;
+        }
+    }
+
+    while (executed < budget) {
+        uint16_t start = PC;
+        uint16_t instructionCycles = runInstruction();
+        cycles = 0;
+        executed += instructionCycles;
+
+        // Advance the PPU by the whole instruction at once
+        if (busInterface->clockPPU(instructionCycles)) {
+            break; // Frame completed
+        }
+
+        // A short jump back may close a loop waiting on PPUSTATUS or WRAM
+        if constexpr (IDLE_LOOP_SKIP) {
+            if (static_cast<uint16_t>(start - PC) < IDLE_LOOP_MAX_BYTES && executed < budget) {
+                uint32_t idleCycles = skipIdleLoop(start, budget - executed);
+                executed += idleCycles;
+                if (idleCycles && busInterface->clockPPU(idleCycles)) {
+                    break;
+                }
+            }
+        }
+    }
+
+    return executed;
+}
+
+uint32_t CPU6502::runUntilFrame() {
+    return runCycles(std::numeric_limits<uint32_t>::max());
+}
+
+/* Effective address of an idle loop operand, with the registers as they stay while the loop idles */
+static uint16_t idleOperandAddress(AddressingMode mode, uint16_t operand, uint8_t X, uint8_t Y) {
+    switch (mode) {
+        case AddressingMode::ZeroPageX: return (operand + X) & 0xFF;
+        case AddressingMode::ZeroPageY: return (operand + Y) & 0xFF;
+        case AddressingMode::AbsoluteX: return static_cast<uint16_t>(operand + X);
+        case AddressingMode::AbsoluteY: return static_cast<uint16_t>(operand + Y);
+        default:                        return operand;
+    }
+}
+
+bool CPU6502::decodeIdleLoop() {
+    uint16_t address = idleLoop.head;
+    uint8_t length = 0;
+    idleLoop.readsPPUStatus = false;
+
+    /* 1. Body: straight-line loads, compares, bit tests and register transfers */
+    while (address != idleLoop.tail) {
+        const OpcodeInfo& info = OPCODE_TABLE[peek(address)];
+        switch (info.instruction) {
+            case Instruction::LDA: case Instruction::LDX: case Instruction::LDY:
+            case Instruction::CMP: case Instruction::CPX: case Instruction::CPY:
+            case Instruction::AND: case Instruction::ORA: case Instruction::EOR: case Instruction::BIT:
+            case Instruction::TAX: case Instruction::TAY: case Instruction::TXA: case Instruction::TYA:
+            case Instruction::CLC: case Instruction::SEC: case Instruction::CLV: case Instruction::NOP:
+                break;
+            default:
+                return false;
+        }
+
+        uint16_t operand = 0;
+        uint8_t size;
+        switch (info.addressingMode) {
+            case AddressingMode::Implied:
+            case AddressingMode::Accumulator:
+                size = 1;
+                break;
+            case AddressingMode::Immediate:
+            case AddressingMode::ZeroPage:
+            case AddressingMode::ZeroPageX:
+            case AddressingMode::ZeroPageY:
+                operand = peek(address + 1);
+                size = 2;
+                break;
+            case AddressingMode::Absolute:
+            case AddressingMode::AbsoluteX:
+            case AddressingMode::AbsoluteY:
+                operand = peek(address + 1) | peek(address + 2) << 8;
+                size = 3;
+                break;
+            default:
+                return false; // Indirect modes read through pointers; keep the check simple
+        }
+
+        /* Reads must have no side effects: memory (WRAM, PRG-RAM, PRG-ROM) or PPUSTATUS, whose read only clears flags */
+        if (size > 1 && info.addressingMode != AddressingMode::Immediate && info.instruction != Instruction::NOP) {
+            uint16_t target = idleOperandAddress(info.addressingMode, operand, X, Y);
+            if (target >= PPU_REGISTERS_STARTADDR && target < PPU_MIRRORS_ENDADDR && (target & 0x07) == 0x02) {
+                idleLoop.readsPPUStatus = true;
+            } else if (target >= WRAM_MIRRORS_ENDADDR && target < CARTRIDGE_ROM_STARTADDR && !readPages[target >> 8]) {
+                return false;
+            }
+        }
+
+        address += size;
+        if (static_cast<uint16_t>(idleLoop.tail - address) >= IDLE_LOOP_MAX_BYTES) {
+            return false; // Stepped over the tail
+        }
+        length++;
+    }
+
+    /* 2. Tail: a branch or an absolute jump back to the head */
+    const OpcodeInfo& info = OPCODE_TABLE[peek(address)];
+    uint16_t target;
+    if (info.addressingMode == AddressingMode::Relative) {
+        target = address + 2 + static_cast<int8_t>(peek(address + 1));
+    } else if (info.instruction == Instruction::JMP && info.addressingMode == AddressingMode::Absolute) {
+        target = peek(address + 1) | peek(address + 2) << 8;
+    } else {
+        return false;
+    }
+    idleLoop.length = length + 1;
+    return target == idleLoop.head;
+}
+
+uint32_t CPU6502::skipIdleLoop(uint16_t tail, uint32_t budget) {
+    /* Pending interrupts are taken before the next pass, and a trace must see every instruction */
+    if (nmiPending || (irqPending && !getFlag(StatusFlag::INTERRUPT_DISABLE_FLAG) && pollIRQ())) {
+        return 0;
+    }
+    if constexpr (VERBOSE) {
+        if (traceSink) {
+            return 0;
+        }
+    }
+
+    uint64_t now = busInterface->getCPUCycle();
+    bool sameLoop = idleLoop.head == PC && idleLoop.tail == tail;
+    if (sameLoop && !idleLoop.idle) {
+        return 0; // Already known to have effects
+    }
+
+    /* A pass of the watched loop, not interrupted and before any event, that left the registers unchanged */
+    bool unchanged = sameLoop && instructionCount - idleLoop.instructionCount == idleLoop.length &&
+                     now < idleLoop.horizon && A == idleLoop.A && X == idleLoop.X && Y == idleLoop.Y &&
+                     getStatusRegister() == idleLoop.status;
+
+    if (!unchanged) {
+        /* A new loop, or new registers: decode and watch it from here (operand addresses depend on X and Y) */
+        idleLoop.head = PC;
+        idleLoop.tail = tail;
+        idleLoop.idle = decodeIdleLoop();
+        idleLoop.passes = 0;
+        idleLoop.horizon = busInterface->nextEventCPUCycle(idleLoop.readsPPUStatus);
+    } else if (idleLoop.passes > 0) {
+        /*
+         * The first unchanged pass applied the side effects of the body's reads (PPUSTATUS flags
+         * cleared), and the second found the same registers and read the same values: every further
+         * pass before the horizon does the same. Skip them, ending before the horizon and the budget
+         * so that the next pass runs as normal.
+         */
+        uint64_t period = now - idleLoop.cycle;
+        uint64_t count = std::min((idleLoop.horizon - 1 - now) / period, (budget - 1) / period);
+        instructionCount += count * idleLoop.length;
+        idleLoop.instructionCount = instructionCount;
+        idleLoop.cycle = now + count * period;
+        return static_cast<uint32_t>(count * period);
+    } else {
+        idleLoop.passes++;
+    }
+
+    idleLoop.instructionCount = instructionCount;
+    idleLoop.cycle = now;
+    idleLoop.A = A;
+    idleLoop.X = X;
+    idleLoop.Y = Y;
+    idleLoop.status = getStatusRegister();
+    return 0;
+}
+
+/* Execute single instruction or interrupt sequence */
+uint16_t CPU6502::runInstruction() {
+    cycles = 0;
+
     // Check for pending interrupts
     if (nmiPending) {
         handleInterrupt(0xFFFA); // Handle NMI using its vector
         nmiPending = false; // Clear the NMI pending flag
-    } else if (irqPending && !getFlag(StatusFlag::INTERRUPT_DISABLE_FLAG)) {
-        handleInterrupt(0xFFFE); // Handle IRQ using its vector
-        irqPending = false; // Clear the IRQ pending flag
+    } else if (irqPending && !getFlag(StatusFlag::INTERRUPT_DISABLE_FLAG) && pollIRQ()) {
+        handleInterrupt(0xFFFE); // Handle IRQ using its vector; the line stays asserted until the handler acknowledges it
     } else {
 
-        uint8_t opcode = read(PC);
+        // Opcode and operand bytes come decoded; the handler only advances PC over the operand
+        const DecodedInstruction& decoded = fetchInstruction();
         ++PC;
+        ++instructionCount;
+        operand = decoded.operand;
 
-        const OpcodeInfo& info = OPCODE_TABLE[opcode];
+        // Record the instruction in the trace sink (compiled out unless VERBOSE)
+        if constexpr (VERBOSE) {
+            if (traceSink) {
+                traceSink->record({static_cast<uint16_t>(PC - 1), decoded.opcode, A, X, Y, SP, getStatusRegister()});
+            }
+        }
 
-        std::stringstream ss;
-        ss << "Executing instruction: 0x" << std::hex << std::uppercase
-        << static_cast<int>(opcode);
-        std::cout << ss.str() << std::endl;
+        // Set the base cycle count; handlers add page-crossing and branch penalties
+        cycles = decoded.cycles;
 
-        // Handle the instruction (execution logic here)
         // Execute the instruction
-        switch (info.instruction) {
-            // Load/Store Operations
-            case Instruction::LDA: // Load Accumulator
-                executeLDA(info.addressingMode);
-                break;
-            case Instruction::LDX: // Load X Register
-                executeLDX(info.addressingMode);
-                break;
-            case Instruction::LDY: // Load Y Register
-                executeLDY(info.addressingMode);
-                break;
-            case Instruction::STA: // Store Accumulator
-                executeSTA(info.addressingMode);
-                break;
-            case Instruction::STX: // Store X Register
-                executeSTX(info.addressingMode);
-                break;
-            case Instruction::SAX: // Store X Register
-                executeSAX(info.addressingMode);
-                break;
-            case Instruction::STY: // Store Y Register
-                executeSTY(info.addressingMode);
-                break;
+        if constexpr (TABLE_DISPATCH) {
+            decoded.handler(*this);
+        } else {
+            dispatchSwitch(OPCODE_TABLE[decoded.opcode]);
+        }
+    }
 
-            // Register Transfers
-            case Instruction::TAX: // Transfer Accumulator to X
-                executeTAX();
-                break;
-            case Instruction::TXA: // Transfer X to Accumulator
-                executeTXA();
-                break;
-            case Instruction::TAY: // Transfer Accumulator to Y
-                executeTAY();
-                break;
-            case Instruction::TYA: // Transfer Y to Accumulator
-                executeTYA();
-                break;
+    return cycles;
+}
 
-            // Stack Operations
-            case Instruction::TSX: // Transfer Stack Pointer to X
-                executeTSX();
-                break;
-            case Instruction::TXS: // Transfer X to Stack Pointer
-                executeTXS();
-                break;
-            case Instruction::PHA: // Push Accumulator
-                executePHA();
-                break;
-            case Instruction::PLA: // Pull Accumulator
-                executePLA();
-                break;
-            case Instruction::PHP: // Push Processor Status
-                executePHP();
-                break;
-            case Instruction::PLP: // Pull Processor Status
-                executePLP();
-                break;
+/* Instruction size in bytes, opcode included */
+static constexpr uint8_t instructionLength(AddressingMode mode) {
+    switch (mode) {
+        case AddressingMode::Implied:
+        case AddressingMode::Accumulator:
+        case AddressingMode::INVALID:
+            return 1;
+        case AddressingMode::Absolute:
+        case AddressingMode::AbsoluteX:
+        case AddressingMode::AbsoluteY:
+        case AddressingMode::Indirect:
+            return 3;
+        default:
+            return 2;
+    }
+}
 
-            // Logical Operations
-            case Instruction::AND: // Logical AND
-                executeAND(info.addressingMode);
-                break;
-            case Instruction::ORA: // Logical OR
-                executeORA(info.addressingMode);
-                break;
-            case Instruction::EOR: // Exclusive OR
-                executeEOR(info.addressingMode);
-                break;
+/* Instructions after which execution does not simply continue with the next address */
+static constexpr bool endsBlock(Instruction instruction) {
+    switch (instruction) {
+        case Instruction::BCC: case Instruction::BCS: case Instruction::BEQ: case Instruction::BMI:
+        case Instruction::BNE: case Instruction::BPL: case Instruction::BVC: case Instruction::BVS:
+        case Instruction::JMP: case Instruction::JSR: case Instruction::RTS: case Instruction::RTI:
+        case Instruction::BRK: case Instruction::INVALID:
+            return true;
+        default:
+            return false;
+    }
+}
 
-            // Arithmetic Operations
-            case Instruction::ADC: // Add with Carry
-                executeADC(info.addressingMode);
-                break;
-            case Instruction::SBC: // Subtract with Carry
-                executeSBC(info.addressingMode);
-                break;
-            case Instruction::CMP: // Compare Accumulator
-                executeCMP(info.addressingMode);
-                break;
-            case Instruction::CPX: // Compare X Register
-                executeCPX(info.addressingMode);
-                break;
-            case Instruction::CPY: // Compare Y Register
-                executeCPY(info.addressingMode);
-                break;
+const CPU6502::DecodedInstruction& CPU6502::fetchInstruction() {
+    /* 1. Next instruction of the block being executed */
+    if constexpr (DECODE_CACHE) {
+        if (currentBlock && PC == blockNextPC && blockIndex < currentBlock->count) {
+            const DecodedInstruction& instruction = currentBlock->instructions[blockIndex++];
+            blockNextPC += instruction.length;
+            return instruction;
+        }
 
-            // Increment/Decrement Operations
-            case Instruction::INC: // Increment Memory
-                executeINC(info.addressingMode);
-                break;
-            case Instruction::INX: // Increment X Register
-                executeINX();
-                break;
-            case Instruction::INY: // Increment Y Register
-                executeINY();
-                break;
-            case Instruction::DEC: // Decrement Memory
-                executeDEC(info.addressingMode);
-                break;
-            case Instruction::DEX: // Decrement X Register
-                executeDEX();
-                break;
-            case Instruction::DEY: // Decrement Y Register
-                executeDEY();
-                break;
+        /* 2. Host address of the code: the current bank's PRG window, or a RAM page other than the zero page */
+        const uint8_t* code = nullptr;
+        if (PC >= CARTRIDGE_ROM_STARTADDR) {
+            code = (*PRGWindows)[(PC >> 13) & 0x03] + (PC & 0x1FFF);
+        } else if (readPages[PC >> 8] && (PC >= WRAM_MIRRORS_ENDADDR || (PC & 0x07FF) >= 0x100)) {
+            code = readPages[PC >> 8] + (PC & 0xFF);
+        }
 
-            // Shifts
-            case Instruction::ASL: // Arithmetic Shift Left
-                executeASL(info.addressingMode);
-                break;
-            case Instruction::LSR: // Logical Shift Right
-                executeLSR(info.addressingMode);
-                break;
-            case Instruction::ROL: // Rotate Left
-                executeROL(info.addressingMode);
-                break;
-            case Instruction::ROR: // Rotate Right
-                executeROR(info.addressingMode);
-                break;
-            case Instruction::SLO: // Rotate Right
-                executeSLO(info.addressingMode);
-                break;
+        /* 3. Cached block starting at PC, decoded again if its slot holds another one or its page changed */
+        if (code) {
+            DecodedBlock& block = blockCache[(PC ^ (PC >> 11)) & (BLOCK_CACHE_SIZE - 1)];
+            if ((block.code == code && block.address == PC && block.generation == pageGeneration[PC >> 8]) ||
+                decodeBlock(block, code)) {
+                currentBlock = &block;
+                blockIndex = 1;
+                blockNextPC = PC + block.instructions[0].length;
+                return block.instructions[0];
+            }
+        }
+        currentBlock = nullptr;
+    }
 
-            // Control Flow
-            case Instruction::JMP: // Jump
-                executeJMP(info.addressingMode);
-                break;
-            case Instruction::JSR: // Jump to Subroutine
-                executeJSR();
-                break;
-            case Instruction::RTS: // Return from Subroutine
-                executeRTS();
-                break;
-            case Instruction::RTI: // Return from Interrupt
-                executeRTI();
-                break;
+    /* 4. Uncached: decode through the memory map */
+    uint8_t opcode = read(PC);
+    const OpcodeInfo& info = OPCODE_TABLE[opcode];
+    uint8_t length = instructionLength(info.addressingMode);
+    uint16_t operandBytes = 0;
+    if (length > 1) {
+        operandBytes = read(PC + 1);
+    }
+    if (length > 2) {
+        operandBytes |= read(PC + 2) << 8;
+    }
+    uncached = {DISPATCH_TABLE[opcode], operandBytes, opcode, info.cycles, length};
+    return uncached;
+}
 
-            // Branching
-            case Instruction::BCC: // Branch if Carry Clear
-                executeBCC();
-                break;
-            case Instruction::BCS: // Branch if Carry Set
-                executeBCS();
-                break;
-            case Instruction::BEQ: // Branch if Equal
-                executeBEQ();
-                break;
-            case Instruction::BMI: // Branch if Minus
-                executeBMI();
-                break;
-            case Instruction::BNE: // Branch if Not Equal
-                executeBNE();
-                break;
-            case Instruction::BPL: // Branch if Positive
-                executeBPL();
-                break;
-            case Instruction::BVC: // Branch if Overflow Clear
-                executeBVC();
-                break;
-            case Instruction::BVS: // Branch if Overflow Set
-                executeBVS();
-                break;
-            case Instruction::BIT:
-                executeBIT(info.addressingMode);
-                break;
-                
-            // System Functions
-            case Instruction::CLC: // Clear Carry Flag
-                executeCLC();
-                break;
-            case Instruction::SEC: // Set Carry Flag
-                executeSEC();
-                break;
-            case Instruction::CLI: // Clear Interrupt Disable
-                executeCLI();
-                break;
-            case Instruction::SEI: // Set Interrupt Disable
-                executeSEI();
-                break;
-            case Instruction::CLD: // Clear Decimal Mode
-                executeCLD();
-                break;
-            case Instruction::SED: // Set Decimal Mode
-                executeSED();
-                break;
-            case Instruction::CLV: // Clear Overflow Flag
-                executeCLV();
-                break;
-            case Instruction::DCP:
-                executeDCP(info.addressingMode);
-                break;
-            case Instruction::RLA: // Force Break
-                executeRLA(info.addressingMode);
-                break;
-            // Break/No-op
-            case Instruction::BRK: // Force Break
-                executeBRK();
-                break;
-            case Instruction::NOP: // No Operation
-                executeNOP(info.addressingMode);
-                break;
+bool CPU6502::decodeBlock(DecodedBlock& block, const uint8_t* code) {
+    size_t room = 0x100 - (PC & 0xFF);                                 // Bytes left in the page
+    size_t lineRoom = BLOCK_LINE_SIZE - (PC & (BLOCK_LINE_SIZE - 1));  // Bytes left in the line
+    size_t offset = 0;
 
-            case Instruction::ISC: // No Operation
-                executeISC(info.addressingMode);
-                break;
+    /* Instructions starting in the line; the last may run into the next line, but not the next page */
+    block.count = 0;
+    while (offset < lineRoom) {
+        uint8_t opcode = code[offset];
+        const OpcodeInfo& info = OPCODE_TABLE[opcode];
+        uint8_t length = instructionLength(info.addressingMode);
+        if (offset + length > room) {
+            break; // Continues in the next page, which may be another bank
+        }
 
-            case Instruction::RRA: // No Operation
-                executeRRA(info.addressingMode);
-                break;
+        uint16_t operandBytes = 0;
+        if (length > 1) {
+            operandBytes = code[offset + 1];
+        }
+        if (length > 2) {
+            operandBytes |= code[offset + 2] << 8;
+        }
+        block.instructions[block.count++] = {DISPATCH_TABLE[opcode], operandBytes, opcode, info.cycles, length};
 
-            case Instruction::LAX: // No Operation
-                executeLAX(info.addressingMode);
-                break;
+        offset += length;
+        if (endsBlock(info.instruction)) {
+            break;
+        }
+    }
+    if (block.count == 0) {
+        block.code = nullptr;
+        return false;
+    }
 
-            case Instruction::TAS:
-                executeTAS(info.addressingMode);
-                break;
+    block.code = code;
+    block.address = PC;
+    block.generation = pageGeneration[PC >> 8];
+
+    /* Code in RAM: route writes to the page and its mirrors through write() so they invalidate the block */
+    if (PC < CARTRIDGE_ROM_STARTADDR) {
+        const uint8_t* page = readPages[PC >> 8];
+        for (int mirror = 0; mirror < (CARTRIDGE_ROM_STARTADDR >> 8); ++mirror) {
+            if (readPages[mirror] == page) {
+                codePages[mirror] = true;
+                writePages[mirror] = nullptr;
+            }
+        }
+    }
+    return true;
+}
 
-            case Instruction::ANC:
-                executeANC(info.addressingMode);
-                break;
+void CPU6502::invalidateCode(uint8_t page) {
+    const uint8_t* code = readPages[page];
+    for (int mirror = 0; mirror < (CARTRIDGE_ROM_STARTADDR >> 8); ++mirror) {
+        if (readPages[mirror] == code) {
+            codePages[mirror] = false;
+            pageGeneration[mirror]++;
+            mapMemoryPage(mirror);
+        }
+    }
+    currentBlock = nullptr;
+}
 
-            case Instruction::ALR:
-                executeALR(info.addressingMode);
-                break;
+uint8_t CPU6502::fetchOperand() {
+    uint8_t value = operand & 0xFF;
+    operand >>= 8;
+    ++PC;
+    return value;
+}
 
-            case Instruction::ARR:
-                executeARR(info.addressingMode);
-                break;
+/* Legacy dispatch: decode the instruction through a switch at run time */
+void CPU6502::dispatchSwitch(const OpcodeInfo& info) {
+    switch (info.instruction) {
+        // Load/Store Operations
+        case Instruction::LDA: // Load Accumulator
+            dispatchMode<Instruction::LDA>(info.addressingMode);
+            break;
+        case Instruction::LDX: // Load X Register
+            dispatchMode<Instruction::LDX>(info.addressingMode);
+            break;
+        case Instruction::LDY: // Load Y Register
+            dispatchMode<Instruction::LDY>(info.addressingMode);
+            break;
+        case Instruction::STA: // Store Accumulator
+            dispatchMode<Instruction::STA>(info.addressingMode);
+            break;
+        case Instruction::STX: // Store X Register
+            dispatchMode<Instruction::STX>(info.addressingMode);
+            break;
+        case Instruction::SAX: // Store X Register
+            dispatchMode<Instruction::SAX>(info.addressingMode);
+            break;
+        case Instruction::STY: // Store Y Register
+            dispatchMode<Instruction::STY>(info.addressingMode);
+            break;
 
-            case Instruction::XAA:
-                executeXAA(info.addressingMode);
-                break;
+        // Register Transfers
+        case Instruction::TAX: // Transfer Accumulator to X
+            executeTAX();
+            break;
+        case Instruction::TXA: // Transfer X to Accumulator
+            executeTXA();
+            break;
+        case Instruction::TAY: // Transfer Accumulator to Y
+            executeTAY();
+            break;
+        case Instruction::TYA: // Transfer Y to Accumulator
+            executeTYA();
+            break;
 
-            case Instruction::AHX:
-                executeAHX(info.addressingMode);
-                break;
+        // Stack Operations
+        case Instruction::TSX: // Transfer Stack Pointer to X
+            executeTSX();
+            break;
+        case Instruction::TXS: // Transfer X to Stack Pointer
+            executeTXS();
+            break;
+        case Instruction::PHA: // Push Accumulator
+            executePHA();
+            break;
+        case Instruction::PLA: // Pull Accumulator
+            executePLA();
+            break;
+        case Instruction::PHP: // Push Processor Status
+            executePHP();
+            break;
+        case Instruction::PLP: // Pull Processor Status
+            executePLP();
+            break;
 
-            case Instruction::LAS:
-                executeLAS(info.addressingMode);
-                break;
+        // Logical Operations
+        case Instruction::AND: // Logical AND
+            dispatchMode<Instruction::AND>(info.addressingMode);
+            break;
+        case Instruction::ORA: // Logical OR
+            dispatchMode<Instruction::ORA>(info.addressingMode);
+            break;
+        case Instruction::EOR: // Exclusive OR
+            dispatchMode<Instruction::EOR>(info.addressingMode);
+            break;
 
-            case Instruction::SHX:
-                executeSHX(info.addressingMode);
-                break;
+        // Arithmetic Operations
+        case Instruction::ADC: // Add with Carry
+            dispatchMode<Instruction::ADC>(info.addressingMode);
+            break;
+        case Instruction::SBC: // Subtract with Carry
+            dispatchMode<Instruction::SBC>(info.addressingMode);
+            break;
+        case Instruction::CMP: // Compare Accumulator
+            dispatchMode<Instruction::CMP>(info.addressingMode);
+            break;
+        case Instruction::CPX: // Compare X Register
+            dispatchMode<Instruction::CPX>(info.addressingMode);
+            break;
+        case Instruction::CPY: // Compare Y Register
+            dispatchMode<Instruction::CPY>(info.addressingMode);
+            break;
 
-            case Instruction::SRE:
-                executeSRE(info.addressingMode);
-                break;
+        // Increment/Decrement Operations
+        case Instruction::INC: // Increment Memory
+            dispatchMode<Instruction::INC>(info.addressingMode);
+            break;
+        case Instruction::INX: // Increment X Register
+            executeINX();
+            break;
+        case Instruction::INY: // Increment Y Register
+            executeINY();
+            break;
+        case Instruction::DEC: // Decrement Memory
+            dispatchMode<Instruction::DEC>(info.addressingMode);
+            break;
+        case Instruction::DEX: // Decrement X Register
+            executeDEX();
+            break;
+        case Instruction::DEY: // Decrement Y Register
+            executeDEY();
+            break;
 
-            case Instruction::SHY:
-                executeSHY(info.addressingMode);
-                break;
+        // Shifts
+        case Instruction::ASL: // Arithmetic Shift Left
+            dispatchMode<Instruction::ASL>(info.addressingMode);
+            break;
+        case Instruction::LSR: // Logical Shift Right
+            dispatchMode<Instruction::LSR>(info.addressingMode);
+            break;
+        case Instruction::ROL: // Rotate Left
+            dispatchMode<Instruction::ROL>(info.addressingMode);
+            break;
+        case Instruction::ROR: // Rotate Right
+            dispatchMode<Instruction::ROR>(info.addressingMode);
+            break;
+        case Instruction::SLO: // Rotate Right
+            dispatchMode<Instruction::SLO>(info.addressingMode);
+            break;
 
-            case Instruction::AXS:
-                executeAXS(info.addressingMode);
-                break;
+        // Control Flow
+        case Instruction::JMP: // Jump
+            dispatchMode<Instruction::JMP>(info.addressingMode);
+            break;
+        case Instruction::JSR: // Jump to Subroutine
+            executeJSR();
+            break;
+        case Instruction::RTS: // Return from Subroutine
+            executeRTS();
+            break;
+        case Instruction::RTI: // Return from Interrupt
+            executeRTI();
+            break;
 
-            // Default case for unimplemented or invalid instructions
-            default:
-                throw std::runtime_error("Unimplemented instruction: 0x" +
-                            [&]() -> std::string {
-                                std::stringstream ss;
-                                ss << std::hex << std::uppercase << static_cast<int>(info.instruction);
-                                return ss.str();
-                            }());
-        }
+        // Branching
+        case Instruction::BCC: // Branch if Carry Clear
+            executeBCC();
+            break;
+        case Instruction::BCS: // Branch if Carry Set
+            executeBCS();
+            break;
+        case Instruction::BEQ: // Branch if Equal
+            executeBEQ();
+            break;
+        case Instruction::BMI: // Branch if Minus
+            executeBMI();
+            break;
+        case Instruction::BNE: // Branch if Not Equal
+            executeBNE();
+            break;
+        case Instruction::BPL: // Branch if Positive
+            executeBPL();
+            break;
+        case Instruction::BVC: // Branch if Overflow Clear
+            executeBVC();
+            break;
+        case Instruction::BVS: // Branch if Overflow Set
+            executeBVS();
+            break;
+        case Instruction::BIT:
+            dispatchMode<Instruction::BIT>(info.addressingMode);
+            break;
+            
+        // System Functions
+        case Instruction::CLC: // Clear Carry Flag
+            executeCLC();
+            break;
+        case Instruction::SEC: // Set Carry Flag
+            executeSEC();
+            break;
+        case Instruction::CLI: // Clear Interrupt Disable
+            executeCLI();
+            break;
+        case Instruction::SEI: // Set Interrupt Disable
+            executeSEI();
+            break;
+        case Instruction::CLD: // Clear Decimal Mode
+            executeCLD();
+            break;
+        case Instruction::SED: // Set Decimal Mode
+            executeSED();
+            break;
+        case Instruction::CLV: // Clear Overflow Flag
+            executeCLV();
+            break;
+        case Instruction::DCP:
+            dispatchMode<Instruction::DCP>(info.addressingMode);
+            break;
+        case Instruction::RLA: // Force Break
+            dispatchMode<Instruction::RLA>(info.addressingMode);
+            break;
+        // Break/No-op
+        case Instruction::BRK: // Force Break
+            executeBRK();
+            break;
+        case Instruction::NOP: // No Operation
+            dispatchMode<Instruction::NOP>(info.addressingMode);
+            break;
+
+        case Instruction::ISC: // No Operation
+            dispatchMode<Instruction::ISC>(info.addressingMode);
+            break;
+
+        case Instruction::RRA: // No Operation
+            dispatchMode<Instruction::RRA>(info.addressingMode);
+            break;
 
-        // Set the cycle count for the current instruction
-        cycles = info.cycles - 1; // Account for the current cycle spent fetching
+        case Instruction::LAX: // No Operation
+            dispatchMode<Instruction::LAX>(info.addressingMode);
+            break;
+
+        case Instruction::TAS:
+            dispatchMode<Instruction::TAS>(info.addressingMode);
+            break;
+
+        case Instruction::ANC:
+            dispatchMode<Instruction::ANC>(info.addressingMode);
+            break;
+
+        case Instruction::ALR:
+            dispatchMode<Instruction::ALR>(info.addressingMode);
+            break;
+
+        case Instruction::ARR:
+            dispatchMode<Instruction::ARR>(info.addressingMode);
+            break;
+
+        case Instruction::XAA:
+            dispatchMode<Instruction::XAA>(info.addressingMode);
+            break;
+
+        case Instruction::AHX:
+            dispatchMode<Instruction::AHX>(info.addressingMode);
+            break;
+
+        case Instruction::LAS:
+            dispatchMode<Instruction::LAS>(info.addressingMode);
+            break;
+
+        case Instruction::SHX:
+            dispatchMode<Instruction::SHX>(info.addressingMode);
+            break;
+
+        case Instruction::SRE:
+            dispatchMode<Instruction::SRE>(info.addressingMode);
+            break;
+
+        case Instruction::SHY:
+            dispatchMode<Instruction::SHY>(info.addressingMode);
+            break;
+
+        case Instruction::AXS:
+            dispatchMode<Instruction::AXS>(info.addressingMode);
+            break;
+
+        // Default case for unimplemented or invalid instructions
+        default:
+            throw std::runtime_error("Unimplemented instruction: 0x" +
+                        [&]() -> std::string {
+                            std::stringstream ss;
+                            ss << std::hex << std::uppercase << static_cast<int>(info.instruction);
+                            return ss.str();
+                        }());
     }
 }
 
-uint16_t CPU6502::resolveAddress(AddressingMode mode) {
+/* Legacy dispatch: decode the addressing mode through a switch at run time */
+template <Instruction Op>
+void CPU6502::dispatchMode(AddressingMode mode) {
     switch (mode) {
+        case AddressingMode::Accumulator:
+            executeInstruction<Op, Addressing::Accumulator>();
+            break;
+        case AddressingMode::Absolute:
+            executeInstruction<Op, Addressing::Absolute>();
+            break;
+        case AddressingMode::AbsoluteX:
+            executeInstruction<Op, Addressing::AbsoluteX>();
+            break;
+        case AddressingMode::AbsoluteY:
+            executeInstruction<Op, Addressing::AbsoluteY>();
+            break;
         case AddressingMode::Immediate:
-        {
-            // Return the address of the immediate value (current PC), then increment PC
-            return PC++;
-        }
+            executeInstruction<Op, Addressing::Immediate>();
+            break;
+        case AddressingMode::Implied:
+            executeInstruction<Op, Addressing::Implied>();
+            break;
+        case AddressingMode::Indirect:
+            executeInstruction<Op, Addressing::Indirect>();
+            break;
+        case AddressingMode::IndirectX:
+            executeInstruction<Op, Addressing::IndirectX>();
+            break;
+        case AddressingMode::IndirectY:
+            executeInstruction<Op, Addressing::IndirectY>();
+            break;
+        case AddressingMode::Relative:
+            executeInstruction<Op, Addressing::Relative>();
+            break;
         case AddressingMode::ZeroPage:
-        {
-            // Fetch the zero-page address from the current PC
-            return read(PC++);
-        }
-        case AddressingMode::ZeroPageX: {
-            uint8_t zpAddress = read(PC++);          // Fetch zero-page base address
-            uint8_t effectiveAddress = (zpAddress + X) & 0xFF; // Add X with wraparound
-            return effectiveAddress;
-        }
-                case AddressingMode::ZeroPageY: {
-            uint8_t zpAddress = read(PC++);          // Fetch zero-page base address
-            uint8_t effectiveAddress = (zpAddress + Y) & 0xFF; // Add Y with wraparound
-            return effectiveAddress;
-        }
-        case AddressingMode::AbsoluteX: {
-            uint8_t lo = read(PC++);
-            uint8_t hi = read(PC++);
-            uint16_t baseAddress = (hi << 8) | lo;
-            uint16_t effectiveAddress = baseAddress + X;
+            executeInstruction<Op, Addressing::ZeroPage>();
+            break;
+        case AddressingMode::ZeroPageX:
+            executeInstruction<Op, Addressing::ZeroPageX>();
+            break;
+        case AddressingMode::ZeroPageY:
+            executeInstruction<Op, Addressing::ZeroPageY>();
+            break;
+        case AddressingMode::ZeroPageIndirect:
+            executeInstruction<Op, Addressing::ZeroPageIndirect>();
+            break;
+        default:
+            std::stringstream ss;
+            ss << std::string(__PRETTY_FUNCTION__) << " - "
+            << "Unsupported addressing mode";
+            throw std::runtime_error(ss.str());
+    }
+}
 
-            // Add a cycle if page boundary is crossed
+/* Table dispatch: select the instruction handler at compile time */
+template <Instruction Op, typename Mode>
+void CPU6502::executeInstruction() {
+    if constexpr (Op == Instruction::LDA) {
+        executeLDA<Mode>();
+    } else if constexpr (Op == Instruction::LDX) {
+        executeLDX<Mode>();
+    } else if constexpr (Op == Instruction::LDY) {
+        executeLDY<Mode>();
+    } else if constexpr (Op == Instruction::STA) {
+        executeSTA<Mode>();
+    } else if constexpr (Op == Instruction::STX) {
+        executeSTX<Mode>();
+    } else if constexpr (Op == Instruction::SAX) {
+        executeSAX<Mode>();
+    } else if constexpr (Op == Instruction::STY) {
+        executeSTY<Mode>();
+    } else if constexpr (Op == Instruction::TAX) {
+        executeTAX();
+    } else if constexpr (Op == Instruction::TXA) {
+        executeTXA();
+    } else if constexpr (Op == Instruction::TAY) {
+        executeTAY();
+    } else if constexpr (Op == Instruction::TYA) {
+        executeTYA();
+    } else if constexpr (Op == Instruction::TSX) {
+        executeTSX();
+    } else if constexpr (Op == Instruction::TXS) {
+        executeTXS();
+    } else if constexpr (Op == Instruction::PHA) {
+        executePHA();
+    } else if constexpr (Op == Instruction::PLA) {
+        executePLA();
+    } else if constexpr (Op == Instruction::PHP) {
+        executePHP();
+    } else if constexpr (Op == Instruction::PLP) {
+        executePLP();
+    } else if constexpr (Op == Instruction::AND) {
+        executeAND<Mode>();
+    } else if constexpr (Op == Instruction::ORA) {
+        executeORA<Mode>();
+    } else if constexpr (Op == Instruction::EOR) {
+        executeEOR<Mode>();
+    } else if constexpr (Op == Instruction::ADC) {
+        executeADC<Mode>();
+    } else if constexpr (Op == Instruction::SBC) {
+        executeSBC<Mode>();
+    } else if constexpr (Op == Instruction::CMP) {
+        executeCMP<Mode>();
+    } else if constexpr (Op == Instruction::CPX) {
+        executeCPX<Mode>();
+    } else if constexpr (Op == Instruction::CPY) {
+        executeCPY<Mode>();
+    } else if constexpr (Op == Instruction::INC) {
+        executeINC<Mode>();
+    } else if constexpr (Op == Instruction::INX) {
+        executeINX();
+    } else if constexpr (Op == Instruction::INY) {
+        executeINY();
+    } else if constexpr (Op == Instruction::DEC) {
+        executeDEC<Mode>();
+    } else if constexpr (Op == Instruction::DEX) {
+        executeDEX();
+    } else if constexpr (Op == Instruction::DEY) {
+        executeDEY();
+    } else if constexpr (Op == Instruction::ASL) {
+        executeASL<Mode>();
+    } else if constexpr (Op == Instruction::LSR) {
+        executeLSR<Mode>();
+    } else if constexpr (Op == Instruction::ROL) {
+        executeROL<Mode>();
+    } else if constexpr (Op == Instruction::ROR) {
+        executeROR<Mode>();
+    } else if constexpr (Op == Instruction::SLO) {
+        executeSLO<Mode>();
+    } else if constexpr (Op == Instruction::JMP) {
+        executeJMP<Mode>();
+    } else if constexpr (Op == Instruction::JSR) {
+        executeJSR();
+    } else if constexpr (Op == Instruction::RTS) {
+        executeRTS();
+    } else if constexpr (Op == Instruction::RTI) {
+        executeRTI();
+    } else if constexpr (Op == Instruction::BCC) {
+        executeBCC();
+    } else if constexpr (Op == Instruction::BCS) {
+        executeBCS();
+    } else if constexpr (Op == Instruction::BEQ) {
+        executeBEQ();
+    } else if constexpr (Op == Instruction::BMI) {
+        executeBMI();
+    } else if constexpr (Op == Instruction::BNE) {
+        executeBNE();
+    } else if constexpr (Op == Instruction::BPL) {
+        executeBPL();
+    } else if constexpr (Op == Instruction::BVC) {
+        executeBVC();
+    } else if constexpr (Op == Instruction::BVS) {
+        executeBVS();
+    } else if constexpr (Op == Instruction::BIT) {
+        executeBIT<Mode>();
+    } else if constexpr (Op == Instruction::CLC) {
+        executeCLC();
+    } else if constexpr (Op == Instruction::SEC) {
+        executeSEC();
+    } else if constexpr (Op == Instruction::CLI) {
+        executeCLI();
+    } else if constexpr (Op == Instruction::SEI) {
+        executeSEI();
+    } else if constexpr (Op == Instruction::CLD) {
+        executeCLD();
+    } else if constexpr (Op == Instruction::SED) {
+        executeSED();
+    } else if constexpr (Op == Instruction::CLV) {
+        executeCLV();
+    } else if constexpr (Op == Instruction::DCP) {
+        executeDCP<Mode>();
+    } else if constexpr (Op == Instruction::RLA) {
+        executeRLA<Mode>();
+    } else if constexpr (Op == Instruction::BRK) {
+        executeBRK();
+    } else if constexpr (Op == Instruction::NOP) {
+        executeNOP<Mode>();
+    } else if constexpr (Op == Instruction::ISC) {
+        executeISC<Mode>();
+    } else if constexpr (Op == Instruction::RRA) {
+        executeRRA<Mode>();
+    } else if constexpr (Op == Instruction::LAX) {
+        executeLAX<Mode>();
+    } else if constexpr (Op == Instruction::TAS) {
+        executeTAS<Mode>();
+    } else if constexpr (Op == Instruction::ANC) {
+        executeANC<Mode>();
+    } else if constexpr (Op == Instruction::ALR) {
+        executeALR<Mode>();
+    } else if constexpr (Op == Instruction::ARR) {
+        executeARR<Mode>();
+    } else if constexpr (Op == Instruction::XAA) {
+        executeXAA<Mode>();
+    } else if constexpr (Op == Instruction::AHX) {
+        executeAHX<Mode>();
+    } else if constexpr (Op == Instruction::LAS) {
+        executeLAS<Mode>();
+    } else if constexpr (Op == Instruction::SHX) {
+        executeSHX<Mode>();
+    } else if constexpr (Op == Instruction::SRE) {
+        executeSRE<Mode>();
+    } else if constexpr (Op == Instruction::SHY) {
+        executeSHY<Mode>();
+    } else if constexpr (Op == Instruction::AXS) {
+        executeAXS<Mode>();
+    } else {
+        throw std::runtime_error("Unimplemented instruction: 0x" +
+                    [&]() -> std::string {
+                        std::stringstream ss;
+                        ss << std::hex << std::uppercase << static_cast<int>(Op);
+                        return ss.str();
+                    }());
+    }
+}
+
+/* Table dispatch: handler specialised for a single opcode */
+template <uint8_t Opcode>
+void CPU6502::executeOpcode(CPU6502& cpu) {
+    constexpr OpcodeInfo info = OPCODE_TABLE[Opcode];
+    cpu.executeInstruction<info.instruction, Addressing::Mode<info.addressingMode>>();
+}
+
+template <std::size_t... Opcodes>
+constexpr std::array<CPU6502::OpcodeHandler, 256> CPU6502::buildDispatchTable(std::index_sequence<Opcodes...>) {
+    return {{ &CPU6502::executeOpcode<static_cast<uint8_t>(Opcodes)>... }};
+}
+
+const std::array<CPU6502::OpcodeHandler, 256> CPU6502::DISPATCH_TABLE =
+    CPU6502::buildDispatchTable(std::make_index_sequence<256>{});
+
+template <typename Mode, bool PageCrossPenalty>
+uint16_t CPU6502::resolveAddress() {
+    if constexpr (Mode::mode == AddressingMode::Immediate) {
+        // Return the address of the immediate value (current PC), then increment PC
+        return PC++;
+    } else if constexpr (Mode::mode == AddressingMode::ZeroPage) {
+        // Fetch the zero-page address from the current PC
+        return fetchOperand();
+    } else if constexpr (Mode::mode == AddressingMode::ZeroPageX) {
+        uint8_t zpAddress = fetchOperand();          // Fetch zero-page base address
+        uint8_t effectiveAddress = (zpAddress + X) & 0xFF; // Add X with wraparound
+        return effectiveAddress;
+    } else if constexpr (Mode::mode == AddressingMode::ZeroPageY) {
+        uint8_t zpAddress = fetchOperand();          // Fetch zero-page base address
+        uint8_t effectiveAddress = (zpAddress + Y) & 0xFF; // Add Y with wraparound
+        return effectiveAddress;
+    } else if constexpr (Mode::mode == AddressingMode::AbsoluteX || Mode::mode == AddressingMode::AbsoluteY) {
+        uint8_t lo = fetchOperand();
+        uint8_t hi = fetchOperand();
+        uint16_t baseAddress = (hi << 8) | lo;
+        uint16_t effectiveAddress = baseAddress + (Mode::mode == AddressingMode::AbsoluteX ? X : Y);
+
+        // Add a cycle if page boundary is crossed
+        if constexpr (PageCrossPenalty) {
             if ((baseAddress & 0xFF00) != (effectiveAddress & 0xFF00)) {
                 cycles++;
             }
-
-            return effectiveAddress;
         }
-        case AddressingMode::AbsoluteY: {
-            uint8_t lo = read(PC++);
-            uint8_t hi = read(PC++);
-            uint16_t baseAddress = (hi << 8) | lo;
-            uint16_t effectiveAddress = baseAddress + Y;
 
-            // Add a cycle if page boundary is crossed
+        return effectiveAddress;
+    } else if constexpr (Mode::mode == AddressingMode::Absolute) {
+        // Fetch the 16-bit absolute address from the next two bytes
+        uint8_t lo = fetchOperand();
+        uint8_t hi = fetchOperand();
+        return (hi << 8) | lo;
+    } else if constexpr (Mode::mode == AddressingMode::IndirectX) {
+        // Fetch zero-page address and add X register, wrap around in zero-page
+        uint8_t zpAddress = (fetchOperand() + X) & 0xFF;
+        uint8_t lo = WRAM[zpAddress];
+        uint8_t hi = WRAM[(zpAddress + 1) & 0xFF]; // Wrap around zero-page
+        return (hi << 8) | lo;
+    } else if constexpr (Mode::mode == AddressingMode::IndirectY) {
+        // Fetch zero-page pointer and add Y register, wrap around zero-page
+        uint8_t zpAddress = fetchOperand();
+        uint8_t lo = WRAM[zpAddress];
+        uint8_t hi = WRAM[(zpAddress + 1) & 0xFF]; // Wrap around zero-page
+        uint16_t baseAddress = (hi << 8) | lo;
+        uint16_t effectiveAddress = baseAddress + Y; // Add Y for final effective address
+
+        // Add a cycle if page boundary is crossed
+        if constexpr (PageCrossPenalty) {
             if ((baseAddress & 0xFF00) != (effectiveAddress & 0xFF00)) {
                 cycles++;
             }
-
-            return effectiveAddress;
-        }
-        case AddressingMode::Absolute:
-        {
-            // Fetch the 16-bit absolute address from the next two bytes
-            uint8_t lo = read(PC++);
-            uint8_t hi = read(PC++);
-            return (hi << 8) | lo;
-        }
-        case AddressingMode::IndirectX: {
-            // Fetch zero-page address and add X register, wrap around in zero-page
-            uint8_t zpAddress = (read(PC++) + X) & 0xFF;
-            uint8_t lo = read(zpAddress);
-            uint8_t hi = read((zpAddress + 1) & 0xFF); // Wrap around zero-page
-            return (hi << 8) | lo;
-        }
-        case AddressingMode::IndirectY: {
-            // Fetch zero-page pointer and add Y register, wrap around zero-page
-            uint8_t zpAddress = read(PC++);
-            uint8_t lo = read(zpAddress);
-            uint8_t hi = read((zpAddress + 1) & 0xFF); // Wrap around zero-page
-            uint16_t baseAddress = (hi << 8) | lo;
-            return baseAddress + Y; // Add Y for final effective address
-        }
-        case AddressingMode::Indirect: {
-            uint8_t lo = read(PC++);
-            uint8_t hi = read(PC++);
-            uint16_t pointer = (hi << 8) | lo;
-
-            // 6502 bug: Handle page boundary wraparound for indirect JMP
-            uint8_t lowByte = read(pointer);
-            uint8_t highByte = read((pointer & 0xFF00) | ((pointer + 1) & 0x00FF));
-            return (highByte << 8) | lowByte;
         }
-        case AddressingMode::Relative: {
-            int8_t offset = static_cast<int8_t>(read(PC++)); // Signed 8-bit offset
-            return PC + static_cast<uint16_t>(offset); // Calculate the effective address (unsigned wrap-around subtraction)
-        }
-        case AddressingMode::ZeroPageIndirect: {
-            // Fetch zero-page address from the current PC
-            uint8_t zpAddress = read(PC++);
-            uint8_t lo = read(zpAddress);
-            uint8_t hi = read((zpAddress + 1) & 0xFF); // Wrap around zero-page
-            return (hi << 8) | lo; // Combine high and low bytes to get the effective address
-        }
-        default:
-            std::stringstream ss;
-            ss << std::string(__PRETTY_FUNCTION__) << " - "
-            << "Unsupported addressing mode";
-            throw std::runtime_error(ss.str());
+
+        return effectiveAddress;
+    } else if constexpr (Mode::mode == AddressingMode::Indirect) {
+        uint8_t lo = fetchOperand();
+        uint8_t hi = fetchOperand();
+        uint16_t pointer = (hi << 8) | lo;
+
+        // 6502 bug: Handle page boundary wraparound for indirect JMP
+        uint8_t lowByte = read(pointer);
+        uint8_t highByte = read((pointer & 0xFF00) | ((pointer + 1) & 0x00FF));
+        return (highByte << 8) | lowByte;
+    } else if constexpr (Mode::mode == AddressingMode::Relative) {
+        int8_t offset = static_cast<int8_t>(fetchOperand()); // Signed 8-bit offset
+        return PC + static_cast<uint16_t>(offset); // Calculate the effective address (unsigned wrap-around subtraction)
+    } else if constexpr (Mode::mode == AddressingMode::ZeroPageIndirect) {
+        // Fetch zero-page address from the current PC
+        uint8_t zpAddress = fetchOperand();
+        uint8_t lo = WRAM[zpAddress];
+        uint8_t hi = WRAM[(zpAddress + 1) & 0xFF]; // Wrap around zero-page
+        return (hi << 8) | lo; // Combine high and low bytes to get the effective address
+    } else {
+        std::stringstream ss;
+        ss << std::string(__PRETTY_FUNCTION__) << " - "
+        << "Unsupported addressing mode";
+        throw std::runtime_error(ss.str());
     }
 }
 
+template <typename Mode>
+uint8_t CPU6502::readOperand(uint16_t address) const {
+    // Immediate operands were fetched with the opcode
+    if constexpr (Mode::mode == AddressingMode::Immediate) {
+        return static_cast<uint8_t>(operand);
+    }
+    // Zero-page operands always live in WRAM: skip the memory map
+    else if constexpr (Mode::zeroPage) {
+        return WRAM[address];
+    } else {
+        return read(address);
+    }
+}
+
+template <typename Mode>
+void CPU6502::writeOperand(uint16_t address, uint8_t value) {
+    if constexpr (Mode::zeroPage) {
+        WRAM[address] = value;
+    } else {
+        write(address, value);
+    }
+}
+
+/* Flags kept in statusReg as they are */
+static constexpr uint8_t STORED_FLAGS = static_cast<uint8_t>(StatusFlag::BREAK_FLAG) |
+                                        static_cast<uint8_t>(StatusFlag::DECIMAL_MODE_FLAG) |
+                                        static_cast<uint8_t>(StatusFlag::INTERRUPT_DISABLE_FLAG);
+
 uint8_t CPU6502::getStatusRegister() const {
-    uint8_t status = 0;
-    if (getFlag(StatusFlag::NEGATIVE_FLAG))    status |= (1 << 7);
-    if (getFlag(StatusFlag::OVERFLOW_FLAG))    status |= (1 << 6);
-    status |= (1 << 5); // Unused bit, always set to 1
-    if (getFlag(StatusFlag::BREAK_FLAG))       status |= (1 << 4);
-    if (getFlag(StatusFlag::DECIMAL_MODE_FLAG)) status |= (1 << 3);
-    if (getFlag(StatusFlag::INTERRUPT_DISABLE_FLAG)) status |= (1 << 2);
-    if (getFlag(StatusFlag::ZERO_FLAG))        status |= (1 << 1);
-    if (getFlag(StatusFlag::CARRY_FLAG))       status |= (1 << 0);
+    uint8_t status = (statusReg & STORED_FLAGS) | (1 << 5); // Unused bit, always set to 1
+    status |= (flagResult | flagResult >> 8) & 0x80;        // N
+    status |= (flagOverflow & 0x80) >> 1;                   // V
+    status |= (flagResult & 0xFF) == 0 ? (1 << 1) : 0;      // Z
+    status |= flagCarry;                                    // C
     return status;
 }
 
 void CPU6502::setStatusRegister(uint8_t value) {
-    setFlag(StatusFlag::NEGATIVE_FLAG,    value & (1 << 7));
-    setFlag(StatusFlag::OVERFLOW_FLAG,    value & (1 << 6));
     // Bit 5 is ignored when writing to the status register
-    setFlag(StatusFlag::BREAK_FLAG,       value & (1 << 4));
-    setFlag(StatusFlag::DECIMAL_MODE_FLAG, value & (1 << 3));
-    setFlag(StatusFlag::INTERRUPT_DISABLE_FLAG, value & (1 << 2));
-    setFlag(StatusFlag::ZERO_FLAG,        value & (1 << 1));
-    setFlag(StatusFlag::CARRY_FLAG,       value & (1 << 0));
+    statusReg = (statusReg & ~STORED_FLAGS) | (value & STORED_FLAGS);
+    flagResult = (value & (1 << 1) ? 0x0000 : 0x0001) | (value & (1 << 7)) << 8;
+    flagOverflow = (value & (1 << 6)) << 1;
+    flagCarry = value & (1 << 0);
 }
 
 
@@ -505,103 +1154,114 @@ uint8_t CPU6502::pullStack() {
     return read(0x0100 + SP);   // Read the value from the stack
 }
 
-void CPU6502::executeBIT(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode); // Resolve the operand address
-    uint8_t value = read(address);           // Read the value from memory
+template <typename Mode>
+void CPU6502::executeBIT() {
+    uint16_t address = resolveAddress<Mode>(); // Resolve the operand address
+    uint8_t value = readOperand<Mode>(address);           // Read the value from memory
 
-    // Test bits
-    setFlag(StatusFlag::ZERO_FLAG, (A & value) == 0);      // Set Z if (A & value) == 0
-    setFlag(StatusFlag::NEGATIVE_FLAG, value & 0x80);      // Set N to bit 7 of value
-    setFlag(StatusFlag::OVERFLOW_FLAG, value & 0x40);      // Set V to bit 6 of value
+    // Test bits: Z from (A & value), N and V from bits 7 and 6 of value
+    flagResult = (A & value) | (value & 0x80) << 8;
+    flagOverflow = value << 1;
 }
 
 
-void CPU6502::executeSRE(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address);
+template <typename Mode>
+void CPU6502::executeSRE() {
+    uint16_t address = resolveAddress<Mode, false>();
+    uint8_t value = readOperand<Mode>(address);
 
     // Logical shift right
     setFlag(StatusFlag::CARRY_FLAG, value & 0x01); // Set carry flag from LSB
     value >>= 1;
-    write(address, value);
+    writeOperand<Mode>(address, value);
 
     // Exclusive OR with the accumulator
     A ^= value;
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeSHY(AddressingMode mode) {
-    if (mode != AddressingMode::AbsoluteX) {
+template <typename Mode>
+void CPU6502::executeSHY() {
+    if constexpr (Mode::mode != AddressingMode::AbsoluteX) {
         std::stringstream ss;
             ss << std::string(__PRETTY_FUNCTION__) << " - "
             << "Unsupported addressing mode";
             throw std::runtime_error(ss.str());
     }
 
-    uint16_t address = resolveAddress(mode);
+    uint16_t address = resolveAddress<Mode, false>();
     uint8_t result = Y & ((address >> 8) + 1); // Compute Y AND (high-byte + 1)
-    write(address, result);
+    writeOperand<Mode>(address, result);
 }
 
-void CPU6502::executeAXS(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
+template <typename Mode>
+void CPU6502::executeAXS() {
+    uint16_t address = resolveAddress<Mode, false>();
     uint8_t value = A & X; // Compute A AND X
-    write(address, value);
+    writeOperand<Mode>(address, value);
 }
 
-void CPU6502::executeANC(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    A &= read(address);
+template <typename Mode>
+void CPU6502::executeANC() {
+    uint16_t address = resolveAddress<Mode>();
+    A &= readOperand<Mode>(address);
     updateZeroNegativeFlags(A);
     setFlag(StatusFlag::CARRY_FLAG, A & 0x80); // Set Carry if MSB is 1
 }
 
-void CPU6502::executeALR(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    A &= read(address);
+template <typename Mode>
+void CPU6502::executeALR() {
+    uint16_t address = resolveAddress<Mode>();
+    A &= readOperand<Mode>(address);
     setFlag(StatusFlag::CARRY_FLAG, A & 0x01); // Set Carry from LSB
     A >>= 1;
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeARR(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    A &= read(address);
+template <typename Mode>
+void CPU6502::executeARR() {
+    uint16_t address = resolveAddress<Mode>();
+    A &= readOperand<Mode>(address);
     A = (A >> 1) | (getFlag(StatusFlag::CARRY_FLAG) << 7);
     updateZeroNegativeFlags(A);
     setFlag(StatusFlag::CARRY_FLAG, A & 0x40); // Special handling
     setFlag(StatusFlag::OVERFLOW_FLAG, ((A & 0x40) >> 6) ^ ((A & 0x20) >> 5));
 }
 
-void CPU6502::executeXAA(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    A = X & read(address);
+template <typename Mode>
+void CPU6502::executeXAA() {
+    uint16_t address = resolveAddress<Mode>();
+    A = X & readOperand<Mode>(address);
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeAHX(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
+template <typename Mode>
+void CPU6502::executeAHX() {
+    uint16_t address = resolveAddress<Mode, false>();
     uint8_t result = A & X & ((address >> 8) + 1);
-    write(address, result);
+    writeOperand<Mode>(address, result);
 }
 
-void CPU6502::executeLAS(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address) & SP;
+template <typename Mode>
+void CPU6502::executeLAS() {
+    uint16_t address = resolveAddress<Mode>();
+    uint8_t value = readOperand<Mode>(address) & SP;
     A = value;
     X = value;
     SP = value;
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeSHX(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
+template <typename Mode>
+void CPU6502::executeSHX() {
+    uint16_t address = resolveAddress<Mode, false>();
     uint8_t result = X & ((address >> 8) + 1);
-    write(address, result);
+    writeOperand<Mode>(address, result);
 }
 
-void CPU6502::executeTAS(AddressingMode mode) {
-    if (mode != AddressingMode::AbsoluteY) {
+template <typename Mode>
+void CPU6502::executeTAS() {
+    if constexpr (Mode::mode != AddressingMode::AbsoluteY) {
         std::stringstream ss;
             ss << std::string(__PRETTY_FUNCTION__) << " - "
             << "Unsupported addressing mode";
@@ -615,36 +1275,38 @@ void CPU6502::executeTAS(AddressingMode mode) {
     SP = value;
 
     // Step 3: Calculate memory address with AbsoluteY addressing
-    uint16_t address = resolveAddress(mode);
+    uint16_t address = resolveAddress<Mode, false>();
 
     // Step 4: Store (A AND X AND high-byte of the address + 1) into memory
     uint8_t result = value & ((address >> 8) + 1);
-    write(address, result);
+    writeOperand<Mode>(address, result);
 }
 
 
-void CPU6502::executeRRA(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address);
+template <typename Mode>
+void CPU6502::executeRRA() {
+    uint16_t address = resolveAddress<Mode, false>();
+    uint8_t value = readOperand<Mode>(address);
 
     // Rotate Right
     bool carry = getFlag(StatusFlag::CARRY_FLAG);
     setFlag(StatusFlag::CARRY_FLAG, value & 0x01);
     value = (value >> 1) | (carry << 7);
 
-    write(address, value);
+    writeOperand<Mode>(address, value);
 
     // Add Memory to Accumulator with Carry
-    uint16_t result = A + value + getFlag(StatusFlag::CARRY_FLAG);
-    setFlag(StatusFlag::CARRY_FLAG, result > 0xFF);
-    setFlag(StatusFlag::OVERFLOW_FLAG, (~(A ^ value) & (A ^ result) & 0x80) != 0);
+    uint16_t result = A + value + flagCarry;
+    flagCarry = result >> 8;
+    flagOverflow = ~(A ^ value) & (A ^ result);
     A = result & 0xFF;
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeLAX(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address);
+template <typename Mode>
+void CPU6502::executeLAX() {
+    uint16_t address = resolveAddress<Mode>();
+    uint8_t value = readOperand<Mode>(address);
 
     A = value;
     X = value;
@@ -653,32 +1315,34 @@ void CPU6502::executeLAX(AddressingMode mode) {
 }
 
 
-void CPU6502::executeISC(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address) + 1;
-    write(address, value);
+template <typename Mode>
+void CPU6502::executeISC() {
+    uint16_t address = resolveAddress<Mode, false>();
+    uint8_t value = readOperand<Mode>(address) + 1;
+    writeOperand<Mode>(address, value);
 
     // Subtract Memory from Accumulator with Borrow
     value = ~value; // 1's complement for subtraction
-    uint16_t result = A + value + getFlag(StatusFlag::CARRY_FLAG);
-    setFlag(StatusFlag::CARRY_FLAG, result > 0xFF);
-    setFlag(StatusFlag::OVERFLOW_FLAG, (~(A ^ value) & (A ^ result) & 0x80) != 0);
+    uint16_t result = A + value + flagCarry;
+    flagCarry = result >> 8;
+    flagOverflow = ~(A ^ value) & (A ^ result);
     A = result & 0xFF;
     updateZeroNegativeFlags(A);
 }
 
 
 
-void CPU6502::executeRLA(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address);
+template <typename Mode>
+void CPU6502::executeRLA() {
+    uint16_t address = resolveAddress<Mode, false>();
+    uint8_t value = readOperand<Mode>(address);
 
     // Rotate Left
     bool carry = getFlag(StatusFlag::CARRY_FLAG);
     setFlag(StatusFlag::CARRY_FLAG, value & 0x80);
     value = (value << 1) | carry;
 
-    write(address, value);
+    writeOperand<Mode>(address, value);
 
     // AND with Accumulator
     A &= value;
@@ -686,42 +1350,44 @@ void CPU6502::executeRLA(AddressingMode mode) {
 }
 
 
-void CPU6502::executeDCP(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode); // Resolve effective address
+template <typename Mode>
+void CPU6502::executeDCP() {
+    uint16_t address = resolveAddress<Mode, false>(); // Resolve effective address
 
     // Step 1: Decrement memory
-    uint8_t value = read(address);          // Read current value
+    uint8_t value = readOperand<Mode>(address);          // Read current value
     value -= 1;                             // Decrement
-    write(address, value);                  // Write back to memory
+    writeOperand<Mode>(address, value);                  // Write back to memory
 
     // Step 2: Compare with Accumulator
-    uint16_t result = static_cast<uint16_t>(A) - value;
+    uint8_t result = A - value;
     setFlag(StatusFlag::CARRY_FLAG, A >= value);  // Set if no borrow
-    setFlag(StatusFlag::ZERO_FLAG, result == 0); // Set if result is zero
-    setFlag(StatusFlag::NEGATIVE_FLAG, result & 0x80); // Set if result is negative
+    updateZeroNegativeFlags(result);              // Set Z if zero, N if negative
 }
 
 
-void CPU6502::executeSAX(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode); // Resolve effective address
+template <typename Mode>
+void CPU6502::executeSAX() {
+    uint16_t address = resolveAddress<Mode, false>(); // Resolve effective address
     uint8_t value = A & X;                  // Compute A AND X
-    write(address, value);                  // Store the result in memory
+    writeOperand<Mode>(address, value);                  // Store the result in memory
 }
 
 
-void CPU6502::executeSLO(AddressingMode mode) {
+template <typename Mode>
+void CPU6502::executeSLO() {
     // Resolve the address based on the addressing mode
-    uint16_t address = resolveAddress(mode);
+    uint16_t address = resolveAddress<Mode, false>();
 
     // Read the value at the resolved address
-    uint8_t value = read(address);
+    uint8_t value = readOperand<Mode>(address);
 
     // Perform ASL (Arithmetic Shift Left)
     setFlag(StatusFlag::CARRY_FLAG, value & 0x80); // Set carry from MSB
     value <<= 1; // Shift left
 
     // Write the result back to memory
-    write(address, value);
+    writeOperand<Mode>(address, value);
 
     // OR the result with the accumulator
     A |= value;
@@ -731,14 +1397,16 @@ void CPU6502::executeSLO(AddressingMode mode) {
 }
 
 
-void CPU6502::executeSTX(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    write(address, X);
+template <typename Mode>
+void CPU6502::executeSTX() {
+    uint16_t address = resolveAddress<Mode, false>();
+    writeOperand<Mode>(address, X);
 }
 
-void CPU6502::executeSTY(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    write(address, Y);
+template <typename Mode>
+void CPU6502::executeSTY() {
+    uint16_t address = resolveAddress<Mode, false>();
+    writeOperand<Mode>(address, Y);
 }
 
 void CPU6502::executeTAX() {
@@ -783,64 +1451,72 @@ void CPU6502::executePLP() {
     setStatusRegister(pullStack());
 }
 
-void CPU6502::executeAND(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    A &= read(address);
+template <typename Mode>
+void CPU6502::executeAND() {
+    uint16_t address = resolveAddress<Mode>();
+    A &= readOperand<Mode>(address);
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeORA(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    A |= read(address);
+template <typename Mode>
+void CPU6502::executeORA() {
+    uint16_t address = resolveAddress<Mode>();
+    A |= readOperand<Mode>(address);
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeEOR(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    A ^= read(address);
+template <typename Mode>
+void CPU6502::executeEOR() {
+    uint16_t address = resolveAddress<Mode>();
+    A ^= readOperand<Mode>(address);
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeADC(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address);
-    uint16_t sum = A + value + getFlag(StatusFlag::CARRY_FLAG);
-    setFlag(StatusFlag::CARRY_FLAG, sum > 0xFF);
-    setFlag(StatusFlag::OVERFLOW_FLAG, (~(A ^ value) & (A ^ sum) & 0x80) != 0);
+template <typename Mode>
+void CPU6502::executeADC() {
+    uint16_t address = resolveAddress<Mode>();
+    uint8_t value = readOperand<Mode>(address);
+    uint16_t sum = A + value + flagCarry;
+    flagCarry = sum >> 8;
+    flagOverflow = ~(A ^ value) & (A ^ sum);
     A = sum & 0xFF;
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeSBC(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address) ^ 0xFF; // 1's complement for subtraction
-    uint16_t sum = A + value + getFlag(StatusFlag::CARRY_FLAG);
-    setFlag(StatusFlag::CARRY_FLAG, sum > 0xFF);
-    setFlag(StatusFlag::OVERFLOW_FLAG, (~(A ^ value) & (A ^ sum) & 0x80) != 0);
+template <typename Mode>
+void CPU6502::executeSBC() {
+    uint16_t address = resolveAddress<Mode>();
+    uint8_t value = readOperand<Mode>(address) ^ 0xFF; // 1's complement for subtraction
+    uint16_t sum = A + value + flagCarry;
+    flagCarry = sum >> 8;
+    flagOverflow = ~(A ^ value) & (A ^ sum);
     A = sum & 0xFF;
     updateZeroNegativeFlags(A);
 }
 
-void CPU6502::executeCPX(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address);
+template <typename Mode>
+void CPU6502::executeCPX() {
+    uint16_t address = resolveAddress<Mode>();
+    uint8_t value = readOperand<Mode>(address);
     uint16_t result = X - value;
     setFlag(StatusFlag::CARRY_FLAG, X >= value);
     updateZeroNegativeFlags(result & 0xFF);
 }
 
-void CPU6502::executeCPY(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address);
+template <typename Mode>
+void CPU6502::executeCPY() {
+    uint16_t address = resolveAddress<Mode>();
+    uint8_t value = readOperand<Mode>(address);
     uint16_t result = Y - value;
     setFlag(StatusFlag::CARRY_FLAG, Y >= value);
     updateZeroNegativeFlags(result & 0xFF);
 }
 
-void CPU6502::executeINC(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address) + 1;
-    write(address, value);
+template <typename Mode>
+void CPU6502::executeINC() {
+    uint16_t address = resolveAddress<Mode, false>();
+    uint8_t value = readOperand<Mode>(address) + 1;
+    writeOperand<Mode>(address, value);
     updateZeroNegativeFlags(value);
 }
 
@@ -854,10 +1530,11 @@ void CPU6502::executeINY() {
     updateZeroNegativeFlags(Y);
 }
 
-void CPU6502::executeDEC(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address) - 1;
-    write(address, value);
+template <typename Mode>
+void CPU6502::executeDEC() {
+    uint16_t address = resolveAddress<Mode, false>();
+    uint8_t value = readOperand<Mode>(address) - 1;
+    writeOperand<Mode>(address, value);
     updateZeroNegativeFlags(value);
 }
 
@@ -871,43 +1548,45 @@ void CPU6502::executeDEY() {
     updateZeroNegativeFlags(Y);
 }
 
-void CPU6502::executeASL(AddressingMode mode) {
-    if (mode == AddressingMode::Accumulator) {
+template <typename Mode>
+void CPU6502::executeASL() {
+    if constexpr (Mode::mode == AddressingMode::Accumulator) {
         // Handle Accumulator Mode
         setFlag(StatusFlag::CARRY_FLAG, A & 0x80); // Set carry flag to bit 7 of A
         A <<= 1;                                  // Shift accumulator left by 1
         updateZeroNegativeFlags(A);               // Update zero and negative flags
     } else {
         // Handle Memory Addressing Modes
-        uint16_t address = resolveAddress(mode);
-        uint8_t value = read(address);
+        uint16_t address = resolveAddress<Mode, false>();
+        uint8_t value = readOperand<Mode>(address);
         setFlag(StatusFlag::CARRY_FLAG, value & 0x80); // Set carry flag to bit 7 of value
         value <<= 1;                                  // Shift value left by 1
-        write(address, value);                        // Write result back to memory
+        writeOperand<Mode>(address, value);           // Write result back to memory
         updateZeroNegativeFlags(value);               // Update zero and negative flags
     }
 }
 
 
-void CPU6502::executeLSR(AddressingMode mode) {
-    if (mode == AddressingMode::Accumulator) {
+template <typename Mode>
+void CPU6502::executeLSR() {
+    if constexpr (Mode::mode == AddressingMode::Accumulator) {
         // Perform the shift directly on the accumulator
         setFlag(StatusFlag::CARRY_FLAG, A & 0x01); // Set the carry flag to bit 0 of A
         A >>= 1;                             // Logical shift right
-        setFlag(StatusFlag::ZERO_FLAG, A == 0);   // Set zero flag if A is now zero
-        setFlag(StatusFlag::NEGATIVE_FLAG, false); // LSR always clears the negative flag
+        updateZeroNegativeFlags(A);          // Bit 7 is now clear, so N is cleared
     } else {
-        uint16_t address = resolveAddress(mode);
-        uint8_t value = read(address);
+        uint16_t address = resolveAddress<Mode, false>();
+        uint8_t value = readOperand<Mode>(address);
         setFlag(StatusFlag::CARRY_FLAG, value & 0x01);
         value >>= 1;
-        write(address, value);
+        writeOperand<Mode>(address, value);
         updateZeroNegativeFlags(value);
     }
 }
 
-void CPU6502::executeROL(AddressingMode mode) {
-    if (mode == AddressingMode::Accumulator) {
+template <typename Mode>
+void CPU6502::executeROL() {
+    if constexpr (Mode::mode == AddressingMode::Accumulator) {
         // Handle Accumulator Mode
         bool carry = getFlag(StatusFlag::CARRY_FLAG); // Save the current carry flag
         setFlag(StatusFlag::CARRY_FLAG, A & 0x80);    // Set carry flag to bit 7 of A
@@ -915,33 +1594,44 @@ void CPU6502::executeROL(AddressingMode mode) {
         updateZeroNegativeFlags(A);                   // Update zero and negative flags
     } else {
         // Handle Memory Addressing Modes
-        uint16_t address = resolveAddress(mode);
-        uint8_t value = read(address);
+        uint16_t address = resolveAddress<Mode, false>();
+        uint8_t value = readOperand<Mode>(address);
         bool carry = getFlag(StatusFlag::CARRY_FLAG); // Save the current carry flag
         setFlag(StatusFlag::CARRY_FLAG, value & 0x80); // Set carry flag to bit 7 of value
         value = (value << 1) | carry;                 // Rotate left with carry
-        write(address, value);
+        writeOperand<Mode>(address, value);
         updateZeroNegativeFlags(value);               // Update zero and negative flags
     }
 }
 
 
-void CPU6502::executeROR(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address);
-    bool carry = getFlag(StatusFlag::CARRY_FLAG);
-    setFlag(StatusFlag::CARRY_FLAG, value & 0x01);
-    value = (value >> 1) | (carry << 7);
-    write(address, value);
-    updateZeroNegativeFlags(value);
+template <typename Mode>
+void CPU6502::executeROR() {
+    if constexpr (Mode::mode == AddressingMode::Accumulator) {
+        // Handle Accumulator Mode
+        bool carry = getFlag(StatusFlag::CARRY_FLAG); // Save the current carry flag
+        setFlag(StatusFlag::CARRY_FLAG, A & 0x01);    // Set carry flag to bit 0 of A
+        A = (A >> 1) | (carry << 7);                  // Rotate right with carry
+        updateZeroNegativeFlags(A);                   // Update zero and negative flags
+    } else {
+        // Handle Memory Addressing Modes
+        uint16_t address = resolveAddress<Mode, false>();
+        uint8_t value = readOperand<Mode>(address);
+        bool carry = getFlag(StatusFlag::CARRY_FLAG);
+        setFlag(StatusFlag::CARRY_FLAG, value & 0x01);
+        value = (value >> 1) | (carry << 7);
+        writeOperand<Mode>(address, value);
+        updateZeroNegativeFlags(value);
+    }
 }
 
-void CPU6502::executeJMP(AddressingMode mode) {
-    PC = resolveAddress(mode);
+template <typename Mode>
+void CPU6502::executeJMP() {
+    PC = resolveAddress<Mode, false>();
 }
 
 void CPU6502::executeJSR() {
-    uint16_t jumpAddress = resolveAddress(AddressingMode::Absolute);
+    uint16_t jumpAddress = resolveAddress<Addressing::Absolute>();
     pushStack((PC - 1) >> 8); // High byte
     pushStack((PC - 1) & 0xFF); // Low byte
     PC = jumpAddress;
@@ -962,7 +1652,7 @@ void CPU6502::executeRTI() {
 }
 
 void CPU6502::executeBCC() {
-    uint16_t targetAddress = resolveAddress(AddressingMode::Relative);
+    uint16_t targetAddress = resolveAddress<Addressing::Relative>();
     if (!getFlag(StatusFlag::CARRY_FLAG)) {
         if ((PC & 0xFF00) != (targetAddress & 0xFF00)) {
             cycles++;
@@ -973,7 +1663,7 @@ void CPU6502::executeBCC() {
 }
 
 void CPU6502::executeBEQ() {
-    uint16_t targetAddress = resolveAddress(AddressingMode::Relative);
+    uint16_t targetAddress = resolveAddress<Addressing::Relative>();
     if (getFlag(StatusFlag::ZERO_FLAG)) {
         if ((PC & 0xFF00) != (targetAddress & 0xFF00)) {
             cycles++;
@@ -984,7 +1674,7 @@ void CPU6502::executeBEQ() {
 }
 
 void CPU6502::executeBMI() {
-    uint16_t targetAddress = resolveAddress(AddressingMode::Relative);
+    uint16_t targetAddress = resolveAddress<Addressing::Relative>();
     if (getFlag(StatusFlag::NEGATIVE_FLAG)) {
         if ((PC & 0xFF00) != (targetAddress & 0xFF00)) {
             cycles++;
@@ -995,7 +1685,7 @@ void CPU6502::executeBMI() {
 }
 
 void CPU6502::executeBNE() {
-    uint16_t targetAddress = resolveAddress(AddressingMode::Relative);
+    uint16_t targetAddress = resolveAddress<Addressing::Relative>();
     
     if (!getFlag(StatusFlag::ZERO_FLAG)) {
         if ((PC & 0xFF00) != (targetAddress & 0xFF00)) {
@@ -1007,7 +1697,7 @@ void CPU6502::executeBNE() {
 }
 
 void CPU6502::executeBVC() {
-    uint16_t targetAddress = resolveAddress(AddressingMode::Relative);
+    uint16_t targetAddress = resolveAddress<Addressing::Relative>();
     if (!getFlag(StatusFlag::OVERFLOW_FLAG)) {
         if ((PC & 0xFF00) != (targetAddress & 0xFF00)) {
             cycles++;
@@ -1018,7 +1708,7 @@ void CPU6502::executeBVC() {
 }
 
 void CPU6502::executeBVS() {
-    uint16_t targetAddress = resolveAddress(AddressingMode::Relative);
+    uint16_t targetAddress = resolveAddress<Addressing::Relative>();
     if (getFlag(StatusFlag::OVERFLOW_FLAG)) {
         if ((PC & 0xFF00) != (targetAddress & 0xFF00)) {
             cycles++;
@@ -1058,23 +1748,11 @@ void CPU6502::executeBRK() {
     PC = (read(0xFFFF) << 8) | read(0xFFFE);
 }
 
-void CPU6502::executeNOP(AddressingMode mode) {
-    // Handle different NOPs based on their addressing mode
-    switch (mode) {
-        case AddressingMode::Immediate:
-        case AddressingMode::ZeroPage:
-        case AddressingMode::Absolute:
-        case AddressingMode::AbsoluteX:
-            // Simply resolve the address to advance PC without doing anything
-            resolveAddress(mode);
-            break;
-
-        case AddressingMode::Implied:
-            // Standard NOP; nothing to do
-            break;
-
-        default:
-            throw std::runtime_error("Unsupported NOP addressing mode");
+template <typename Mode>
+void CPU6502::executeNOP() {
+    // NOPs with an operand resolve it to advance PC (absolute,X ones take the page-crossing cycle)
+    if constexpr (Mode::mode != AddressingMode::Implied && Mode::mode != AddressingMode::Accumulator) {
+        resolveAddress<Mode>();
     }
 }
 
@@ -1082,7 +1760,7 @@ void CPU6502::executeNOP(AddressingMode mode) {
 
 void CPU6502::executeBCS()
 {
-    int8_t offset = static_cast<int8_t>(read(PC++)); // Fetch signed 8-bit offset
+    int8_t offset = static_cast<int8_t>(fetchOperand()); // Fetch signed 8-bit offset
     if (getFlag(StatusFlag::CARRY_FLAG)) {          // Check if Carry flag is set
         uint16_t oldPC = PC;                        // Store the old PC for boundary check
         PC += offset;                               // Add the offset to the PC
@@ -1096,32 +1774,32 @@ void CPU6502::executeBCS()
     }
 }
 
-void CPU6502::executeCMP(AddressingMode mode) { 
-    uint16_t address = resolveAddress(mode); // Get the effective address
-    uint8_t value = read(address);           // Read the value to compare with A
+template <typename Mode>
+void CPU6502::executeCMP() {
+    uint16_t address = resolveAddress<Mode>(); // Get the effective address
+    uint8_t value = readOperand<Mode>(address);           // Read the value to compare with A
 
     uint8_t result = A - value;              // Perform subtraction, keep lower 8 bits
 
     // Update Carry flag: Set if A >= value
     setFlag(StatusFlag::CARRY_FLAG, A >= value);
 
-    // Update Zero flag: Set if result is 0
-    setFlag(StatusFlag::ZERO_FLAG, result == 0);
-
-    // Update Negative flag: Set if the MSB of the result is 1
-    setFlag(StatusFlag::NEGATIVE_FLAG, result & 0x80);
+    // Update Zero and Negative flags from the difference
+    updateZeroNegativeFlags(result);
 }
 
-void CPU6502::executeLDY(AddressingMode mode) { 
-    uint16_t address = resolveAddress(mode); // Resolve the effective address
-    Y = read(address); // Load the value into the Y register
+template <typename Mode>
+void CPU6502::executeLDY() {
+    uint16_t address = resolveAddress<Mode>(); // Resolve the effective address
+    Y = readOperand<Mode>(address); // Load the value into the Y register
 
     updateZeroNegativeFlags(Y); // Update Zero and Negative flags
 }
 
-void CPU6502::executeLDA(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    uint8_t value = read(address);
+template <typename Mode>
+void CPU6502::executeLDA() {
+    uint16_t address = resolveAddress<Mode>();
+    uint8_t value = readOperand<Mode>(address);
     A = value;
 
     updateZeroNegativeFlags(A);
@@ -1143,12 +1821,13 @@ void CPU6502::executeCLD() {
     // }
 }
 
-void CPU6502::executeSTA(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    write(address, A);
+template <typename Mode>
+void CPU6502::executeSTA() {
+    uint16_t address = resolveAddress<Mode, false>();
+    writeOperand<Mode>(address, A);
 
     // if (DEBUG) {
-    //     uint8_t readBackValue = read(address);
+    //     uint8_t readBackValue = readOperand<Mode>(address);
     //     std::cout << "Executed STA: Stored A (0x" << std::hex << std::uppercase
     //               << static_cast<int>(A) << ") to address 0x" << std::setw(4) << address
     //               << " | Read-back value: 0x" << std::setw(2) << static_cast<int>(readBackValue) 
@@ -1157,9 +1836,10 @@ void CPU6502::executeSTA(AddressingMode mode) {
     // }
 }
 
-void CPU6502::executeLDX(AddressingMode mode) {
-    uint16_t address = resolveAddress(mode);
-    X = (mode == AddressingMode::Immediate) ? read(address) : read(address);
+template <typename Mode>
+void CPU6502::executeLDX() {
+    uint16_t address = resolveAddress<Mode>();
+    X = readOperand<Mode>(address);
 
     // Update Zero and Negative flags
     updateZeroNegativeFlags(X);
@@ -1168,7 +1848,7 @@ void CPU6502::executeLDX(AddressingMode mode) {
     //     std::cout << "Executed LDX: Loaded X with value 0x" << std::hex << std::uppercase
     //               << static_cast<int>(X)
     //               << " from address 0x" << std::setw(4) << std::setfill('0') << address
-    //               << " | Value: 0x" << std::setw(2) << std::setfill('0') << static_cast<int>(read(address))
+    //               << " | Value: 0x" << std::setw(2) << std::setfill('0') << static_cast<int>(readOperand<Mode>(address))
     //               << std::endl;
     // }
 }
@@ -1183,7 +1863,7 @@ void CPU6502::executeTXS() {
 }
 
 void CPU6502::executeBPL() {
-    uint16_t targetAddress = resolveAddress(AddressingMode::Relative); // Use resolveAddress
+    uint16_t targetAddress = resolveAddress<Addressing::Relative>(); // Use resolveAddress
     if (!getFlag(StatusFlag::NEGATIVE_FLAG)) {           // Check if Negative Flag is clear
         uint16_t oldPC = PC;
         PC = targetAddress;                         // Apply the branch offset
@@ -1195,102 +1875,178 @@ void CPU6502::executeBPL() {
 }
 
 void CPU6502::updateZeroNegativeFlags(uint8_t value) {
-    // Update Zero flag
-    setFlag(StatusFlag::ZERO_FLAG, value == 0);
-
-    // Update Negative flag (7th bit of the value)
-    setFlag(StatusFlag::NEGATIVE_FLAG, value & (1 << 7));
+    // Both flags are derived from the value when they are read
+    flagResult = value;
 }
 
 
-uint8_t CPU6502::read(uint16_t address) const {
-    /* WRAM access: $0000 - $07FF */
-    if (address >= WRAM_STARTADDR && address < WRAM_ENDADDR) {
-        return WRAM[address];
+void CPU6502::mapMemoryPages() {
+    for (int page = 0; page < 256; ++page) {
+        mapMemoryPage(page);
     }
-    
-    /* WRAM mirrored access: $0800 - $1FFF */
-    if (address >= WRAM_MIRRORS_STARTADDR && address < WRAM_MIRRORS_ENDADDR) {
-        uint16_t mirror_address = address % (WRAM_ENDADDR - WRAM_STARTADDR);
-        return WRAM[mirror_address];
+
+    /* Cartridge ROM: read through the mapper's bank pointers so bank switches need no remapping */
+    PRGWindows = &busInterface->cpuPRGWindows();
+
+    /* Writes to RAM are no longer trapped: forget the code decoded from it */
+    for (int page = 0; page < (CARTRIDGE_ROM_STARTADDR >> 8); ++page) {
+        codePages[page] = false;
+        pageGeneration[page]++;
     }
+    currentBlock = nullptr;
+}
+
+void CPU6502::mapMemoryPage(uint8_t page) {
+    uint16_t address = page << 8;
 
-    /* PPU register access: $2000 - $2007 */
-    if (address >= PPU_REGISTERS_STARTADDR && address < PPU_REGISTERS_ENDADDR) {
-        return busInterface->cpuBusRead(address);
+    /* WRAM and its mirrors: $0000 - $1FFF */
+    if (address < WRAM_MIRRORS_ENDADDR) {
+        uint8_t* wramPage = WRAM.data() + (address % (WRAM_ENDADDR - WRAM_STARTADDR));
+        readPages[page] = wramPage;
+        writePages[page] = wramPage;
+        return;
     }
 
-    /* PPU register mirrored access: $2008 - $3FFF */
-    if (address >= PPU_MIRRORS_STARTADDR && address < PPU_MIRRORS_ENDADDR) {
-        uint16_t mirroredAddress = PPU_REGISTERS_STARTADDR + (address % 8);
-        return busInterface->cpuBusRead(mirroredAddress);
+    /* Cartridge space: direct pages where the bus exposes plain memory, I/O otherwise */
+    readPages[page] = busInterface->cpuReadPage(address);
+    writePages[page] = busInterface->cpuWritePage(address);
+}
+
+void CPU6502::mapPRGRAMPages() {
+    for (int page = CARTRIDGE_SRAM_STARTADDR >> 8; page < (CARTRIDGE_SRAM_ENDADDR >> 8); ++page) {
+        const uint8_t* codePage = readPages[page];
+        mapMemoryPage(page);
+        if (!codePages[page]) {
+            continue;
+        }
+
+        /* Same memory: keep trapping writes to the decoded code. Otherwise forget it */
+        if (readPages[page] == codePage) {
+            writePages[page] = nullptr;
+        } else {
+            codePages[page] = false;
+            pageGeneration[page]++;
+        }
     }
+}
 
-    /* APU and I/O register access: $4000 - $401F */
-    if (address >= APU_IO_STARTADDR && address < APU_IO_ENDADDR) {
-        return busInterface->cpuBusRead(address);
+uint8_t CPU6502::peek(uint16_t address) const {
+    if (address >= CARTRIDGE_ROM_STARTADDR) {
+        return (*PRGWindows)[(address >> 13) & 0x03][address & 0x1FFF];
     }
 
-    /* Cartridge SRAM space access: $6000 - $7FFF */
-    if (address >= CARTRIDGE_SRAM_STARTADDR && address < CARTRIDGE_SRAM_ENDADDR) {
-        return busInterface->cpuBusRead(address);
+    /* Registers are never read: reads of $2002, $2007 and $4015 change state */
+    const uint8_t* page = readPages[address >> 8];
+    return page ? page[address & 0xFF] : 0xFF;
+}
+
+uint64_t CPU6502::getInstructionCount() const {
+    return instructionCount;
+}
+
+size_t CPU6502::saveSnapshot(std::vector<uint8_t>& buffer) {
+    SnapshotWriter writer(buffer);
+    busInterface->saveState(writer);
+
+    CPUState state{instructionCount, PC, cycles, A, X, Y, SP, P, getStatusRegister(), nmiPending, irqPending, {}};
+    writer.beginSection(CPU_SECTION, CPU_SECTION_VERSION);
+    writer.write(state);
+    writer.writeBytes(WRAM.data(), WRAM.size());
+    writer.endSection();
+    return writer.finish();
+}
+
+void CPU6502::loadSnapshot(const uint8_t* data, size_t size) {
+    SnapshotReader reader(data, size);
+    busInterface->loadState(reader);
+
+    CPUState state;
+    reader.beginSection(CPU_SECTION, CPU_SECTION_VERSION);
+    reader.read(state);
+    reader.readBytes(WRAM.data(), WRAM.size());
+    reader.endSection();
+
+    instructionCount = state.instructionCount;
+    PC = state.PC;
+    cycles = state.cycles;
+    A = state.A;
+    X = state.X;
+    Y = state.Y;
+    SP = state.SP;
+    P = state.P;
+    setStatusRegister(state.statusReg);
+    nmiPending = state.nmiPending != 0;
+    irqPending = state.irqPending != 0;
+    idleLoop = IdleLoop{};
+
+    mapMemoryPages(); // WRAM and PRG-RAM were overwritten behind the decoded instructions
+}
+
+uint8_t CPU6502::read(uint16_t address) const {
+    /* Cartridge ROM access: $8000 - $FFFF */
+    if (address >= CARTRIDGE_ROM_STARTADDR) {
+        return (*PRGWindows)[(address >> 13) & 0x03][address & 0x1FFF];
     }
 
-    /* Cartridge ROM space access: $8000 - $FFFF */
-    if (address >= CARTRIDGE_ROM_STARTADDR && address <= CARTRIDGE_ROM_ENDADDR) {
-        return busInterface->cpuBusRead(address);
+    /* Memory-backed page: one lookup and one indexed read */
+    if (const uint8_t* page = readPages[address >> 8]) {
+        return page[address & 0xFF];
     }
 
-    /* Out of range read */
-    return 0xFF;
+    /* PPU, APU and I/O registers, and cartridge space without a direct page */
+    return busInterface->cpuBusRead(address);
 }
 
 void CPU6502::write(uint16_t address, uint8_t value) {
-    /* WRAM access: $0000 - $07FF */
-    if (address >= WRAM_STARTADDR && address < WRAM_ENDADDR) {
-        WRAM[address] = value;
+    /* Memory-backed page: one lookup and one indexed write */
+    if (uint8_t* page = writePages[address >> 8]) {
+        page[address & 0xFF] = value;
         return;
     }
 
-    /* WRAM mirrored access: $0800 - $1FFF */
-    if (address >= WRAM_MIRRORS_STARTADDR && address < WRAM_MIRRORS_ENDADDR) {
-        uint16_t mirror_address = address % (WRAM_ENDADDR - WRAM_STARTADDR);
-        WRAM[mirror_address] = value;
+    /* RAM page holding decoded code: drop its blocks, then write as usual */
+    if (codePages[address >> 8]) {
+        invalidateCode(address >> 8);
+        write(address, value);
         return;
     }
 
-    /* PPU register access: $2000 - $2007 */
-    if (address >= PPU_REGISTERS_STARTADDR && address < PPU_REGISTERS_ENDADDR) {
-        busInterface->cpuBusWrite(address, value);
+    /* OAM DMA: $4014 */
+    if (address == OAM_DMA_ADDR) {
+        OAMDMA(value);
         return;
     }
 
-    /* PPU register mirrored access: $2008 - $3FFF */
-    if (address >= PPU_MIRRORS_STARTADDR && address < PPU_MIRRORS_ENDADDR) {
-        uint16_t mirroredAddress = PPU_REGISTERS_STARTADDR + (address % 8);
-        busInterface->cpuBusWrite(mirroredAddress, value);
-        return;
-    }
+    /* PPU registers, APU, I/O and cartridge space without a direct page */
+    busInterface->cpuBusWrite(address, value);
 
-    /* APU and I/O register access: $4000 - $401F */
-    if (address >= APU_IO_STARTADDR && address < APU_IO_ENDADDR) {
-        busInterface->cpuBusWrite(address, value);
-        return;
+    /* A mapper register write may switch the bank the rest of the current block was decoded from,
+       and may enable, disable or write-protect PRG-RAM */
+    if (address >= CARTRIDGE_ROM_STARTADDR) {
+        mapPRGRAMPages();
+        currentBlock = nullptr;
     }
+}
 
-    /* Cartridge SRAM space access: $6000 - $7FFF */
-    if (address >= CARTRIDGE_SRAM_STARTADDR && address < CARTRIDGE_SRAM_ENDADDR) {
-        busInterface->cpuBusWrite(address, value);
-        return;
-    }
+void CPU6502::OAMDMA(uint8_t page) {
+    uint16_t base = page << 8;
 
-    /* Cartridge ROM space access: $8000 - $FFFF */
-    if (address >= CARTRIDGE_ROM_STARTADDR && address <= CARTRIDGE_ROM_ENDADDR) {
-        // ROM write ignored
-        return;
+    /* Copy straight from memory-backed pages; I/O pages are read one byte at a time */
+    const uint8_t* source = readPages[page];
+    if (!source && base >= CARTRIDGE_ROM_STARTADDR) {
+        source = (*PRGWindows)[(base >> 13) & 0x03] + (base & 0x1F00);
+    }
+    uint8_t buffer[256];
+    if (!source) {
+        for (int i = 0; i < 256; ++i) {
+            buffer[i] = read(base + i);
+        }
+        source = buffer;
     }
+    busInterface->cpuOAMDMA(source);
 
-    /* Out of range write */
+    /* 256 read/write pairs plus a halt cycle, and one more to align when starting on an odd cycle */
+    cycles += 513 + ((busInterface->getCPUCycle() + cycles) & 1);
 }
 
 
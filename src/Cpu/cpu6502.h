@@ -10,10 +10,13 @@
 #define CPU6502_H
 
 #include "cpu6502_types.h"
+#include "cpu6502_trace.h"
 #include <memory>
 #include <cstdint>
 #include "Bus/businterface.h"
 #include <vector>
+#include <array>
+#include <utility>
 
 /**
  * @class CPU6502
@@ -37,25 +40,107 @@ public:
      */
     CPU6502() = delete;
 
+    /**
+     * @brief Deleted copy operations: the page table points into this instance's WRAM.
+     */
+    CPU6502(const CPU6502&) = delete;
+    CPU6502& operator=(const CPU6502&) = delete;
+
     /**
      * @brief Resets the CPU state, initializing registers and loading the reset vector.
      */
     void reset();
 
     /**
-     * @brief Executes a single instruction, fetching, decoding, and executing it.
+     * @brief Advances the CPU by a single cycle.
+     *
+     * A whole instruction is fetched and executed on its first cycle; the
+     * remaining cycles of the instruction are idle calls.
      */
     void step();
 
+    /**
+     * @brief Executes whole instructions against a cycle budget, keeping the PPU in step.
+     *
+     * The PPU is caught up once per instruction instead of once per cycle.
+     * Returns early as soon as the PPU completes a frame.
+     *
+     * @param budget Minimum number of CPU cycles to run; the last instruction may overshoot it.
+     * @return The number of CPU cycles actually executed.
+     */
+    uint32_t runCycles(uint32_t budget);
+
+    /**
+     * @brief Executes whole instructions until the PPU completes the current frame.
+     * @return The number of CPU cycles executed.
+     */
+    uint32_t runUntilFrame();
+
     /**
      * @brief Gets the current value of the Program Counter (PC).
      * @return The 16-bit value of the Program Counter.
      */
     uint16_t getPC() const;
 
+    /**
+     * @brief Reads memory without side effects, for test harnesses and debuggers.
+     * @param address The address to read.
+     * @return The byte at the address, or 0xFF for I/O registers and unmapped space.
+     */
+    uint8_t peek(uint16_t address) const;
+
+    /**
+     * @brief Gets the number of instructions executed since power-on (interrupt sequences excluded).
+     * @return The instruction count.
+     */
+    uint64_t getInstructionCount() const;
+
+    /**
+     * @brief Saves the whole machine (cartridge, bus, PPU, APU and CPU) as a snapshot.
+     *
+     * Call between instructions, e.g. after runUntilFrame(). The buffer is
+     * reused: once it has grown to the snapshot size, saving allocates nothing.
+     *
+     * @param buffer Receives the snapshot; its previous contents are discarded.
+     * @return The snapshot size in bytes.
+     */
+    size_t saveSnapshot(std::vector<uint8_t>& buffer);
+
+    /**
+     * @brief Restores a snapshot written by saveSnapshot() for the same ROM.
+     *
+     * Malformed snapshots, snapshots of another format version and snapshots
+     * of another cartridge raise std::runtime_error.
+     *
+     * @param data The snapshot.
+     * @param size Size of the snapshot in bytes.
+     */
+    void loadSnapshot(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Rebuilds the CPU page table from WRAM and the pages exposed by the bus.
+     *
+     * reset() and loadSnapshot() call it; call it otherwise only when the
+     * memory the bus exposes at $4020-$7FFF changes. PRG ROM bank switches
+     * need no remapping: ROM is read through the mapper's PRGWindows.
+     * Instructions decoded from RAM are dropped.
+     */
+    void mapMemoryPages();
+
+    /**
+     * @brief Attaches a sink receiving one record per executed instruction.
+     * @param sink The trace sink, or nullptr to stop tracing. Ignored unless VERBOSE is enabled.
+     */
+    void setTraceSink(std::shared_ptr<TraceSink> sink);
+
     void triggerNMI();
     void triggerIRQ();
 private:
+    /**
+     * @brief Optional sink recording executed instructions.
+     */
+    std::shared_ptr<TraceSink> traceSink;
+
     /**
      * @brief Shared pointer to the BusInterface instance.
      * Used for memory reads and writes as well as device communication.
@@ -73,9 +158,20 @@ private:
     ///@}
 
     /**
-     * @brief Internal CPU status register for managing flags.
+     * @brief Internal CPU status register: the interrupt disable, decimal, break and unused flags.
+     *
+     * N, Z, C and V change on almost every instruction, so they are kept
+     * lazily below as the values they derive from and only assembled into a
+     * byte when a branch, PHP, BRK or an interrupt asks for them.
      */
-    uint8_t statusReg;
+    uint8_t statusReg = 0x34;
+
+    /** @name Lazy Status Flags */
+    ///@{
+    uint16_t flagResult = 1;  /**< Last result: Z is set if the low byte is 0, N is bit 7 of either byte (the high byte only for BIT). */
+    uint8_t flagCarry = 0;    /**< C, as 0 or 1. */
+    uint8_t flagOverflow = 0; /**< V is bit 7: the sign-overflow term of the last ADC/SBC, or bit 6 of a BIT operand shifted up. */
+    ///@}
 
     /**
      * @brief Sets or clears a specific status flag.
@@ -102,6 +198,37 @@ private:
      */
     std::vector<uint8_t> WRAM;
 
+    /**
+     * @brief Direct read pointers for each 256-byte page of the CPU address space.
+     * A null entry marks an I/O page that is routed through the BusInterface.
+     */
+    std::array<const uint8_t*, 256> readPages{};
+
+    /**
+     * @brief Direct write pointers for each 256-byte page of the CPU address space.
+     * A null entry marks an I/O or read-only page that is routed through the BusInterface.
+     */
+    std::array<uint8_t*, 256> writePages{};
+
+    /**
+     * @brief The cartridge mapper's 8 KB PRG window pointers for $8000-$FFFF.
+     * Owned by the mapper and updated in place when it switches banks.
+     */
+    const std::array<const uint8_t*, 4>* PRGWindows = nullptr;
+
+    /**
+     * @brief Points one page of the page table at WRAM or at the page the bus exposes.
+     * @param page The CPU page.
+     */
+    void mapMemoryPage(uint8_t page);
+
+    /**
+     * @brief Remaps $6000-$7FFF after a mapper register write, which may enable, disable or protect PRG-RAM.
+     *
+     * Code decoded from PRG-RAM is dropped if its page is no longer readable there.
+     */
+    void mapPRGRAMPages();
+
     /**
      * @brief Reads a byte from the specified memory address.
      * @param address The memory address to read from.
@@ -117,16 +244,237 @@ private:
     void write(uint16_t address, uint8_t data);
 
     /**
-     * @brief Number of cycles remaining for the current instruction.
+     * @brief Number of cycles remaining for the current instruction, including any DMA stall.
+     */
+    uint16_t cycles = 0;
+
+    /**
+     * @brief Executes the next instruction, or services a pending interrupt.
+     * @return The number of cycles taken, including page-crossing and branch penalties and DMA stalls.
+     */
+    uint16_t runInstruction();
+
+    /**
+     * @struct IdleLoop
+     * @brief The loop last jumped back into, watched for spinning without effect (see skipIdleLoop()).
+     */
+    struct IdleLoop {
+        uint16_t head = 0;              /**< Address of the first instruction of the loop. */
+        uint16_t tail = 0;              /**< Address of the branch or jump back to head. */
+        bool idle = false;              /**< The body only reads memory and PPUSTATUS. */
+        bool readsPPUStatus = false;    /**< The body reads PPUSTATUS. */
+        uint8_t length = 0;             /**< Instructions per pass, the jump back included. */
+        uint8_t passes = 0;             /**< Consecutive passes watched. */
+        uint64_t instructionCount = 0;  /**< Instruction count at the last visit of head. */
+        uint64_t cycle = 0;             /**< Master clock at the last visit of head. */
+        uint64_t horizon = 0;           /**< CPU cycle of the first event that may change what the body reads. */
+        uint8_t A = 0, X = 0, Y = 0, status = 0; /**< Registers at the last visit of head; status as getStatusRegister(). */
+    };
+
+    /**
+     * @brief Loop watched for idling.
+     */
+    IdleLoop idleLoop;
+
+    /**
+     * @brief Fast-forwards a loop that spins without effect until the next event that can end it.
+     *
+     * Called when an instruction jumped a short way back to PC. A loop whose
+     * straight-line body only loads, compares and tests memory or PPUSTATUS
+     * is watched; once two consecutive passes leave the registers unchanged,
+     * every further pass would repeat them until an interrupt is raised or
+     * PPUSTATUS changes. Those passes are skipped as a whole, so cycle and
+     * instruction counts are exactly those of running them.
+     *
+     * @param tail Address of the instruction that jumped back.
+     * @param budget CPU cycles left in the run; the skip stays below it.
+     * @return The number of CPU cycles skipped, for the caller to clock the PPU by.
+     */
+    uint32_t skipIdleLoop(uint16_t tail, uint32_t budget);
+
+    /**
+     * @brief Checks that the loop from head to tail can idle, filling in idleLoop.
+     * @return True if the body only reads memory and PPUSTATUS and tail jumps back to head.
      */
-    uint8_t cycles;
+    bool decodeIdleLoop();
+
+    /**
+     * @brief Performs an OAM DMA: copies a 256-byte page to PPU OAM and stalls the CPU.
+     *
+     * The page is copied in one block from its direct pointer where it has
+     * one (WRAM, PRG-RAM, PRG-ROM); only I/O pages are read byte by byte.
+     *
+     * @param page High byte of the source address.
+     */
+    void OAMDMA(uint8_t page);
 
     /**
      * @brief Resolves the effective memory address based on the addressing mode.
-     * @param mode The addressing mode to decode.
+     * @tparam Mode The addressing mode policy to decode.
+     * @tparam PageCrossPenalty Whether crossing a page while indexing adds a cycle (read instructions only).
      * @return The resolved memory address.
      */
-    uint16_t resolveAddress(AddressingMode mode);
+    template <typename Mode, bool PageCrossPenalty = Mode::pageCrossPenalty>
+    uint16_t resolveAddress();
+
+    /**
+     * @brief Reads an instruction operand, bypassing the memory map for zero-page modes.
+     * @tparam Mode The addressing mode policy the address was resolved with.
+     * @param address The resolved operand address.
+     * @return The operand byte.
+     */
+    template <typename Mode>
+    uint8_t readOperand(uint16_t address) const;
+
+    /**
+     * @brief Writes an instruction result, bypassing the memory map for zero-page modes.
+     * @tparam Mode The addressing mode policy the address was resolved with.
+     * @param address The resolved operand address.
+     * @param value The byte to write.
+     */
+    template <typename Mode>
+    void writeOperand(uint16_t address, uint8_t value);
+
+    /** @name Instruction Dispatch */
+    ///@{
+
+    /**
+     * @brief Handler executing one fully decoded opcode.
+     */
+    using OpcodeHandler = void (*)(CPU6502&);
+
+    /**
+     * @brief Per-opcode handlers, indexed by opcode byte.
+     *
+     * Generated at compile time from OPCODE_TABLE; used when TABLE_DISPATCH is enabled in config.h.
+     */
+    static const std::array<OpcodeHandler, 256> DISPATCH_TABLE;
+
+    /**
+     * @brief Builds the dispatch table from a sequence of opcodes.
+     * @return One specialised handler per opcode.
+     */
+    template <std::size_t... Opcodes>
+    static constexpr std::array<OpcodeHandler, 256> buildDispatchTable(std::index_sequence<Opcodes...>);
+
+    /**
+     * @brief Executes a single opcode with its instruction and addressing mode fixed at compile time.
+     * @tparam Opcode The opcode byte this handler is specialised for.
+     * @param cpu The CPU executing the instruction.
+     */
+    template <uint8_t Opcode>
+    static void executeOpcode(CPU6502& cpu);
+
+    /**
+     * @brief Calls the implementation of an instruction selected at compile time.
+     * @tparam Op The instruction to execute.
+     * @tparam Mode The addressing mode policy of the instruction.
+     */
+    template <Instruction Op, typename Mode>
+    void executeInstruction();
+
+    /**
+     * @brief Executes an instruction through the legacy run-time switch.
+     * @param info The decoded opcode information.
+     */
+    void dispatchSwitch(const OpcodeInfo& info);
+
+    /**
+     * @brief Selects the addressing mode policy of an instruction through a run-time switch.
+     * @tparam Op The instruction to execute.
+     * @param mode The addressing mode of the instruction.
+     */
+    template <Instruction Op>
+    void dispatchMode(AddressingMode mode);
+    ///@}
+
+    /** @name Decoded Instruction Cache */
+    ///@{
+
+    static constexpr size_t BLOCK_CACHE_SIZE = 2048; /**< Blocks in the direct-mapped cache. */
+    static constexpr size_t BLOCK_LINE_SIZE = 16;    /**< Blocks end at line boundaries, so a line holds at most this many instructions. */
+
+    /**
+     * @struct DecodedInstruction
+     * @brief An instruction decoded once: its handler, operand bytes and base cycles.
+     */
+    struct DecodedInstruction {
+        OpcodeHandler handler; /**< Handler specialised for the opcode. */
+        uint16_t operand;      /**< Operand bytes, little-endian; 0 if there are none. */
+        uint8_t opcode;        /**< Opcode byte, for tracing and the legacy switch. */
+        uint8_t cycles;        /**< Base cycle count. */
+        uint8_t length;        /**< Instruction size in bytes, opcode included. */
+    };
+
+    /**
+     * @struct DecodedBlock
+     * @brief Straight-line instructions decoded from one BLOCK_LINE_SIZE-byte line, up to the first jump or branch.
+     *
+     * Ending blocks at fixed line boundaries rather than after a number of
+     * instructions keeps the blocks of straight-line code the same however
+     * it was entered, e.g. on returning from an interrupt in its middle.
+     */
+    struct DecodedBlock {
+        const uint8_t* code = nullptr; /**< Host address of the first instruction: identifies the PRG bank or RAM page. */
+        uint16_t address = 0;          /**< CPU address of the first instruction. */
+        uint8_t count = 0;             /**< Instructions decoded. */
+        uint32_t generation = 0;       /**< pageGeneration of the page when it was decoded. */
+        std::array<DecodedInstruction, BLOCK_LINE_SIZE> instructions; /**< The instructions, in order. */
+    };
+
+    /**
+     * @brief Blocks indexed by a hash of their address; a slot is redecoded when its tag does not match.
+     */
+    std::vector<DecodedBlock> blockCache;
+
+    /**
+     * @brief Per CPU page, bumped whenever the code in the page may have changed.
+     */
+    std::array<uint32_t, 256> pageGeneration{};
+
+    /**
+     * @brief RAM pages that blocks were decoded from. Their writes are routed through write() and invalidate them.
+     */
+    std::array<bool, 256> codePages{};
+
+    const DecodedBlock* currentBlock = nullptr; // Block being executed, if any
+    uint8_t blockIndex = 0;                     // Index of its next instruction
+    uint16_t blockNextPC = 0;                   // Address of its next instruction
+    DecodedInstruction uncached{};              // Instruction decoded outside the cache
+    uint16_t operand = 0;                       // Operand bytes of the instruction being executed
+
+    /**
+     * @brief Gets the decoded instruction at PC, from the block being executed, the cache, or by decoding it.
+     *
+     * Blocks are tagged with the host address of their code, so a bank
+     * switch selects other blocks and switching back finds the old ones.
+     * Code in I/O space and in the zero page (whose writes bypass write())
+     * is decoded on every execution.
+     *
+     * @return The instruction, valid until the next call.
+     */
+    const DecodedInstruction& fetchInstruction();
+
+    /**
+     * @brief Decodes a block starting at PC into a cache slot.
+     * @param block The slot.
+     * @param code Host address of the instruction at PC.
+     * @return False if not even the first instruction fits in the page.
+     */
+    bool decodeBlock(DecodedBlock& block, const uint8_t* code);
+
+    /**
+     * @brief Drops the blocks decoded from a RAM page and stops trapping its writes.
+     * @param page The CPU page written to; its mirrors are dropped too.
+     */
+    void invalidateCode(uint8_t page);
+
+    /**
+     * @brief Consumes the next operand byte of the instruction being executed and advances PC over it.
+     * @return The operand byte, fetched when the instruction was decoded.
+     */
+    uint8_t fetchOperand();
+    ///@}
 
     /**
      * @brief Pushes a value onto the stack.
@@ -145,9 +493,10 @@ private:
 
     /**
      * @brief Executes the LDA (Load Accumulator) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeLDA(AddressingMode mode);
+    template <typename Mode>
+    void executeLDA();
 
     /**
      * @brief Executes the SEI (Set Interrupt Disable) instruction.
@@ -161,15 +510,17 @@ private:
 
     /**
      * @brief Executes the STA (Store Accumulator) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeSTA(AddressingMode mode);
+    template <typename Mode>
+    void executeSTA();
 
     /**
      * @brief Executes the LDX (Load X Register) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeLDX(AddressingMode mode);
+    template <typename Mode>
+    void executeLDX();
 
     /**
      * @brief Executes the TXS (Transfer X to Stack Pointer) instruction.
@@ -183,15 +534,17 @@ private:
 
     /**
      * @brief Executes the LDY (Load Y Register) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeLDY(AddressingMode mode);
+    template <typename Mode>
+    void executeLDY();
 
     /**
      * @brief Executes the CMP (Compare Accumulator) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeCMP(AddressingMode mode);
+    template <typename Mode>
+    void executeCMP();
 
     /**
      * @brief Executes the BCS (Branch if Carry Set) instruction.
@@ -200,15 +553,17 @@ private:
 
     /**
      * @brief Executes the STX (Store X Register) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeSTX(AddressingMode mode);
+    template <typename Mode>
+    void executeSTX();
 
     /**
      * @brief Executes the STY (Store Y Register) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeSTY(AddressingMode mode);
+    template <typename Mode>
+    void executeSTY();
 
     /**
      * @brief Executes the TAX (Transfer Accumulator to X) instruction.
@@ -257,51 +612,59 @@ private:
 
     /**
      * @brief Executes the AND (Logical AND) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeAND(AddressingMode mode);
+    template <typename Mode>
+    void executeAND();
 
     /**
      * @brief Executes the ORA (Logical OR) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeORA(AddressingMode mode);
+    template <typename Mode>
+    void executeORA();
 
     /**
      * @brief Executes the EOR (Exclusive OR) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeEOR(AddressingMode mode);
+    template <typename Mode>
+    void executeEOR();
 
     /**
      * @brief Executes the ADC (Add with Carry) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeADC(AddressingMode mode);
+    template <typename Mode>
+    void executeADC();
 
     /**
      * @brief Executes the SBC (Subtract with Carry) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeSBC(AddressingMode mode);
+    template <typename Mode>
+    void executeSBC();
 
     /**
      * @brief Executes the CPX (Compare X Register) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeCPX(AddressingMode mode);
+    template <typename Mode>
+    void executeCPX();
 
     /**
      * @brief Executes the CPY (Compare Y Register) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeCPY(AddressingMode mode);
+    template <typename Mode>
+    void executeCPY();
 
     /**
      * @brief Executes the INC (Increment Memory) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeINC(AddressingMode mode);
+    template <typename Mode>
+    void executeINC();
 
     /**
      * @brief Executes the INX (Increment X Register) instruction.
@@ -315,9 +678,10 @@ private:
 
     /**
      * @brief Executes the DEC (Decrement Memory) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeDEC(AddressingMode mode);
+    template <typename Mode>
+    void executeDEC();
 
     /**
      * @brief Executes the DEX (Decrement X Register) instruction.
@@ -331,33 +695,38 @@ private:
 
     /**
      * @brief Executes the ASL (Arithmetic Shift Left) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeASL(AddressingMode mode);
+    template <typename Mode>
+    void executeASL();
 
     /**
      * @brief Executes the LSR (Logical Shift Right) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeLSR(AddressingMode mode);
+    template <typename Mode>
+    void executeLSR();
 
     /**
      * @brief Executes the ROL (Rotate Left) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeROL(AddressingMode mode);
+    template <typename Mode>
+    void executeROL();
 
     /**
      * @brief Executes the ROR (Rotate Right) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeROR(AddressingMode mode);
+    template <typename Mode>
+    void executeROR();
 
     /**
      * @brief Executes the JMP (Jump) instruction.
-     * @param mode The addressing mode of the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeJMP(AddressingMode mode);
+    template <typename Mode>
+    void executeJMP();
 
     /**
      * @brief Executes the JSR (Jump to Subroutine) instruction.
@@ -438,152 +807,172 @@ private:
      * @brief Executes the NOP (No Operation) instruction.
      * @details This instruction performs no operation and advances the program counter.
      *          Often used as padding or timing adjustments in program code.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeNOP(AddressingMode mode);
+    template <typename Mode>
+    void executeNOP();
     ///@}
 
     /**
      * @brief Executes the SLO (Shift Left and OR) instruction.
      * @details Combines ASL (Arithmetic Shift Left) and ORA (Logical Inclusive OR) operations.
      *          Shifts the operand left by 1 bit and ORs the result with the accumulator.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeSLO(AddressingMode mode);
+    template <typename Mode>
+    void executeSLO();
 
     /**
      * @brief Executes the SAX (Store A AND X) instruction.
      * @details Stores the bitwise AND of the accumulator (A) and the X register into memory.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeSAX(AddressingMode mode);
+    template <typename Mode>
+    void executeSAX();
     
     /**
      * @brief Executes the DCP (Decrement and Compare) instruction.
      * @details Decrements a memory value by 1 and compares the result with the accumulator (A).
      *          Updates flags based on the comparison.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeDCP(AddressingMode mode);
+    template <typename Mode>
+    void executeDCP();
 
     /**
      * @brief Executes the RLA (Rotate Left and AND) instruction.
      * @details Combines ROL (Rotate Left) and AND operations. Rotates the operand left by 1 bit,
      *          then ANDs the result with the accumulator.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeRLA(AddressingMode mode);
+    template <typename Mode>
+    void executeRLA();
 
     /**
      * @brief Executes the ISC (Increment and Subtract with Carry) instruction.
      * @details Increments a memory value by 1, then subtracts it (with the carry flag) from the accumulator.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeISC(AddressingMode mode);
+    template <typename Mode>
+    void executeISC();
 
     /**
      * @brief Executes the RRA (Rotate Right and Add) instruction.
      * @details Combines ROR (Rotate Right) and ADC (Add with Carry). Rotates the operand right by 1 bit,
      *          then adds it (with the carry flag) to the accumulator.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeRRA(AddressingMode mode);
+    template <typename Mode>
+    void executeRRA();
 
     /**
      * @brief Executes the LAX (Load A and X) instruction.
      * @details Loads a memory value into both the accumulator (A) and the X register.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeLAX(AddressingMode mode);
+    template <typename Mode>
+    void executeLAX();
 
     /**
      * @brief Executes the TAS (Transfer A AND X to Stack Pointer) instruction.
      * @details Sets the stack pointer (SP) to the bitwise AND of the accumulator (A) and the X register.
      *          Stores a value in memory based on the high byte of the effective address.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeTAS(AddressingMode mode);
+    template <typename Mode>
+    void executeTAS();
 
     /**
      * @brief Executes the ANC (AND and Compare) instruction.
      * @details Performs a bitwise AND between the accumulator (A) and an immediate value,
      *          then updates the carry flag based on the result.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeANC(AddressingMode mode); 
+    template <typename Mode>
+    void executeANC();
     
     /**
      * @brief Executes the ALR (AND and Logical Shift Right) instruction.
      * @details Performs a bitwise AND between the accumulator (A) and an immediate value,
      *          then shifts the result one bit to the right.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeALR(AddressingMode mode); 
+    template <typename Mode>
+    void executeALR();
     
     /**
      * @brief Executes the ARR (AND and Rotate Right) instruction.
      * @details Combines AND and ROR (Rotate Right) operations on the accumulator (A).
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeARR(AddressingMode mode); 
+    template <typename Mode>
+    void executeARR();
     
     /**
      * @brief Executes the XAA (Transfer X AND A) instruction.
      * @details Transfers the bitwise AND of the X register and the accumulator (A) into A.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeXAA(AddressingMode mode); 
+    template <typename Mode>
+    void executeXAA();
     
     /**
      * @brief Executes the AHX (Store A AND X and High Byte) instruction.
      * @details Stores the bitwise AND of A and X with the high byte of the effective address.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeAHX(AddressingMode mode); 
+    template <typename Mode>
+    void executeAHX();
     
     /**
      * @brief Executes the LAS (Load A, X, and SP) instruction.
      * @details Loads a memory value into A, X, and the stack pointer (SP).
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeLAS(AddressingMode mode); 
+    template <typename Mode>
+    void executeLAS();
     
     /**
      * @brief Executes the SHX (Store X and High Byte) instruction.
      * @details Stores the bitwise AND of the X register with the high byte of the effective address.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeSHX(AddressingMode mode);
+    template <typename Mode>
+    void executeSHX();
 
     /**
      * @brief Executes the SRE (Shift Right and Exclusive OR) instruction.
      * @details Combines LSR (Logical Shift Right) and EOR (Exclusive OR). Shifts the operand right by 1 bit,
      *          then XORs the result with the accumulator.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeSRE(AddressingMode mode);
+    template <typename Mode>
+    void executeSRE();
 
     /**
      * @brief Executes the SHY (Store Y and High Byte) instruction.
      * @details Stores the bitwise AND of the Y register with the high byte of the effective address.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeSHY(AddressingMode mode);
+    template <typename Mode>
+    void executeSHY();
 
     /**
      * @brief Executes the AXS (AND X with Immediate and Store) instruction.
      * @details Performs a bitwise AND between the X register and an immediate value, then stores the result.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeAXS(AddressingMode mode);
+    template <typename Mode>
+    void executeAXS();
 
     /**
      * @brief Executes the BIT (Bit Test) instruction.
      * @details Tests bits in a memory location against the accumulator (A) without modifying A.
      *          Updates the Zero (Z), Negative (N), and Overflow (V) flags based on the result.
-     * @param mode The addressing mode used by the instruction.
+     * @tparam Mode The addressing mode policy of the instruction.
      */
-    void executeBIT(AddressingMode mode);
+    template <typename Mode>
+    void executeBIT();
 
     /**
      * @brief Gets the current processor status register.
@@ -599,8 +988,20 @@ private:
 
     void handleInterrupt(uint16_t vectorAddress);
 
+    /**
+     * @brief Checks that the IRQ line is still asserted before the IRQ is taken.
+     *
+     * IRQ is a level: irqPending only records that a source raised it since
+     * the line was last seen high. It is dropped once every source has been
+     * acknowledged, so an IRQ acknowledged while masked is never taken.
+     *
+     * @return True if the APU or the mapper still asserts the line.
+     */
+    bool pollIRQ();
+
     bool nmiPending = false;
-    bool irqPending = false;
+    bool irqPending = false; // An IRQ source raised the line; see pollIRQ()
+    uint64_t instructionCount = 0; // Instructions executed since power-on
 };
 
 #endif // CPU6502_H
@@ -21,6 +21,12 @@ constexpr uint16_t PPU_MIRRORS_ENDADDR = 0x4000;     /**< End address of PPU reg
 
 constexpr uint16_t APU_IO_STARTADDR = 0x4000; /**< Start address of APU and I/O registers. */
 constexpr uint16_t APU_IO_ENDADDR = 0x4020;   /**< End address of APU and I/O registers (exclusive). */
+constexpr uint16_t APU_CHANNELS_ENDADDR = 0x4014; /**< End address of the APU channel registers (exclusive). */
+constexpr uint16_t OAM_DMA_ADDR = 0x4014;     /**< OAM DMA register: copies a 256-byte page into PPU OAM. */
+constexpr uint16_t APU_STATUS_ADDR = 0x4015;  /**< APU channel enable (write) and status (read) register. */
+constexpr uint16_t CONTROLLER1_ADDR = 0x4016;  /**< Controller 1 data (read) and strobe for both controllers (write). */
+constexpr uint16_t CONTROLLER2_ADDR = 0x4017;  /**< Controller 2 data (read). */
+constexpr uint16_t APU_FRAME_COUNTER_ADDR = 0x4017; /**< APU frame counter register (write only). */
 
 constexpr uint16_t CARTRIDGE_SRAM_STARTADDR = 0x6000; /**< Start address of cartridge SRAM. */
 constexpr uint16_t CARTRIDGE_SRAM_ENDADDR = 0x8000;   /**< End address of cartridge SRAM (exclusive). */
@@ -0,0 +1,55 @@
+#include "cpu6502_trace.h"
+#include <iomanip>
+#include <stdexcept>
+
+TraceRingBuffer::TraceRingBuffer(size_t capacity)
+    : records(capacity), head(0), count(0)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("Trace buffer capacity must be non-zero.");
+    }
+}
+
+void TraceRingBuffer::record(const TraceRecord& record)
+{
+    records[head] = record;
+    head = (head + 1) % records.size();
+    if (count < records.size()) {
+        ++count;
+    }
+}
+
+void TraceRingBuffer::dump(std::ostream& out) const
+{
+    std::ios_base::fmtflags flags = out.flags();
+    char fill = out.fill('0');
+
+    // Oldest record sits right after the newest once the buffer has wrapped
+    size_t index = (head + records.size() - count) % records.size();
+    for (size_t i = 0; i < count; ++i) {
+        const TraceRecord& r = records[index];
+        out << std::hex << std::uppercase
+            << "PC: " << std::setw(4) << static_cast<int>(r.PC)
+            << "  OP: " << std::setw(2) << static_cast<int>(r.opcode)
+            << "  A: " << std::setw(2) << static_cast<int>(r.A)
+            << "  X: " << std::setw(2) << static_cast<int>(r.X)
+            << "  Y: " << std::setw(2) << static_cast<int>(r.Y)
+            << "  SP: " << std::setw(2) << static_cast<int>(r.SP)
+            << "  P: " << std::setw(2) << static_cast<int>(r.P) << '\n';
+        index = (index + 1) % records.size();
+    }
+
+    out.fill(fill);
+    out.flags(flags);
+}
+
+size_t TraceRingBuffer::size() const
+{
+    return count;
+}
+
+void TraceRingBuffer::clear()
+{
+    head = 0;
+    count = 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file cpu6502_trace.h
+ * @brief Defines the instruction trace sink used to record CPU execution.
+ */
+
+#ifndef CPU6502_TRACE_H
+#define CPU6502_TRACE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+/**
+ * @struct TraceRecord
+ * @brief CPU state captured before executing a single instruction.
+ */
+struct TraceRecord {
+    uint16_t PC;    /**< Address of the instruction. */
+    uint8_t opcode; /**< Opcode byte fetched at PC. */
+    uint8_t A;      /**< Accumulator register. */
+    uint8_t X;      /**< X Index register. */
+    uint8_t Y;      /**< Y Index register. */
+    uint8_t SP;     /**< Stack Pointer register. */
+    uint8_t P;      /**< Processor Status register. */
+};
+
+/**
+ * @class TraceSink
+ * @brief Interface receiving one TraceRecord per executed instruction.
+ *
+ * The CPU only calls into a sink when VERBOSE is enabled in config.h;
+ * otherwise tracing is compiled out of the instruction loop.
+ */
+class TraceSink {
+public:
+    /**
+     * @brief Virtual destructor for the base class.
+     */
+    virtual ~TraceSink() = default;
+
+    /**
+     * @brief Records the state of the CPU before an instruction executes.
+     * @param record The captured CPU state.
+     */
+    virtual void record(const TraceRecord& record) = 0;
+};
+
+/**
+ * @class TraceRingBuffer
+ * @brief Trace sink keeping the most recent records in a preallocated binary ring buffer.
+ *
+ * Recording is a plain copy into the buffer; records are only formatted as text when dumped.
+ */
+class TraceRingBuffer : public TraceSink {
+public:
+    /**
+     * @brief Deleted default constructor.
+     */
+    TraceRingBuffer() = delete;
+
+    /**
+     * @brief Constructs a ring buffer holding up to the given number of records.
+     * @param capacity Maximum number of records kept; older records are overwritten.
+     */
+    explicit TraceRingBuffer(size_t capacity);
+
+    void record(const TraceRecord& record) override;
+
+    /**
+     * @brief Formats the buffered records, oldest first.
+     * @param out Stream receiving one line per record.
+     */
+    void dump(std::ostream& out) const;
+
+    /**
+     * @brief Gets the number of records currently buffered.
+     * @return The number of records, at most the capacity.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Discards all buffered records.
+     */
+    void clear();
+
+private:
+    std::vector<TraceRecord> records; /**< Preallocated record storage. */
+    size_t head;                      /**< Index of the next record to write. */
+    size_t count;                     /**< Number of valid records. */
+};
+
+#endif // CPU6502_TRACE_H
@@ -52,6 +52,47 @@ enum class AddressingMode : uint8_t {
     ZeroPage, ZeroPageX, ZeroPageY, ZeroPageIndirect, INVALID
 };
 
+/**
+ * @namespace Addressing
+ * @brief Compile-time addressing mode policies used to specialise instruction handlers.
+ */
+namespace Addressing {
+
+/**
+ * @struct Mode
+ * @brief Addressing mode policy carrying the static properties of a mode.
+ * @tparam M The addressing mode described by the policy.
+ */
+template <AddressingMode M>
+struct Mode {
+    static constexpr AddressingMode mode = M; /**< The addressing mode. */
+
+    /** Indexing across a page boundary costs an extra cycle on reads. */
+    static constexpr bool pageCrossPenalty =
+        M == AddressingMode::AbsoluteX || M == AddressingMode::AbsoluteY || M == AddressingMode::IndirectY;
+
+    /** The effective address always lies in the zero page ($0000-$00FF). */
+    static constexpr bool zeroPage =
+        M == AddressingMode::ZeroPage || M == AddressingMode::ZeroPageX || M == AddressingMode::ZeroPageY;
+};
+
+using Accumulator = Mode<AddressingMode::Accumulator>;
+using Absolute = Mode<AddressingMode::Absolute>;
+using AbsoluteX = Mode<AddressingMode::AbsoluteX>;
+using AbsoluteY = Mode<AddressingMode::AbsoluteY>;
+using Immediate = Mode<AddressingMode::Immediate>;
+using Implied = Mode<AddressingMode::Implied>;
+using Indirect = Mode<AddressingMode::Indirect>;
+using IndirectX = Mode<AddressingMode::IndirectX>;
+using IndirectY = Mode<AddressingMode::IndirectY>;
+using Relative = Mode<AddressingMode::Relative>;
+using ZeroPage = Mode<AddressingMode::ZeroPage>;
+using ZeroPageX = Mode<AddressingMode::ZeroPageX>;
+using ZeroPageY = Mode<AddressingMode::ZeroPageY>;
+using ZeroPageIndirect = Mode<AddressingMode::ZeroPageIndirect>;
+
+} // namespace Addressing
+
 /**
  * @struct OpcodeInfo
  * @brief Contains information for a single opcode, including instruction, addressing mode, and cycle count.
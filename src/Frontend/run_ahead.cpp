@@ -0,0 +1,195 @@
+#include "run_ahead.h"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+using Clock = std::chrono::steady_clock;
+
+/* Weight of the newest frame in the timing averages: about half a second of history */
+constexpr double TIMING_SMOOTHING = 1.0 / 32;
+
+static double milliseconds(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+RunAhead::Machine::Machine(const std::string& romPath, SaveRAMMode saveMode) {
+    cartridge = std::make_shared<Cartridge>(romPath, RomLoadMode::MemoryMap, saveMode);
+    ppu = std::make_shared<PPU>();
+    apu = std::make_shared<APU>();
+    bus = std::make_shared<BusInterface>(cartridge, ppu, apu);
+    cpu = std::make_shared<CPU6502>(bus);
+
+    // Raw pointer: a shared_ptr captured by the PPU would form a cycle through the bus and leak the instance
+    CPU6502* processor = cpu.get();
+    ppu->setNMICallback([processor] { processor->triggerNMI(); });
+    ppu->setIRQCallback([processor] { processor->triggerIRQ(); });
+    apu->setIRQCallback([processor] { processor->triggerIRQ(); });
+    ppu->setRGBAOutput(true);
+
+    cpu->reset();
+    ppu->reset();
+    apu->reset();
+}
+
+RunAhead::RunAhead(const std::string& romPath, unsigned frames, bool secondInstance)
+    : machine(romPath, SaveRAMMode::File), frames(std::min(frames, MAX_FRAMES)), presented(machine.ppu.get()) {
+    machine.apu->setRateControl(true); // Played live: follow the audio device's clock
+
+    if (secondInstance) {
+        second = std::make_unique<Machine>(romPath, SaveRAMMode::Volatile);
+        second->apu->setOutputEnabled(false); // Never heard
+        machine.cpu->saveSnapshot(snapshot);
+        worker = std::thread(&RunAhead::workerLoop, this);
+    }
+}
+
+RunAhead::~RunAhead() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobPosted.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void RunAhead::runFrame(uint8_t buttons) {
+    Clock::time_point start = Clock::now();
+    machine.bus->setControllerButtons(0, buttons);
+
+    /* No run-ahead: the real machine is presented */
+    if (frames == 0) {
+        machine.cpu->runUntilFrame();
+        Clock::time_point ran = Clock::now();
+        if (second) {
+            machine.cpu->saveSnapshot(snapshot); // Keeps the second instance ready should run-ahead be enabled
+        }
+        Clock::time_point end = Clock::now();
+
+        presented = machine.ppu.get();
+        average(timing.real, milliseconds(start, ran));
+        average(timing.ahead, 0.0);
+        average(timing.snapshot, milliseconds(ran, end));
+        average(timing.total, milliseconds(start, end));
+        return;
+    }
+
+    /* Second instance: it runs frames + 1 from the snapshot before this frame while the real machine runs one */
+    if (second) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobButtons = buttons;
+            jobFrames = frames + 1;
+            jobPending = true;
+        }
+        jobPosted.notify_one();
+
+        machine.cpu->runUntilFrame();
+        Clock::time_point ran = Clock::now();
+        machine.cpu->saveSnapshot(nextSnapshot);
+        Clock::time_point saved = Clock::now();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobDone.wait(lock, [this] { return !jobPending; });
+            if (jobError) {
+                std::rethrow_exception(std::exchange(jobError, nullptr));
+            }
+            average(timing.ahead, jobMilliseconds);
+        }
+        snapshot.swap(nextSnapshot);
+
+        presented = second->ppu.get();
+        average(timing.real, milliseconds(start, ran));
+        average(timing.snapshot, milliseconds(ran, saved));
+        average(timing.total, milliseconds(start, Clock::now()));
+        return;
+    }
+
+    /* Single instance: run the real frame, then run ahead silently and restore */
+    machine.cpu->runUntilFrame();
+    Clock::time_point ran = Clock::now();
+    machine.cpu->saveSnapshot(snapshot);
+    Clock::time_point saved = Clock::now();
+
+    machine.apu->setOutputEnabled(false);
+    for (unsigned i = 0; i < frames; ++i) {
+        machine.cpu->runUntilFrame();
+    }
+    Clock::time_point aheadEnd = Clock::now();
+
+    // The PPU keeps the last frame ahead: frame buffers are not part of the snapshot
+    machine.cpu->loadSnapshot(snapshot.data(), snapshot.size());
+    machine.apu->setOutputEnabled(true);
+    Clock::time_point end = Clock::now();
+
+    presented = machine.ppu.get();
+    average(timing.real, milliseconds(start, ran));
+    average(timing.ahead, milliseconds(saved, aheadEnd));
+    average(timing.snapshot, milliseconds(ran, saved) + milliseconds(aheadEnd, end));
+    average(timing.total, milliseconds(start, end));
+}
+
+void RunAhead::setFrames(unsigned frames) {
+    this->frames = std::min(frames, MAX_FRAMES);
+}
+
+unsigned RunAhead::getFrames() const {
+    return frames;
+}
+
+bool RunAhead::usesSecondInstance() const {
+    return second != nullptr;
+}
+
+const uint32_t* RunAhead::getFrameRGBA() const {
+    return presented->getFrameBufferRGBA();
+}
+
+AudioRingBuffer& RunAhead::getAudioOutput() {
+    return machine.apu->getOutput();
+}
+
+uint32_t RunAhead::getSampleRate() const {
+    return machine.apu->getSampleRate();
+}
+
+const FrameTiming& RunAhead::getTiming() const {
+    return timing;
+}
+
+void RunAhead::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobPosted.wait(lock, [this] { return jobPending || stopping; });
+        if (stopping) {
+            return;
+        }
+        lock.unlock();
+
+        /* snapshot is not written by the main thread until the job is reported done */
+        Clock::time_point start = Clock::now();
+        std::exception_ptr error;
+        try {
+            second->cpu->loadSnapshot(snapshot.data(), snapshot.size());
+            second->bus->setControllerButtons(0, jobButtons);
+            for (unsigned i = 0; i < jobFrames; ++i) {
+                second->cpu->runUntilFrame();
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        double elapsed = milliseconds(start, Clock::now());
+
+        lock.lock();
+        jobError = error;
+        jobMilliseconds = elapsed;
+        jobPending = false;
+        jobDone.notify_one();
+    }
+}
+
+void RunAhead::average(double& value, double sample) {
+    value += (sample - value) * TIMING_SMOOTHING;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file run_ahead.h
+ * @brief Defines the RunAhead class, which hides the game's own input lag by presenting frames emulated ahead.
+ */
+
+#ifndef RUN_AHEAD_H
+#define RUN_AHEAD_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "apu.h"
+#include "Bus/businterface.h"
+#include "Cartridge/cartridge.h"
+#include "Cpu/cpu6502.h"
+#include "ppu.h"
+
+/**
+ * @struct FrameTiming
+ * @brief Host time spent per presented frame, as moving averages in milliseconds.
+ *
+ * headroom() above 1 means the emulator keeps up with real time with that
+ * factor to spare; run-ahead needs about (frames + 1) times the cost of a
+ * plain frame, so it tells how many frames ahead the host can afford.
+ */
+struct FrameTiming {
+    static constexpr double FRAME_PERIOD = 1000.0 / 60.0988; /**< NTSC frame period in milliseconds. */
+
+    double total = 0.0;    /**< Whole runFrame() call: what has to fit in FRAME_PERIOD. */
+    double real = 0.0;     /**< The frame advancing the real timeline (heard, not seen). */
+    double ahead = 0.0;    /**< Frames emulated ahead; on the second instance's thread if it is used. */
+    double snapshot = 0.0; /**< Saving and restoring the machine. */
+
+    /** @brief Real-time factor to spare: FRAME_PERIOD over the time a frame takes. */
+    double headroom() const { return total > 0.0 ? FRAME_PERIOD / total : 0.0; }
+};
+
+/**
+ * @class RunAhead
+ * @brief Runs a ROM for an interactive frontend, presenting each frame as it will look some frames later.
+ *
+ * Games typically react to input a frame or more after reading it. Each
+ * call to runFrame() advances the real machine by one frame with the
+ * current input, snapshots it, emulates a number of further frames with
+ * the same input without audio, presents the last of them and restores
+ * the snapshot. The game's internal lag is hidden, at the cost of
+ * emulating (frames + 1) frames per frame shown.
+ *
+ * With a second instance, the frames ahead are emulated by another
+ * machine on its own thread: it restores the real machine's previous
+ * snapshot and runs (frames + 1) frames while the real machine runs its
+ * one, so the real machine never restores and its frame overlaps the
+ * frames ahead.
+ */
+class RunAhead {
+public:
+    static constexpr unsigned MAX_FRAMES = 8; /**< Most frames ahead accepted. */
+
+    /**
+     * @brief Deleted default constructor.
+     */
+    RunAhead() = delete;
+
+    /**
+     * @brief Loads the ROM and powers the system on.
+     * @param romPath iNES / NES 2.0 file to run.
+     * @param frames Frames to run ahead, 0 to present the real machine directly.
+     * @param secondInstance Emulate the frames ahead on a second machine on another thread.
+     */
+    RunAhead(const std::string& romPath, unsigned frames, bool secondInstance);
+
+    /**
+     * @brief Stops the second instance's thread.
+     */
+    ~RunAhead();
+
+    RunAhead(const RunAhead&) = delete;
+    RunAhead& operator=(const RunAhead&) = delete;
+
+    /**
+     * @brief Emulates one frame with the given input and prepares the frame to present.
+     * @param buttons Controller 1 buttons (see BusInterface::setControllerButtons()).
+     */
+    void runFrame(uint8_t buttons);
+
+    /**
+     * @brief Sets the number of frames to run ahead.
+     * @param frames Frames ahead, clamped to MAX_FRAMES; 0 disables run-ahead.
+     */
+    void setFrames(unsigned frames);
+
+    /**
+     * @brief Gets the number of frames run ahead.
+     */
+    unsigned getFrames() const;
+
+    /**
+     * @brief Returns true if the frames ahead run on a second instance.
+     */
+    bool usesSecondInstance() const;
+
+    /**
+     * @brief Gets the frame to present.
+     * @return SCREEN_WIDTH x SCREEN_HEIGHT RGBA8888 pixels, valid until the next runFrame().
+     */
+    const uint32_t* getFrameRGBA() const;
+
+    /**
+     * @brief Gets the audio of the real machine, for the audio thread to drain.
+     */
+    AudioRingBuffer& getAudioOutput();
+
+    /**
+     * @brief Gets the output sample rate of the audio.
+     */
+    uint32_t getSampleRate() const;
+
+    /**
+     * @brief Gets the host time spent per frame.
+     */
+    const FrameTiming& getTiming() const;
+
+private:
+    /**
+     * @struct Machine
+     * @brief One complete emulator instance.
+     */
+    struct Machine {
+        std::shared_ptr<Cartridge> cartridge;
+        std::shared_ptr<PPU> ppu;
+        std::shared_ptr<APU> apu;
+        std::shared_ptr<BusInterface> bus;
+        std::shared_ptr<CPU6502> cpu;
+
+        /**
+         * @brief Loads the ROM and powers the machine on.
+         * @param romPath iNES / NES 2.0 file to run.
+         * @param saveMode Only the real machine may use the save file.
+         */
+        Machine(const std::string& romPath, SaveRAMMode saveMode);
+    };
+
+    /** @brief Second instance's thread: runs each posted job from the real machine's snapshot. */
+    void workerLoop();
+
+    /** @brief Folds one frame's measurement into a moving average. */
+    static void average(double& value, double sample);
+
+    Machine machine;                 // The real timeline: its audio is heard
+    std::unique_ptr<Machine> second; // Emulates the frames ahead, if enabled
+    unsigned frames;
+    FrameTiming timing;
+    const PPU* presented;            // Machine whose frame is presented
+
+    std::vector<uint8_t> snapshot;     // The real machine before the current frame
+    std::vector<uint8_t> nextSnapshot; // The real machine after it, written while the second instance reads snapshot
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable jobPosted;
+    std::condition_variable jobDone;
+    bool jobPending = false;
+    bool stopping = false;
+    uint8_t jobButtons = 0;
+    unsigned jobFrames = 0;
+    double jobMilliseconds = 0.0;
+    std::exception_ptr jobError;
+};
+
+#endif // RUN_AHEAD_H
@@ -0,0 +1,191 @@
+#include "batch_runner.h"
+#include <cstdio>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+
+/* Fixed-width hexadecimal, as frame hashes are printed everywhere */
+static std::string formatHash(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+static std::string escapeJSON(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char code[7];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    escaped += code;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+static std::string escapeCSV(const std::string& text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) {
+        return text;
+    }
+    std::string escaped = "\"";
+    for (char c : text) {
+        escaped += (c == '"') ? "\"\"" : std::string(1, c);
+    }
+    return escaped + "\"";
+}
+
+uint64_t parseJobNumber(const std::string& text) {
+    size_t end = 0;
+    uint64_t value = 0;
+    try {
+        value = std::stoull(text, &end, 0);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (text.empty() || end != text.size()) {
+        throw std::invalid_argument("Invalid number: " + text);
+    }
+    return value;
+}
+
+BatchJob parseJob(const std::string& line, const BatchJob& defaults) {
+    BatchJob job = defaults;
+    std::istringstream tokens(line);
+    if (!(tokens >> job.options.romPath)) {
+        throw std::invalid_argument("Missing ROM path in job: " + line);
+    }
+
+    std::string setting;
+    while (tokens >> setting) {
+        size_t separator = setting.find('=');
+        if (separator == std::string::npos) {
+            throw std::invalid_argument("Expected key=value: " + setting);
+        }
+        std::string key = setting.substr(0, separator);
+        std::string value = setting.substr(separator + 1);
+
+        if (key == "frames") {
+            job.options.frameLimit = parseJobNumber(value);
+        } else if (key == "until-pc") {
+            job.options.stopAtPC = true;
+            job.options.stopPC = static_cast<uint16_t>(parseJobNumber(value));
+        } else if (key == "until-mem") {
+            size_t valueSeparator = value.find('=');
+            if (valueSeparator == std::string::npos) {
+                throw std::invalid_argument("Expected until-mem=ADDR=VAL: " + setting);
+            }
+            job.options.stopOnMemory = true;
+            job.options.stopAddress = static_cast<uint16_t>(parseJobNumber(value.substr(0, valueSeparator)));
+            job.options.stopValue = static_cast<uint8_t>(parseJobNumber(value.substr(valueSeparator + 1)));
+        } else if (key == "hash") {
+            job.checkHash = true;
+            job.expectedHash = parseJobNumber("0x" + value);
+        } else {
+            throw std::invalid_argument("Unknown job setting: " + key);
+        }
+    }
+    return job;
+}
+
+std::vector<BatchResult> runBatch(const std::vector<BatchJob>& jobs, WorkStealingPool& pool) {
+    std::vector<BatchResult> results(jobs.size());
+
+    /* Each task builds its own emulator and writes only its own result slot */
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        pool.submit([&job = jobs[i], &result = results[i]] {
+            result.romPath = job.options.romPath;
+            try {
+                HeadlessRunner runner(job.options);
+                result.run = runner.run();
+            } catch (const std::exception& e) {
+                result.status = JobStatus::Error;
+                result.message = e.what();
+                return;
+            }
+
+            bool conditionGiven = job.options.stopAtPC || job.options.stopOnMemory;
+            if (conditionGiven && !result.run.conditionMet) {
+                result.status = JobStatus::Fail;
+                result.message = "Stop condition not met";
+            } else if (job.checkHash && result.run.frameHash != job.expectedHash) {
+                result.status = JobStatus::Fail;
+                result.message = "Frame hash differs from " + formatHash(job.expectedHash);
+            } else {
+                result.status = JobStatus::Pass;
+            }
+        });
+    }
+
+    pool.wait();
+    return results;
+}
+
+const char* jobStatusName(JobStatus status) {
+    switch (status) {
+        case JobStatus::Pass: return "pass";
+        case JobStatus::Fail: return "fail";
+        default:              return "error";
+    }
+}
+
+void writeJSONReport(std::ostream& out, const std::vector<BatchResult>& results, double wallSeconds,
+                     const WorkStealingPool& pool) {
+    size_t counts[3] = {};
+    double emulatedSeconds = 0.0;
+    for (const BatchResult& result : results) {
+        counts[static_cast<int>(result.status)]++;
+        emulatedSeconds += result.run.seconds;
+    }
+
+    out << "{\n"
+        << "  \"threads\": " << pool.getThreadCount() << ",\n"
+        << "  \"steals\": " << pool.getStealCount() << ",\n"
+        << "  \"wall_seconds\": " << wallSeconds << ",\n"
+        << "  \"job_seconds\": " << emulatedSeconds << ",\n"
+        << "  \"total\": " << results.size() << ",\n"
+        << "  \"passed\": " << counts[static_cast<int>(JobStatus::Pass)] << ",\n"
+        << "  \"failed\": " << counts[static_cast<int>(JobStatus::Fail)] << ",\n"
+        << "  \"errors\": " << counts[static_cast<int>(JobStatus::Error)] << ",\n"
+        << "  \"jobs\": [";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BatchResult& result = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"rom\": \"" << escapeJSON(result.romPath) << "\""
+            << ", \"status\": \"" << jobStatusName(result.status) << "\""
+            << ", \"frames\": " << result.run.frames
+            << ", \"instructions\": " << result.run.instructions
+            << ", \"cycles\": " << result.run.cycles
+            << ", \"seconds\": " << result.run.seconds
+            << ", \"fps\": " << result.run.framesPerSecond()
+            << ", \"frame_hash\": \"" << formatHash(result.run.frameHash) << "\""
+            << ", \"condition_met\": " << (result.run.conditionMet ? "true" : "false")
+            << ", \"message\": \"" << escapeJSON(result.message) << "\"}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void writeCSVReport(std::ostream& out, const std::vector<BatchResult>& results) {
+    out << "rom,status,frames,instructions,cycles,seconds,fps,frame_hash,condition_met,message\n";
+    for (const BatchResult& result : results) {
+        out << escapeCSV(result.romPath) << ','
+            << jobStatusName(result.status) << ','
+            << result.run.frames << ','
+            << result.run.instructions << ','
+            << result.run.cycles << ','
+            << result.run.seconds << ','
+            << result.run.framesPerSecond() << ','
+            << formatHash(result.run.frameHash) << ','
+            << (result.run.conditionMet ? "true" : "false") << ','
+            << escapeCSV(result.message) << '\n';
+    }
+}
@@ -0,0 +1,99 @@
+/**
+ * @file batch_runner.h
+ * @brief Runs many independent headless jobs in parallel and reports their results as JSON or CSV.
+ */
+
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "headless_runner.h"
+#include "work_stealing_pool.h"
+
+/**
+ * @struct BatchJob
+ * @brief One ROM run and the checks deciding whether it passed.
+ */
+struct BatchJob {
+    HeadlessOptions options;   /**< The ROM, frame limit and stop conditions. */
+    bool checkHash = false;    /**< Fail unless the last frame's hash equals expectedHash. */
+    uint64_t expectedHash = 0;
+};
+
+/**
+ * @enum JobStatus
+ * @brief Outcome of a batch job.
+ */
+enum class JobStatus : uint8_t {
+    Pass,  /**< Ran to completion and every check held. */
+    Fail,  /**< Ran, but a stop condition was not met or the frame hash differed. */
+    Error  /**< The ROM could not be loaded or emulation raised an error. */
+};
+
+/**
+ * @struct BatchResult
+ * @brief Result of one batch job.
+ */
+struct BatchResult {
+    std::string romPath;
+    JobStatus status = JobStatus::Error;
+    HeadlessResult run;   /**< Counters of the run; zero if it raised an error. */
+    std::string message;  /**< Why the job failed or the error raised, empty on a pass. */
+};
+
+/**
+ * @brief Parses a decimal or 0x-prefixed hexadecimal number.
+ * @param text The number.
+ * @return The value; throws std::invalid_argument on malformed input.
+ */
+uint64_t parseJobNumber(const std::string& text);
+
+/**
+ * @brief Parses a job from a line of a job list.
+ *
+ * The line is the ROM path followed by optional key=value settings:
+ * frames=N, until-pc=ADDR, until-mem=ADDR=VAL and hash=HEX. Settings not
+ * given are taken from the defaults.
+ *
+ * @param line The job line (without comments).
+ * @param defaults Job supplying the settings not on the line.
+ * @return The job; throws std::invalid_argument on malformed input.
+ */
+BatchJob parseJob(const std::string& line, const BatchJob& defaults);
+
+/**
+ * @brief Runs every job on the pool, one emulator instance per job.
+ * @param jobs The jobs.
+ * @param pool The pool to run them on.
+ * @return One result per job, in job order.
+ */
+std::vector<BatchResult> runBatch(const std::vector<BatchJob>& jobs, WorkStealingPool& pool);
+
+/**
+ * @brief Gets the report name of a job status ("pass", "fail" or "error").
+ * @param status The status.
+ * @return The name.
+ */
+const char* jobStatusName(JobStatus status);
+
+/**
+ * @brief Writes the results and their totals as a JSON object.
+ * @param out The stream to write to.
+ * @param results The job results.
+ * @param wallSeconds Wall-clock time of the whole batch.
+ * @param pool The pool the batch ran on (thread and steal counts).
+ */
+void writeJSONReport(std::ostream& out, const std::vector<BatchResult>& results, double wallSeconds,
+                     const WorkStealingPool& pool);
+
+/**
+ * @brief Writes the results as CSV, one row per job after a header row.
+ * @param out The stream to write to.
+ * @param results The job results.
+ */
+void writeCSVReport(std::ostream& out, const std::vector<BatchResult>& results);
+
+#endif // BATCH_RUNNER_H
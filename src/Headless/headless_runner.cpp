@@ -0,0 +1,121 @@
+#include "headless_runner.h"
+#include "rewind_buffer.h"
+#include "wav_writer.h"
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+
+/* FNV-1a over the frame's palette indices: cheap, and stable across hosts */
+static uint64_t hashFrame(const uint8_t* pixels, size_t count) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < count; ++i) {
+        hash = (hash ^ pixels[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+HeadlessRunner::HeadlessRunner(const HeadlessOptions& options)
+    : options(options)
+{
+    cartridge = std::make_shared<Cartridge>(options.romPath, RomLoadMode::MemoryMap,
+                                            options.persistSaveRAM ? SaveRAMMode::File : SaveRAMMode::Volatile);
+    ppu = std::make_shared<PPU>();
+    apu = std::make_shared<APU>();
+    bus = std::make_shared<BusInterface>(cartridge, ppu, apu);
+    cpu = std::make_shared<CPU6502>(bus);
+
+    // Raw pointer: a shared_ptr captured by the PPU would form a cycle through the bus and leak the instance
+    CPU6502* processor = cpu.get();
+    ppu->setNMICallback([processor] { processor->triggerNMI(); });
+    ppu->setIRQCallback([processor] { processor->triggerIRQ(); });
+    apu->setIRQCallback([processor] { processor->triggerIRQ(); });
+
+    cpu->reset();
+    ppu->reset();
+    apu->reset();
+
+    if (!options.loadStatePath.empty()) {
+        std::ifstream file(options.loadStatePath, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open snapshot: " + options.loadStatePath);
+        }
+        loadState(std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+    }
+}
+
+size_t HeadlessRunner::saveState(std::vector<uint8_t>& buffer) {
+    return cpu->saveSnapshot(buffer);
+}
+
+void HeadlessRunner::loadState(const std::vector<uint8_t>& snapshot) {
+    cpu->loadSnapshot(snapshot.data(), snapshot.size());
+}
+
+bool HeadlessRunner::conditionMet() const {
+    if (options.stopAtPC && cpu->getPC() == options.stopPC) {
+        return true;
+    }
+    if (options.stopOnMemory && cpu->peek(options.stopAddress) == options.stopValue) {
+        return true;
+    }
+    return false;
+}
+
+HeadlessResult HeadlessRunner::run() {
+    std::optional<WavWriter> wav;
+    if (!options.wavPath.empty()) {
+        wav.emplace(options.wavPath, apu->getSampleRate());
+    }
+
+    /* Rewind history from the start of the run, one snapshot per frame */
+    std::optional<RewindBuffer> history;
+    std::vector<uint8_t> snapshot;
+    if (options.rewindFrames > 0) {
+        history.emplace();
+        saveState(snapshot);
+        history->push(snapshot.data(), snapshot.size());
+    }
+
+    HeadlessResult result;
+    uint64_t startInstructions = cpu->getInstructionCount();
+    uint64_t startCycle = bus->getCPUCycle();
+    auto start = std::chrono::steady_clock::now();
+
+    while (result.frames < options.frameLimit) {
+        cpu->runUntilFrame();
+        result.frames++;
+
+        if (history) {
+            saveState(snapshot);
+            history->push(snapshot.data(), snapshot.size());
+        }
+        if (wav) {
+            wav->drain(apu->getOutput());
+        }
+        if (conditionMet()) {
+            result.conditionMet = true;
+            break;
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.instructions = cpu->getInstructionCount() - startInstructions;
+    result.cycles = bus->getCPUCycle() - startCycle;
+    result.frameHash = hashFrame(ppu->getFrameBuffer(), PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT);
+
+    if (history) {
+        result.rewindBytes = history->getUsedBytes();
+        result.rewound = history->rewind(options.rewindFrames);
+        loadState(history->getSnapshot());
+    }
+    if (!options.saveStatePath.empty()) {
+        saveState(snapshot);
+        std::ofstream file(options.saveStatePath, std::ios::binary);
+        if (!file.write(reinterpret_cast<const char*>(snapshot.data()), snapshot.size())) {
+            throw std::runtime_error("Failed to write snapshot: " + options.saveStatePath);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file headless_runner.h
+ * @brief Defines the HeadlessRunner class, which runs a ROM without video, audio or terminal output.
+ */
+
+#ifndef HEADLESS_RUNNER_H
+#define HEADLESS_RUNNER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "apu.h"
+#include "Bus/businterface.h"
+#include "Cartridge/cartridge.h"
+#include "Cpu/cpu6502.h"
+#include "ppu.h"
+
+/**
+ * @struct HeadlessOptions
+ * @brief What to run and when to stop.
+ *
+ * A run stops after frameLimit frames, or earlier once an enabled stop
+ * condition holds. Conditions are tested at the end of each frame.
+ */
+struct HeadlessOptions {
+    std::string romPath;        /**< iNES / NES 2.0 file to run. */
+    uint64_t frameLimit = 600;  /**< Maximum number of frames to run. */
+
+    bool stopAtPC = false;      /**< Stop once the PC equals stopPC at the end of a frame (a spin loop). */
+    uint16_t stopPC = 0;
+
+    bool stopOnMemory = false;  /**< Stop once the byte at stopAddress equals stopValue. */
+    uint16_t stopAddress = 0;
+    uint8_t stopValue = 0;
+
+    std::string wavPath;        /**< Audio dump file; empty to discard the audio. */
+    bool persistSaveRAM = false; /**< Use the ROM's .sav file; off keeps runs reproducible and independent. */
+
+    std::string loadStatePath;  /**< Snapshot to start the run from; empty to start from power-on. */
+    std::string saveStatePath;  /**< File receiving a snapshot at the end of the run; empty for none. */
+    uint64_t rewindFrames = 0;  /**< Frames to step back after the run, before saving the snapshot. */
+};
+
+/**
+ * @struct HeadlessResult
+ * @brief Outcome and throughput of a headless run.
+ */
+struct HeadlessResult {
+    uint64_t frames = 0;       /**< Frames completed. */
+    uint64_t instructions = 0; /**< Instructions executed. */
+    uint64_t cycles = 0;       /**< CPU cycles executed. */
+    double seconds = 0.0;      /**< Wall-clock time spent emulating (ROM loading excluded). */
+    bool conditionMet = false; /**< A stop condition ended the run before the frame limit. */
+    uint64_t frameHash = 0;    /**< FNV-1a hash of the last frame's palette indices. */
+    uint64_t rewound = 0;      /**< Frames stepped back after the run (see HeadlessOptions::rewindFrames). */
+    size_t rewindBytes = 0;    /**< Rewind history memory in use at the end of the run. */
+
+    /** @brief Emulated frames per wall-clock second. */
+    double framesPerSecond() const { return seconds > 0.0 ? frames / seconds : 0.0; }
+
+    /** @brief Emulated instructions per wall-clock second. */
+    double instructionsPerSecond() const { return seconds > 0.0 ? instructions / seconds : 0.0; }
+};
+
+/**
+ * @class HeadlessRunner
+ * @brief Owns one complete emulator instance and runs it frame by frame as fast as possible.
+ *
+ * Nothing is shared between runners, so several can run on different
+ * threads at once. Errors (unreadable ROM, unsupported mapper, emulation
+ * faults) are reported by exceptions.
+ */
+class HeadlessRunner {
+public:
+    /**
+     * @brief Deleted default constructor.
+     */
+    HeadlessRunner() = delete;
+
+    /**
+     * @brief Loads the ROM and powers the system on.
+     * @param options The ROM and the run's stop conditions.
+     */
+    explicit HeadlessRunner(const HeadlessOptions& options);
+
+    /**
+     * @brief Runs until the frame limit or a stop condition.
+     * @return Counters and the last frame's hash.
+     */
+    HeadlessResult run();
+
+    /**
+     * @brief Snapshots the machine between frames.
+     * @param buffer Receives the snapshot; reused without reallocation once large enough.
+     * @return The snapshot size in bytes.
+     */
+    size_t saveState(std::vector<uint8_t>& buffer);
+
+    /**
+     * @brief Restores a snapshot taken from a runner of the same ROM.
+     * @param snapshot The snapshot.
+     */
+    void loadState(const std::vector<uint8_t>& snapshot);
+
+private:
+    /** @brief Returns true if an enabled stop condition holds. */
+    bool conditionMet() const;
+
+    HeadlessOptions options;
+    std::shared_ptr<Cartridge> cartridge;
+    std::shared_ptr<PPU> ppu;
+    std::shared_ptr<APU> apu;
+    std::shared_ptr<BusInterface> bus;
+    std::shared_ptr<CPU6502> cpu;
+};
+
+#endif // HEADLESS_RUNNER_H
@@ -0,0 +1,112 @@
+/**
+ * @file work_stealing_pool.h
+ * @brief Defines the WorkStealingPool class, a fixed set of worker threads with per-worker task queues.
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkStealingPool
+ * @brief Runs independent tasks on one thread per core, balancing uneven task lengths by stealing.
+ *
+ * Submitted tasks are dealt round-robin onto the workers' own queues. A
+ * worker takes its newest task first (its data is most likely still in
+ * cache) and, once its queue is empty, steals the oldest task of another
+ * worker. Tasks are coarse (whole emulator runs), so each queue is guarded
+ * by its own mutex rather than being lock-free; workers only contend when
+ * they steal.
+ *
+ * Tasks must not throw: they are expected to report their own errors.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Deleted default constructor.
+     */
+    WorkStealingPool() = delete;
+
+    /**
+     * @brief Deleted copy operations: workers hold a pointer to the pool.
+     */
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Starts the worker threads.
+     * @param threadCount Number of workers; 0 uses one per hardware thread.
+     */
+    explicit WorkStealingPool(size_t threadCount);
+
+    /**
+     * @brief Destructor. Finishes the queued tasks and joins the workers.
+     */
+    ~WorkStealingPool();
+
+    /**
+     * @brief Queues a task.
+     * @param task The task to run on some worker.
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Blocks until every submitted task has completed.
+     */
+    void wait();
+
+    /**
+     * @brief Gets the number of worker threads.
+     * @return The worker count.
+     */
+    size_t getThreadCount() const;
+
+    /**
+     * @brief Gets the number of tasks run by a worker other than the one they were queued on.
+     * @return The steal count so far.
+     */
+    size_t getStealCount() const;
+
+private:
+    /** @brief A worker's task queue. */
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /** @brief Worker thread body: run own tasks, then steal, then sleep until more are queued. */
+    void workerLoop(size_t index);
+
+    /**
+     * @brief Takes a task for a worker: the newest of its own, or the oldest of another's.
+     * @param index The worker's index.
+     * @param task Receives the task.
+     * @return False if every queue was empty.
+     */
+    bool takeTask(size_t index, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues; // One per worker
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;                   // Guards sleeping and waiting on the counters below
+    std::condition_variable taskAvailable;   // Signalled on submit and shutdown
+    std::condition_variable allDone;         // Signalled when pending reaches zero
+    std::atomic<size_t> queued{0};           // Tasks in the queues, not yet taken
+    std::atomic<size_t> pending{0};          // Tasks submitted and not yet completed
+    std::atomic<size_t> steals{0};
+    std::atomic<size_t> nextQueue{0};        // Round-robin submit position
+    bool stopping = false;
+};
+
+#endif // WORK_STEALING_POOL_H
@@ -0,0 +1,201 @@
+#include "rewind_buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/* Equal bytes needed to end a literal run: shorter gaps cost more to encode than to copy */
+constexpr size_t MIN_SKIP = 8;
+
+/* Size of the frame stored before and after each delta in the arena */
+constexpr size_t FRAME_SIZE = sizeof(uint32_t);
+
+static inline uint64_t load64(const uint8_t* bytes) {
+    uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static inline uint8_t* writeVarint(uint8_t* out, size_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+static inline size_t readVarint(const uint8_t*& in, const uint8_t* end) {
+    size_t value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t byte = *in++;
+        value |= size_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Rewind delta is corrupt.");
+}
+
+/* True if a literal run should end at position: the next MIN_SKIP bytes, or all that remain, are unchanged */
+static inline bool unchangedRun(const uint8_t* older, const uint8_t* newer, size_t position, size_t size) {
+    if (position + MIN_SKIP <= size) {
+        return load64(older + position) == load64(newer + position);
+    }
+    return std::memcmp(older + position, newer + position, size - position) == 0;
+}
+
+/*
+ * Encodes older ^ newer as a sequence of (unchanged bytes, changed bytes, XOR of the changed bytes),
+ * the two lengths as LEB128 varints. Trailing unchanged bytes are implied. Literal runs only end at
+ * MIN_SKIP unchanged bytes, which bounds the output at 2 * size + 16 bytes.
+ */
+static size_t encodeDelta(const uint8_t* older, const uint8_t* newer, size_t size, uint8_t* out) {
+    uint8_t* start = out;
+    size_t position = 0;
+
+    while (position < size) {
+        /* 1. Unchanged bytes, a word at a time */
+        size_t skipStart = position;
+        while (position + 8 <= size && load64(older + position) == load64(newer + position)) {
+            position += 8;
+        }
+        while (position < size && older[position] == newer[position]) {
+            position++;
+        }
+        if (position == size) {
+            break;
+        }
+
+        /* 2. Changed bytes, up to the next unchanged run */
+        size_t literalStart = position;
+        while (position < size && !unchangedRun(older, newer, position, size)) {
+            position++;
+        }
+
+        out = writeVarint(out, literalStart - skipStart);
+        out = writeVarint(out, position - literalStart);
+        for (size_t i = literalStart; i < position; ++i) {
+            *out++ = older[i] ^ newer[i];
+        }
+    }
+    return out - start;
+}
+
+/* XORs an encoded delta into a snapshot, turning either of its two snapshots into the other */
+static void applyDelta(const uint8_t* delta, size_t deltaSize, uint8_t* state, size_t size) {
+    const uint8_t* end = delta + deltaSize;
+    size_t position = 0;
+
+    while (delta < end) {
+        position += readVarint(delta, end);
+        size_t length = readVarint(delta, end);
+        if (position + length > size || length > static_cast<size_t>(end - delta)) {
+            throw std::runtime_error("Rewind delta is corrupt.");
+        }
+        for (size_t i = 0; i < length; ++i) {
+            state[position + i] ^= delta[i];
+        }
+        delta += length;
+        position += length;
+    }
+}
+
+RewindBuffer::RewindBuffer(size_t budget) : arena(budget) {
+    if (budget < 2 * FRAME_SIZE) {
+        throw std::invalid_argument("Rewind budget is too small.");
+    }
+}
+
+void RewindBuffer::push(const uint8_t* data, size_t size) {
+    /* First frame, or a different machine: start a new history */
+    if (snapshot.size() != size) {
+        clear();
+        snapshot.assign(data, data + size);
+        scratch.resize(2 * size + 16);
+        return;
+    }
+
+    /* The delta takes the new snapshot back to the one it replaces */
+    size_t deltaSize = encodeDelta(snapshot.data(), data, size, scratch.data());
+    std::memcpy(snapshot.data(), data, size);
+
+    size_t recordSize = deltaSize + 2 * FRAME_SIZE;
+    if (recordSize > arena.size()) {
+        head = tail = used = count = 0; // Older frames cannot be reached without this delta
+        return;
+    }
+    while (arena.size() - used < recordSize) {
+        dropOldest();
+    }
+
+    uint32_t frame = static_cast<uint32_t>(deltaSize);
+    writeArena(head, &frame, FRAME_SIZE);
+    writeArena(head + FRAME_SIZE, scratch.data(), deltaSize);
+    writeArena(head + FRAME_SIZE + deltaSize, &frame, FRAME_SIZE);
+    head = (head + recordSize) % arena.size();
+    used += recordSize;
+    count++;
+}
+
+size_t RewindBuffer::rewind(size_t frames) {
+    size_t stepped = 0;
+    for (; stepped < frames && count > 0; ++stepped) {
+        /* The newest delta ends at head; its trailing frame gives its size */
+        uint32_t deltaSize;
+        readArena(head + arena.size() - FRAME_SIZE, &deltaSize, FRAME_SIZE);
+        size_t recordSize = deltaSize + 2 * FRAME_SIZE;
+        size_t start = (head + arena.size() - recordSize) % arena.size();
+
+        readArena(start + FRAME_SIZE, scratch.data(), deltaSize);
+        applyDelta(scratch.data(), deltaSize, snapshot.data(), snapshot.size());
+
+        head = start;
+        used -= recordSize;
+        count--;
+    }
+    return stepped;
+}
+
+const std::vector<uint8_t>& RewindBuffer::getSnapshot() const {
+    return snapshot;
+}
+
+size_t RewindBuffer::getFrameCount() const {
+    return count;
+}
+
+size_t RewindBuffer::getUsedBytes() const {
+    return used;
+}
+
+size_t RewindBuffer::getBudget() const {
+    return arena.size();
+}
+
+void RewindBuffer::clear() {
+    head = tail = used = count = 0;
+    snapshot.clear();
+}
+
+void RewindBuffer::writeArena(size_t position, const void* data, size_t size) {
+    position %= arena.size();
+    size_t first = std::min(size, arena.size() - position);
+    std::memcpy(&arena[position], data, first);
+    std::memcpy(&arena[0], static_cast<const uint8_t*>(data) + first, size - first);
+}
+
+void RewindBuffer::readArena(size_t position, void* out, size_t size) const {
+    position %= arena.size();
+    size_t first = std::min(size, arena.size() - position);
+    std::memcpy(out, &arena[position], first);
+    std::memcpy(static_cast<uint8_t*>(out) + first, &arena[0], size - first);
+}
+
+void RewindBuffer::dropOldest() {
+    uint32_t deltaSize;
+    readArena(tail, &deltaSize, FRAME_SIZE);
+    size_t recordSize = deltaSize + 2 * FRAME_SIZE;
+    tail = (tail + recordSize) % arena.size();
+    used -= recordSize;
+    count--;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file rewind_buffer.h
+ * @brief Defines the RewindBuffer class, which keeps a history of snapshots as compressed frame-to-frame deltas.
+ */
+
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class RewindBuffer
+ * @brief History of machine snapshots for stepping back frame by frame.
+ *
+ * Only the newest snapshot is kept whole. Every older one is stored as the
+ * XOR of it and the snapshot after it, run-length encoded: between two
+ * frames WRAM and VRAM change in a few places only, so a delta is usually
+ * a few hundred bytes against a snapshot of 10-40 KB. Rewinding a frame
+ * XORs the newest delta back into the whole snapshot.
+ *
+ * Deltas live in a circular arena allocated once with a fixed byte budget;
+ * when it is full the oldest deltas are dropped. Pushing a frame costs one
+ * pass over the snapshot and no allocation, however long the history.
+ */
+class RewindBuffer {
+public:
+    static constexpr size_t DEFAULT_BUDGET = 16 * 1024 * 1024; /**< Default arena size in bytes. */
+
+    /**
+     * @brief Allocates the delta arena.
+     * @param budget Arena size in bytes. The newest snapshot and a scratch buffer are kept outside it.
+     */
+    explicit RewindBuffer(size_t budget = DEFAULT_BUDGET);
+
+    /**
+     * @brief Records the snapshot of a new frame.
+     *
+     * A snapshot of a different size than the previous one (another ROM)
+     * starts a new history.
+     *
+     * @param snapshot The snapshot.
+     * @param size Size of the snapshot in bytes.
+     */
+    void push(const uint8_t* snapshot, size_t size);
+
+    /**
+     * @brief Steps the newest snapshot back in time.
+     * @param frames Number of frames to step back.
+     * @return The number of frames actually stepped back, fewer if the history is shorter.
+     */
+    size_t rewind(size_t frames = 1);
+
+    /**
+     * @brief Gets the newest snapshot, i.e. the one to load after rewind().
+     * @return The snapshot; empty before the first push().
+     */
+    const std::vector<uint8_t>& getSnapshot() const;
+
+    /**
+     * @brief Gets the number of frames the history reaches back.
+     * @return The number of stored deltas.
+     */
+    size_t getFrameCount() const;
+
+    /**
+     * @brief Gets the number of arena bytes in use.
+     * @return Bytes used by the stored deltas, framing included.
+     */
+    size_t getUsedBytes() const;
+
+    /**
+     * @brief Gets the arena size.
+     * @return The byte budget given at construction.
+     */
+    size_t getBudget() const;
+
+    /**
+     * @brief Discards the whole history, the newest snapshot included.
+     */
+    void clear();
+
+private:
+    /** @brief Copies bytes into the arena at a position, wrapping around its end. */
+    void writeArena(size_t position, const void* data, size_t count);
+
+    /** @brief Copies bytes out of the arena from a position, wrapping around its end. */
+    void readArena(size_t position, void* out, size_t count) const;
+
+    /** @brief Drops the oldest delta. */
+    void dropOldest();
+
+    std::vector<uint8_t> arena;    // Deltas, each framed by its size before and after
+    size_t head = 0;               // Arena position the next delta is written at
+    size_t tail = 0;               // Arena position of the oldest delta
+    size_t used = 0;               // Bytes between tail and head
+    size_t count = 0;              // Deltas stored
+
+    std::vector<uint8_t> snapshot; // Newest snapshot, whole
+    std::vector<uint8_t> scratch;  // Delta being encoded or decoded
+};
+
+#endif // REWIND_BUFFER_H
@@ -0,0 +1,270 @@
+/**
+ * @file snapshot.h
+ * @brief Defines the binary save-state format and the writer and reader components serialise through.
+ *
+ * A snapshot is one contiguous buffer:
+ *
+ *     SnapshotHeader
+ *     SectionHeader, payload (padded to 8 bytes)
+ *     SectionHeader, payload ...
+ *
+ * Each component writes one section of fixed-layout, trivially copyable
+ * structs and raw memory blocks, so saving and loading are a handful of
+ * memcpys. All fields are little-endian; a section's version is bumped
+ * whenever the layout of its structs changes, and snapshots of another
+ * version are rejected rather than converted.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The snapshot format stores host structs directly and requires a little-endian host."
+#endif
+
+/**
+ * @struct SnapshotHeader
+ * @brief Start of every snapshot.
+ */
+struct SnapshotHeader {
+    uint32_t magic;        /**< SNAPSHOT_MAGIC. */
+    uint32_t version;      /**< SNAPSHOT_VERSION. */
+    uint32_t size;         /**< Size of the whole snapshot in bytes, header included. */
+    uint32_t sectionCount; /**< Number of sections that follow. */
+};
+
+/**
+ * @struct SectionHeader
+ * @brief Start of every section.
+ */
+struct SectionHeader {
+    uint32_t id;      /**< Four-character code of the component (see sectionID()). */
+    uint32_t version; /**< Layout version of the component's payload. */
+    uint32_t size;    /**< Payload size in bytes, padding excluded. */
+    uint32_t reserved;
+};
+
+/**
+ * @brief Builds a section identifier from its four-character code.
+ * @param code Four characters, e.g. "CPU ".
+ * @return The identifier as stored in SectionHeader::id.
+ */
+constexpr uint32_t sectionID(const char (&code)[5]) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(code[0]))
+         | static_cast<uint32_t>(static_cast<uint8_t>(code[1])) << 8
+         | static_cast<uint32_t>(static_cast<uint8_t>(code[2])) << 16
+         | static_cast<uint32_t>(static_cast<uint8_t>(code[3])) << 24;
+}
+
+constexpr uint32_t SNAPSHOT_MAGIC = sectionID("NEST"); /**< First four bytes of every snapshot. */
+constexpr uint32_t SNAPSHOT_VERSION = 1;               /**< Version of the container layout. */
+
+/**
+ * @class SnapshotWriter
+ * @brief Appends sections to a snapshot buffer.
+ *
+ * The buffer is reused between snapshots: it is cleared, not shrunk, so once
+ * it has grown to the snapshot size no further allocation takes place.
+ */
+class SnapshotWriter {
+public:
+    /**
+     * @brief Starts a snapshot in a buffer, discarding its contents.
+     * @param buffer The buffer receiving the snapshot.
+     */
+    explicit SnapshotWriter(std::vector<uint8_t>& buffer) : buffer(buffer) {
+        buffer.clear();
+        append(nullptr, sizeof(SnapshotHeader));
+    }
+
+    /**
+     * @brief Opens a section; the data written until endSection() is its payload.
+     * @param id Section identifier.
+     * @param version Layout version of the payload.
+     */
+    void beginSection(uint32_t id, uint32_t version) {
+        sectionStart = buffer.size();
+        SectionHeader header{id, version, 0, 0};
+        append(&header, sizeof(header));
+    }
+
+    /**
+     * @brief Appends a fixed-layout value to the open section.
+     * @param value The value; must be trivially copyable.
+     */
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Snapshot values must be trivially copyable");
+        static_assert(std::has_unique_object_representations<T>::value,
+                      "Snapshot values must have no padding, which would make snapshots of equal states differ");
+        append(&value, sizeof(T));
+    }
+
+    /**
+     * @brief Appends a block of memory to the open section.
+     * @param data The block.
+     * @param size Size in bytes.
+     */
+    void writeBytes(const void* data, size_t size) {
+        append(data, size);
+    }
+
+    /**
+     * @brief Closes the open section, recording its size and padding it to 8 bytes.
+     */
+    void endSection() {
+        uint32_t size = static_cast<uint32_t>(buffer.size() - sectionStart - sizeof(SectionHeader));
+        std::memcpy(&buffer[sectionStart + offsetof(SectionHeader, size)], &size, sizeof(size));
+        buffer.resize((buffer.size() + 7) & ~size_t(7), 0);
+        sectionCount++;
+    }
+
+    /**
+     * @brief Completes the snapshot header. No sections may be written afterwards.
+     * @return The snapshot size in bytes.
+     */
+    size_t finish() {
+        SnapshotHeader header{SNAPSHOT_MAGIC, SNAPSHOT_VERSION, static_cast<uint32_t>(buffer.size()), sectionCount};
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        return buffer.size();
+    }
+
+private:
+    void append(const void* data, size_t size) {
+        size_t offset = buffer.size();
+        buffer.resize(offset + size);
+        if (data) {
+            std::memcpy(&buffer[offset], data, size);
+        }
+    }
+
+    std::vector<uint8_t>& buffer;
+    size_t sectionStart = 0;
+    uint32_t sectionCount = 0;
+};
+
+/**
+ * @class SnapshotReader
+ * @brief Reads the sections of a snapshot in the order they were written.
+ *
+ * Malformed data (wrong magic or version, truncation, a section other than
+ * the one expected) raises std::runtime_error. The container is checked
+ * when the reader is constructed, so a truncated snapshot is rejected
+ * before any component has been modified.
+ */
+class SnapshotReader {
+public:
+    /**
+     * @brief Validates the snapshot container.
+     * @param data The snapshot.
+     * @param size Size of the snapshot in bytes.
+     */
+    SnapshotReader(const uint8_t* data, size_t size) : data(data), size(size) {
+        SnapshotHeader header;
+        if (size < sizeof(header)) {
+            throw std::runtime_error("Snapshot is truncated.");
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) {
+            throw std::runtime_error("Not a snapshot of this format version.");
+        }
+        if (header.size != size) {
+            throw std::runtime_error("Snapshot size does not match its header.");
+        }
+
+        /* Walk the section headers so that every payload is known to lie within the buffer */
+        size_t offset = sizeof(header);
+        for (uint32_t i = 0; i < header.sectionCount; ++i) {
+            SectionHeader section;
+            if (offset + sizeof(section) > size) {
+                throw std::runtime_error("Snapshot is truncated.");
+            }
+            std::memcpy(&section, data + offset, sizeof(section));
+            offset += (sizeof(section) + section.size + 7) & ~size_t(7);
+            if (offset > size) {
+                throw std::runtime_error("Snapshot is truncated.");
+            }
+        }
+        position = sizeof(header);
+    }
+
+    /**
+     * @brief Opens the next section, which must have the given identifier and version.
+     * @param id Expected section identifier.
+     * @param version Expected layout version.
+     */
+    void beginSection(uint32_t id, uint32_t version) {
+        SectionHeader header;
+        if (position + sizeof(header) > size) {
+            throw std::runtime_error("Snapshot is missing a section.");
+        }
+        std::memcpy(&header, data + position, sizeof(header));
+        if (header.id != id || header.version != version) {
+            throw std::runtime_error("Unexpected snapshot section or section version.");
+        }
+        position += sizeof(header);
+        sectionEnd = position + header.size;
+    }
+
+    /**
+     * @brief Reads a fixed-layout value from the open section.
+     * @param value Receives the value; must be trivially copyable.
+     */
+    template <typename T>
+    void read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Snapshot values must be trivially copyable");
+        readBytes(&value, sizeof(T));
+    }
+
+    /**
+     * @brief Reads a block of memory from the open section.
+     * @param out Destination of the block.
+     * @param count Size in bytes.
+     */
+    void readBytes(void* out, size_t count) {
+        const uint8_t* bytes = view(count);
+        if (count) {
+            std::memcpy(out, bytes, count);
+        }
+    }
+
+    /**
+     * @brief Returns a pointer to the next bytes of the open section without copying them.
+     * @param count Number of bytes the caller will read.
+     * @return Pointer into the snapshot.
+     */
+    const uint8_t* view(size_t count) {
+        if (position + count > sectionEnd) {
+            throw std::runtime_error("Snapshot section is shorter than expected.");
+        }
+        const uint8_t* bytes = data + position;
+        position += count;
+        return bytes;
+    }
+
+    /**
+     * @brief Closes the open section, which must have been read completely.
+     */
+    void endSection() {
+        if (position != sectionEnd) {
+            throw std::runtime_error("Snapshot section is longer than expected.");
+        }
+        position = (position + 7) & ~size_t(7);
+    }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position = 0;
+    size_t sectionEnd = 0;
+};
+
+#endif // SNAPSHOT_H
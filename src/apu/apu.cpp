@@ -0,0 +1,606 @@
+#include "apu.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <limits>
+
+/* Longest stretch synthesised before samples are flushed, should frames stop ending (CPU cycles) */
+constexpr uint32_t MAX_FRAME_CYCLES = 32768;
+
+/* Output buffer: about a quarter of a second at 48 kHz */
+constexpr size_t OUTPUT_BUFFER_SAMPLES = 12000;
+
+/* Dynamic rate control: buffered audio aimed for (seconds) and the largest rate change */
+constexpr double RATE_CONTROL_LATENCY = 0.05;
+constexpr double MAX_RATE_ADJUSTMENT = 0.005;
+
+/* Snapshot section of the APU */
+constexpr uint32_t APU_SECTION = sectionID("APU ");
+constexpr uint32_t APU_SECTION_VERSION = 1;
+
+/* Frame counter and IRQ state of the APU snapshot section, in a fixed layout */
+struct FrameCounterState {
+    uint64_t frameSequenceStart;
+    uint64_t timestamp;
+    uint8_t fiveStepMode;
+    uint8_t frameIRQInhibit;
+    uint8_t frameIRQ;
+    uint8_t DMCIRQ;
+    uint8_t frameStep;
+    uint8_t reserved[3];
+};
+
+/* Frame counter steps (CPU cycles from the start of the sequence) and sequence lengths */
+constexpr uint32_t FRAME_STEPS[5] = { 7457, 14913, 22371, 29829, 37281 };
+constexpr uint32_t FOUR_STEP_LENGTH = 29830;
+constexpr uint32_t FIVE_STEP_LENGTH = 37282;
+
+static const uint8_t LENGTH_TABLE[32] = {
+    10, 254, 20,  2, 40,  4, 80,  6, 160,  8, 60, 10, 14, 12, 26, 14,
+    12,  16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30
+};
+
+static const uint8_t DUTY_TABLE[4][8] = {
+    { 0, 1, 0, 0, 0, 0, 0, 0 }, // 12.5%
+    { 0, 1, 1, 0, 0, 0, 0, 0 }, // 25%
+    { 0, 1, 1, 1, 1, 0, 0, 0 }, // 50%
+    { 1, 0, 0, 1, 1, 1, 1, 1 }  // 25% negated
+};
+
+static const uint8_t TRIANGLE_SEQUENCE[32] = {
+    15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15
+};
+
+/* Noise and DMC timer periods in CPU cycles (NTSC) */
+static const uint16_t NOISE_PERIODS[16] = {
+    4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068
+};
+static const uint16_t DMC_PERIODS[16] = {
+    428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54
+};
+
+/*
+Linear approximation of the APU's non-linear mixer, per unit of channel
+level: pulse 1, pulse 2, triangle, noise, DMC. Each channel's steps can then
+be added to the output independently of the others' levels.
+*/
+static const float CHANNEL_GAIN[5] = { 0.00752f, 0.00752f, 0.00851f, 0.00494f, 0.00335f };
+
+/* Advance a timer that does not change the output over [nextClock, end) without visiting each expiry */
+static uint64_t skipClocks(uint64_t& nextClock, uint32_t period, uint64_t end) {
+    if (nextClock >= end) {
+        return 0;
+    }
+    uint64_t clocks = (end - nextClock + period - 1) / period;
+    nextClock += clocks * period;
+    return clocks;
+}
+
+APU::APU(uint32_t sampleRate)
+    : sampleRate(sampleRate),
+      synth(CPU_CLOCK_RATE, SYNTH_RATE, MAX_FRAME_CYCLES),
+      resampler(SYNTH_RATE, sampleRate),
+      output(OUTPUT_BUFFER_SAMPLES),
+      frameSamples(static_cast<size_t>(MAX_FRAME_CYCLES * SYNTH_RATE / CPU_CLOCK_RATE) + 2)
+{
+    pulse1.onesComplement = true;
+}
+
+void APU::reset() {
+    writeRegister(0x4015, 0x00); // Silence all channels
+    frameIRQ = false;
+    DMCIRQ = false;
+    frameStep = 0;
+    frameSequenceStart = timestamp;
+}
+
+void APU::setIRQCallback(const std::function<void()>& callback) {
+    triggerIRQ = callback;
+}
+
+void APU::setMemoryReader(const std::function<uint8_t(uint16_t)>& reader) {
+    memoryRead = reader;
+}
+
+AudioRingBuffer& APU::getOutput() {
+    return output;
+}
+
+uint32_t APU::getSampleRate() const {
+    return sampleRate;
+}
+
+void APU::setRateControl(bool enabled) {
+    rateControl = enabled;
+    if (!enabled) {
+        resampler.setRateAdjustment(1.0);
+    }
+}
+
+void APU::setOutputEnabled(bool enabled) {
+    outputEnabled = enabled;
+}
+
+uint64_t APU::getTimestamp() const {
+    return timestamp;
+}
+
+void APU::saveState(SnapshotWriter& writer) const {
+    FrameCounterState frameCounter{frameSequenceStart, timestamp, fiveStepMode, frameIRQInhibit,
+                                   frameIRQ, DMCIRQ, frameStep, {}};
+
+    writer.beginSection(APU_SECTION, APU_SECTION_VERSION);
+    writer.write(frameCounter);
+    writer.write(pulse1);
+    writer.write(pulse2);
+    writer.write(triangle);
+    writer.write(noise);
+    writer.write(dmc);
+    writer.endSection();
+}
+
+void APU::loadState(SnapshotReader& reader) {
+    reader.beginSection(APU_SECTION, APU_SECTION_VERSION);
+    flushSamples();
+
+    FrameCounterState frameCounter;
+    reader.read(frameCounter);
+    reader.read(pulse1);
+    reader.read(pulse2);
+    reader.read(triangle);
+    reader.read(noise);
+    reader.read(dmc);
+    reader.endSection();
+
+    frameSequenceStart = frameCounter.frameSequenceStart;
+    timestamp = frameCounter.timestamp;
+    fiveStepMode = frameCounter.fiveStepMode != 0;
+    frameIRQInhibit = frameCounter.frameIRQInhibit != 0;
+    frameIRQ = frameCounter.frameIRQ != 0;
+    DMCIRQ = frameCounter.DMCIRQ != 0;
+    frameStep = frameCounter.frameStep;
+
+    /* The synthesiser's frame restarts at the restored time; level changes are heard from there */
+    frameStart = timestamp;
+    updateLevels();
+}
+
+void APU::raiseIRQ() {
+    if (triggerIRQ) {
+        triggerIRQ();
+    }
+}
+
+/* Envelope */
+void APU::Envelope::clock() {
+    if (start) {
+        start = false;
+        decay = 15;
+        divider = volume;
+    } else if (divider == 0) {
+        divider = volume;
+        if (decay > 0) {
+            decay--;
+        } else if (loop) {
+            decay = 15;
+        }
+    } else {
+        divider--;
+    }
+}
+
+/* Pulse */
+uint16_t APU::Pulse::sweepTarget() const {
+    uint16_t change = timer >> sweepShift;
+    if (sweepNegate) {
+        return timer - change - (onesComplement ? 1 : 0);
+    }
+    return timer + change;
+}
+
+void APU::Pulse::clockHalfFrame() {
+    // Sweep: muted channels keep their period
+    bool muted = timer < 8 || sweepTarget() > 0x7FF;
+    if (sweepDivider == 0 && sweepEnabled && sweepShift > 0 && !muted) {
+        timer = sweepTarget();
+    }
+    if (sweepDivider == 0 || sweepReload) {
+        sweepDivider = sweepPeriod;
+        sweepReload = false;
+    } else {
+        sweepDivider--;
+    }
+
+    if (!envelope.loop && length > 0) {
+        length--;
+    }
+}
+
+int APU::Pulse::level() const {
+    if (length == 0 || timer < 8 || sweepTarget() > 0x7FF) {
+        return 0;
+    }
+    return DUTY_TABLE[duty][dutyStep] * envelope.output();
+}
+
+/*
+Channel sequencers. Each channel runs independently between frame counter
+steps and register writes, visiting only the cycles at which its timer
+expires, and reports level changes with their exact cycle. A channel whose
+output cannot change (silenced, halted or at volume 0) skips to the end of
+the batch in one step.
+*/
+void APU::runPulse(Pulse& pulse, int channel, uint64_t end) {
+    uint32_t period = (pulse.timer + 1) * 2; // The timer is clocked every other CPU cycle
+    if (pulse.level() == 0 && (pulse.length == 0 || pulse.envelope.output() == 0 || pulse.timer < 8)) {
+        pulse.dutyStep = (pulse.dutyStep + skipClocks(pulse.nextClock, period, end)) & 0x07;
+        return;
+    }
+
+    while (pulse.nextClock < end) {
+        pulse.dutyStep = (pulse.dutyStep + 1) & 0x07;
+        setLevel(channel, pulse.level(), pulse.nextClock);
+        pulse.nextClock += period;
+    }
+}
+
+void APU::runTriangle(uint64_t end) {
+    uint32_t period = triangle.timer + 1;
+    if (!triangle.active()) {
+        skipClocks(triangle.nextClock, period, end); // Holds its level
+        return;
+    }
+
+    while (triangle.nextClock < end) {
+        triangle.step = (triangle.step + 1) & 0x1F;
+        setLevel(2, TRIANGLE_SEQUENCE[triangle.step], triangle.nextClock);
+        triangle.nextClock += period;
+    }
+}
+
+void APU::runNoise(uint64_t end) {
+    uint32_t period = NOISE_PERIODS[noise.period];
+    int tap = noise.shortMode ? 6 : 1;
+    bool audible = noise.length > 0 && noise.envelope.output() > 0;
+
+    while (noise.nextClock < end) {
+        uint16_t feedback = (noise.shift ^ (noise.shift >> tap)) & 0x01;
+        noise.shift = (noise.shift >> 1) | (feedback << 14);
+        if (audible) {
+            setLevel(3, noise.level(), noise.nextClock);
+        }
+        noise.nextClock += period;
+    }
+}
+
+void APU::runDMC(uint64_t end) {
+    uint32_t period = DMC_PERIODS[dmc.rate];
+    if (dmc.silence && dmc.bufferEmpty) {
+        // Nothing to play: only the bit counter moves
+        uint64_t clocks = skipClocks(dmc.nextClock, period, end);
+        dmc.bitsRemaining = (((dmc.bitsRemaining - 1 - clocks) % 8) + 8) % 8 + 1;
+        return;
+    }
+
+    while (dmc.nextClock < end) {
+        if (!dmc.silence) {
+            if (dmc.shift & 0x01) {
+                if (dmc.level <= 125) {
+                    dmc.level += 2;
+                }
+            } else if (dmc.level >= 2) {
+                dmc.level -= 2;
+            }
+            setLevel(4, dmc.level, dmc.nextClock);
+        }
+        dmc.shift >>= 1;
+
+        // Start a new output cycle with the next sample byte
+        if (--dmc.bitsRemaining == 0) {
+            dmc.bitsRemaining = 8;
+            dmc.silence = dmc.bufferEmpty;
+            if (!dmc.bufferEmpty) {
+                dmc.shift = dmc.sampleBuffer;
+                dmc.bufferEmpty = true;
+                fetchDMCSample();
+            }
+        }
+        dmc.nextClock += period;
+    }
+}
+
+void APU::fetchDMCSample() {
+    if (!dmc.bufferEmpty || dmc.bytesRemaining == 0) {
+        return;
+    }
+
+    dmc.sampleBuffer = memoryRead ? memoryRead(dmc.address) : 0;
+    dmc.bufferEmpty = false;
+    dmc.address = (dmc.address == 0xFFFF) ? 0x8000 : dmc.address + 1;
+
+    if (--dmc.bytesRemaining == 0) {
+        if (dmc.loop) {
+            dmc.address = dmc.sampleAddress;
+            dmc.bytesRemaining = dmc.sampleLength;
+        } else if (dmc.IRQEnabled) {
+            DMCIRQ = true;
+            raiseIRQ();
+        }
+    }
+}
+
+void APU::catchUp(uint64_t cpuCycle) {
+    while (timestamp < cpuCycle) {
+        // Run the channels in one batch up to the next frame counter step
+        uint64_t nextStep = frameSequenceStart + FRAME_STEPS[frameStep];
+        uint64_t end = std::min({ cpuCycle, nextStep, frameStart + MAX_FRAME_CYCLES });
+
+        runPulse(pulse1, 0, end);
+        runPulse(pulse2, 1, end);
+        runTriangle(end);
+        runNoise(end);
+        runDMC(end);
+        timestamp = end;
+
+        if (timestamp == nextStep) {
+            clockFrameCounter();
+        }
+        if (timestamp == frameStart + MAX_FRAME_CYCLES) {
+            flushSamples();
+        }
+    }
+}
+
+uint64_t APU::nextEventCycle() const {
+    uint64_t next = std::numeric_limits<uint64_t>::max();
+
+    // Frame IRQ at the last step of the 4-step sequence
+    if (!fiveStepMode && !frameIRQInhibit) {
+        next = frameSequenceStart + FRAME_STEPS[3];
+    }
+
+    // DMC IRQ once its last byte is fetched; at least 8 output clocks per byte still to come
+    if (dmc.IRQEnabled && !dmc.loop && dmc.bytesRemaining > 0) {
+        uint64_t period = DMC_PERIODS[dmc.rate];
+        next = std::min(next, dmc.nextClock + (dmc.bytesRemaining - 1) * 8 * period);
+    }
+
+    return next;
+}
+
+void APU::endFrame(uint64_t cpuCycle) {
+    catchUp(cpuCycle);
+    flushSamples();
+}
+
+void APU::flushSamples() {
+    synth.endFrame(static_cast<uint32_t>(timestamp - frameStart));
+    frameStart = timestamp;
+
+    size_t count = synth.readSamples(frameSamples.data(), frameSamples.size());
+    if (!outputEnabled) {
+        return;
+    }
+
+    /* Produce slightly more samples while the audio thread runs dry, fewer while it falls behind */
+    if (rateControl) {
+        double target = sampleRate * RATE_CONTROL_LATENCY;
+        double error = (target - output.size()) / target;
+        resampler.setRateAdjustment(1.0 + MAX_RATE_ADJUSTMENT * std::clamp(error, -1.0, 1.0));
+    }
+
+    resampledSamples.clear();
+    resampler.process(frameSamples.data(), count, resampledSamples);
+    output.push(resampledSamples.data(), resampledSamples.size()); // Never waits: samples the audio thread has no room for are dropped
+}
+
+void APU::setLevel(int channel, int level, uint64_t time) {
+    int delta = level - levels[channel];
+    if (delta != 0) {
+        levels[channel] = level;
+        synth.addDelta(static_cast<uint32_t>(time - frameStart), delta * CHANNEL_GAIN[channel]);
+    }
+}
+
+void APU::updateLevels() {
+    setLevel(0, pulse1.level(), timestamp);
+    setLevel(1, pulse2.level(), timestamp);
+    setLevel(2, TRIANGLE_SEQUENCE[triangle.step], timestamp);
+    setLevel(3, noise.level(), timestamp);
+    setLevel(4, dmc.level, timestamp);
+}
+
+/* Frame counter */
+void APU::clockFrameCounter() {
+    if (!fiveStepMode) {
+        clockQuarterFrame();
+        if (frameStep == 1 || frameStep == 3) {
+            clockHalfFrame();
+        }
+        if (frameStep == 3 && !frameIRQInhibit) {
+            frameIRQ = true;
+            raiseIRQ();
+        }
+    } else if (frameStep != 3) {
+        // The 5-step sequence does nothing on its fourth step
+        clockQuarterFrame();
+        if (frameStep == 1 || frameStep == 4) {
+            clockHalfFrame();
+        }
+    }
+
+    // Wrap to the start of the next sequence
+    frameStep++;
+    if (frameStep == (fiveStepMode ? 5 : 4)) {
+        frameStep = 0;
+        frameSequenceStart += fiveStepMode ? FIVE_STEP_LENGTH : FOUR_STEP_LENGTH;
+    }
+
+    updateLevels();
+}
+
+void APU::clockQuarterFrame() {
+    pulse1.envelope.clock();
+    pulse2.envelope.clock();
+    noise.envelope.clock();
+
+    if (triangle.linearReload) {
+        triangle.linear = triangle.linearReloadValue;
+    } else if (triangle.linear > 0) {
+        triangle.linear--;
+    }
+    if (!triangle.control) {
+        triangle.linearReload = false;
+    }
+}
+
+void APU::clockHalfFrame() {
+    pulse1.clockHalfFrame();
+    pulse2.clockHalfFrame();
+    if (!triangle.control && triangle.length > 0) {
+        triangle.length--;
+    }
+    if (!noise.envelope.loop && noise.length > 0) {
+        noise.length--;
+    }
+}
+
+/* Registers */
+uint8_t APU::readStatus() {
+    uint8_t status = 0;
+    if (pulse1.length > 0)       status |= (1 << 0);
+    if (pulse2.length > 0)       status |= (1 << 1);
+    if (triangle.length > 0)     status |= (1 << 2);
+    if (noise.length > 0)        status |= (1 << 3);
+    if (dmc.bytesRemaining > 0)  status |= (1 << 4);
+    if (frameIRQ)                status |= (1 << 6);
+    if (DMCIRQ)                  status |= (1 << 7);
+
+    frameIRQ = false; // Reading acknowledges the frame IRQ
+    return status;
+}
+
+void APU::writeRegister(uint16_t address, uint8_t value) {
+    switch (address) {
+        case 0x4000: // Pulse duty, length halt, envelope
+        case 0x4004: {
+            Pulse& pulse = (address == 0x4000) ? pulse1 : pulse2;
+            pulse.duty = value >> 6;
+            pulse.envelope.loop = value & 0x20;
+            pulse.envelope.constant = value & 0x10;
+            pulse.envelope.volume = value & 0x0F;
+            break;
+        }
+        case 0x4001: // Pulse sweep
+        case 0x4005: {
+            Pulse& pulse = (address == 0x4001) ? pulse1 : pulse2;
+            pulse.sweepEnabled = value & 0x80;
+            pulse.sweepPeriod = (value >> 4) & 0x07;
+            pulse.sweepNegate = value & 0x08;
+            pulse.sweepShift = value & 0x07;
+            pulse.sweepReload = true;
+            break;
+        }
+        case 0x4002: // Pulse timer low
+        case 0x4006: {
+            Pulse& pulse = (address == 0x4002) ? pulse1 : pulse2;
+            pulse.timer = (pulse.timer & 0x0700) | value;
+            break;
+        }
+        case 0x4003: // Pulse length load, timer high
+        case 0x4007: {
+            Pulse& pulse = (address == 0x4003) ? pulse1 : pulse2;
+            pulse.timer = (pulse.timer & 0x00FF) | ((value & 0x07) << 8);
+            if (pulse.enabled) {
+                pulse.length = LENGTH_TABLE[value >> 3];
+            }
+            pulse.envelope.start = true;
+            pulse.dutyStep = 0;
+            break;
+        }
+        case 0x4008: // Triangle linear counter
+            triangle.control = value & 0x80;
+            triangle.linearReloadValue = value & 0x7F;
+            break;
+        case 0x400A: // Triangle timer low
+            triangle.timer = (triangle.timer & 0x0700) | value;
+            break;
+        case 0x400B: // Triangle length load, timer high
+            triangle.timer = (triangle.timer & 0x00FF) | ((value & 0x07) << 8);
+            if (triangle.enabled) {
+                triangle.length = LENGTH_TABLE[value >> 3];
+            }
+            triangle.linearReload = true;
+            break;
+        case 0x400C: // Noise length halt, envelope
+            noise.envelope.loop = value & 0x20;
+            noise.envelope.constant = value & 0x10;
+            noise.envelope.volume = value & 0x0F;
+            break;
+        case 0x400E: // Noise mode and period
+            noise.shortMode = value & 0x80;
+            noise.period = value & 0x0F;
+            break;
+        case 0x400F: // Noise length load
+            if (noise.enabled) {
+                noise.length = LENGTH_TABLE[value >> 3];
+            }
+            noise.envelope.start = true;
+            break;
+        case 0x4010: // DMC IRQ enable, loop, rate
+            dmc.IRQEnabled = value & 0x80;
+            dmc.loop = value & 0x40;
+            dmc.rate = value & 0x0F;
+            if (!dmc.IRQEnabled) {
+                DMCIRQ = false;
+            }
+            break;
+        case 0x4011: // DMC direct load
+            dmc.level = value & 0x7F;
+            break;
+        case 0x4012: // DMC sample address
+            dmc.sampleAddress = 0xC000 + value * 64;
+            break;
+        case 0x4013: // DMC sample length
+            dmc.sampleLength = value * 16 + 1;
+            break;
+        case 0x4015: // Channel enables
+            pulse1.enabled = value & 0x01;
+            pulse2.enabled = value & 0x02;
+            triangle.enabled = value & 0x04;
+            noise.enabled = value & 0x08;
+            if (!pulse1.enabled)   pulse1.length = 0;
+            if (!pulse2.enabled)   pulse2.length = 0;
+            if (!triangle.enabled) triangle.length = 0;
+            if (!noise.enabled)    noise.length = 0;
+
+            DMCIRQ = false;
+            if (!(value & 0x10)) {
+                dmc.bytesRemaining = 0;
+            } else if (dmc.bytesRemaining == 0) {
+                dmc.address = dmc.sampleAddress;
+                dmc.bytesRemaining = dmc.sampleLength;
+                fetchDMCSample();
+            }
+            break;
+        case 0x4017: // Frame counter mode and IRQ inhibit
+            fiveStepMode = value & 0x80;
+            frameIRQInhibit = value & 0x40;
+            if (frameIRQInhibit) {
+                frameIRQ = false;
+            }
+
+            // Restart the sequence; the 5-step mode clocks all units immediately
+            frameStep = 0;
+            frameSequenceStart = timestamp;
+            if (fiveStepMode) {
+                clockQuarterFrame();
+                clockHalfFrame();
+            }
+            break;
+        default:
+            break;
+    }
+
+    updateLevels();
+}
@@ -0,0 +1,335 @@
+/**
+ * @file apu.h
+ * @brief Represents the APU (audio processing unit) of the NES.
+ *
+ * This file defines the APU class, which emulates the two pulse channels,
+ * the triangle, noise and delta modulation (DMC) channels and the frame
+ * counter, and produces band-limited audio samples for the frontend.
+ */
+
+#ifndef APU_H
+#define APU_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "audio_ring_buffer.h"
+#include "band_limited_synth.h"
+#include "resampler.h"
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/**
+ * @class APU
+ * @brief Emulates the NES APU and streams its output into an AudioRingBuffer.
+ *
+ * Like the PPU, the APU is run lazily: it is caught up to the CPU's master
+ * clock only when one of its registers is accessed, when its next IRQ is
+ * due, and at the end of each video frame. Catching up moves each channel
+ * from one timer expiry to the next instead of cycle by cycle, and silent
+ * channels skip whole stretches at once. Every change in a channel's level
+ * is passed to a BandLimitedSynth running at a fixed internal rate; at the
+ * end of each frame its samples are converted to the output rate by a
+ * Resampler and pushed to the ring buffer for the audio thread.
+ */
+class APU
+{
+    public:
+        static constexpr double CPU_CLOCK_RATE = 1789773.0;     /**< NTSC CPU clock in Hz; the APU's time base. */
+        static constexpr uint32_t DEFAULT_SAMPLE_RATE = 48000; /**< Default output sample rate in Hz. */
+        static constexpr double SYNTH_RATE = CPU_CLOCK_RATE / 32; /**< Internal synthesis rate in Hz. */
+
+        /**
+         * @brief Constructs an APU in its power-on state.
+         * @param sampleRate Output sample rate in Hz.
+         */
+        explicit APU(uint32_t sampleRate = DEFAULT_SAMPLE_RATE);
+
+        /**
+         * @brief Silences all channels and restarts the frame counter, as the reset line does.
+         */
+        void reset();
+
+        /**
+         * @brief Writes to an APU register ($4000-$4013, $4015 or $4017).
+         *
+         * The APU must already be caught up to the time of the write.
+         *
+         * @param address The register address.
+         * @param value The value written.
+         */
+        void writeRegister(uint16_t address, uint8_t value);
+
+        /**
+         * @brief Reads the status register ($4015), acknowledging the frame IRQ.
+         * @return Length counter status (bits 0-3), DMC active (bit 4), frame IRQ (bit 6), DMC IRQ (bit 7).
+         */
+        uint8_t readStatus();
+
+        /**
+         * @brief Returns true while the frame or DMC IRQ flag holds the CPU IRQ line low.
+         *
+         * The line drops once both are acknowledged: $4015 reads and $4017
+         * writes with the inhibit bit clear the frame IRQ, $4015 writes and
+         * $4010 writes with IRQ disabled clear the DMC IRQ.
+         */
+        bool isIRQAsserted() const { return frameIRQ || DMCIRQ; }
+
+        /**
+         * @brief Runs the APU up to a CPU cycle.
+         * @param cpuCycle Absolute CPU cycle to run up to.
+         */
+        void catchUp(uint64_t cpuCycle);
+
+        /**
+         * @brief Predicts the CPU cycle of the next APU event the CPU could observe (an IRQ).
+         * @return The CPU cycle, or UINT64_MAX if no IRQ is pending.
+         */
+        uint64_t nextEventCycle() const;
+
+        /**
+         * @brief Catches up and pushes the samples synthesised so far to the output buffer.
+         *
+         * Called once per video frame; the samples of a frame only become
+         * available to the audio thread when it ends.
+         *
+         * @param cpuCycle Absolute CPU cycle at which the frame ends.
+         */
+        void endFrame(uint64_t cpuCycle);
+
+        /**
+         * @brief Gets the ring buffer receiving the mono 16-bit output samples.
+         * @return The buffer; the audio thread is its only consumer.
+         */
+        AudioRingBuffer& getOutput();
+
+        /**
+         * @brief Gets the output sample rate.
+         * @return Samples per second.
+         */
+        uint32_t getSampleRate() const;
+
+        /**
+         * @brief Enables dynamic rate control of the output.
+         *
+         * The output rate is then adjusted by up to 0.5% each frame to keep
+         * the ring buffer near a fixed latency, absorbing the drift between
+         * the frontend's frame pacing and the audio device's clock. Leave it
+         * off when the output is drained as fast as it is produced (WAV dumps).
+         *
+         * @param enabled True to adjust the rate to the ring buffer's fill level.
+         */
+        void setRateControl(bool enabled);
+
+        /**
+         * @brief Enables or mutes the output.
+         *
+         * While muted, frames are still synthesised but their samples are
+         * discarded instead of reaching the ring buffer; used for frames
+         * emulated only to be thrown away (run-ahead).
+         *
+         * @param enabled False to discard the samples.
+         */
+        void setOutputEnabled(bool enabled);
+
+        /**
+         * @brief Gets the CPU cycle the APU has been run up to.
+         * @return The APU timestamp.
+         */
+        uint64_t getTimestamp() const;
+
+        /**
+         * @brief Writes the channels and frame counter to a snapshot section.
+         *
+         * The synthesiser and resampler are not saved: they only shape the
+         * output, so restoring a snapshot continues the audio stream rather
+         * than replaying it.
+         *
+         * @param writer The snapshot being written.
+         */
+        void saveState(SnapshotWriter& writer) const;
+
+        /**
+         * @brief Restores the section written by saveState().
+         *
+         * Samples synthesised before the restore are flushed to the output
+         * first, and the channel levels then step to the restored state.
+         *
+         * @param reader The snapshot being read.
+         */
+        void loadState(SnapshotReader& reader);
+
+        // Register callbacks for raising the IRQ and fetching DMC sample bytes
+        void setIRQCallback(const std::function<void()>& callback);
+        void setMemoryReader(const std::function<uint8_t(uint16_t)>& reader);
+
+    private:
+        /** @brief Volume envelope shared by the pulse and noise channels. */
+        struct Envelope {
+            bool start = false;    // Restart on the next quarter frame
+            bool loop = false;     // Restart the decay at 0 (also halts the length counter)
+            bool constant = false; // Output the volume instead of the decay level
+            uint8_t volume = 0;    // Constant volume, or divider period
+            uint8_t divider = 0;
+            uint8_t decay = 0;
+
+            /** @brief Clocks the envelope (quarter frame). */
+            void clock();
+
+            /** @brief Gets the current volume (0-15). */
+            uint8_t output() const { return constant ? volume : decay; }
+        };
+
+        /** @brief Pulse (square wave) channel with sweep unit. */
+        struct Pulse {
+            Envelope envelope;
+            bool enabled = false;
+            bool onesComplement = false; // Pulse 1 negates its sweep with one's complement
+            uint8_t duty = 0;
+            uint8_t dutyStep = 0;
+            uint16_t timer = 0;
+            uint8_t length = 0;
+            bool sweepEnabled = false;
+            bool sweepNegate = false;
+            bool sweepReload = false;
+            uint8_t sweepPeriod = 0;
+            uint8_t sweepShift = 0;
+            uint8_t sweepDivider = 0;
+            uint8_t reserved[5] = {}; // Explicit padding: snapshots copy the struct's bytes
+            uint64_t nextClock = 0; // CPU cycle of the next sequencer step
+
+            /** @brief Gets the timer period the sweep unit is moving towards. */
+            uint16_t sweepTarget() const;
+
+            /** @brief Clocks the sweep unit and length counter (half frame). */
+            void clockHalfFrame();
+
+            /** @brief Gets the current output level (0-15). */
+            int level() const;
+        };
+
+        /** @brief Triangle channel with linear counter. */
+        struct Triangle {
+            bool enabled = false;
+            bool control = false;       // Halts the length counter and keeps reloading the linear counter
+            bool linearReload = false;
+            uint8_t linearReloadValue = 0;
+            uint8_t linear = 0;
+            uint8_t step = 0;
+            uint16_t timer = 0;
+            uint8_t length = 0;
+            uint8_t reserved[7] = {};
+            uint64_t nextClock = 0;
+
+            /** @brief Returns true if the sequencer advances (both counters non-zero, audible period). */
+            bool active() const { return linear > 0 && length > 0 && timer >= 2; }
+        };
+
+        /** @brief Pseudo-random noise channel. */
+        struct Noise {
+            Envelope envelope;
+            bool enabled = false;
+            bool shortMode = false; // Feedback from bit 6 instead of bit 1
+            uint16_t shift = 1;     // 15-bit linear feedback shift register
+            uint8_t length = 0;
+            uint8_t period = 0;     // Index into the period table
+            uint8_t reserved[4] = {};
+            uint64_t nextClock = 0;
+
+            /** @brief Gets the current output level (0-15). */
+            int level() const { return (length == 0 || (shift & 0x01)) ? 0 : envelope.output(); }
+        };
+
+        /** @brief Delta modulation channel playing 1-bit delta samples from PRG memory. */
+        struct DMC {
+            bool IRQEnabled = false;
+            bool loop = false;
+            uint8_t rate = 0;          // Index into the rate table
+            uint8_t level = 0;         // 7-bit output level
+            uint16_t sampleAddress = 0xC000;
+            uint16_t sampleLength = 1;
+            uint16_t address = 0xC000; // Next byte to fetch
+            uint16_t bytesRemaining = 0;
+            uint8_t sampleBuffer = 0;
+            bool bufferEmpty = true;
+            uint8_t shift = 0;
+            uint8_t bitsRemaining = 8;
+            bool silence = true;
+            uint8_t reserved[7] = {};
+            uint64_t nextClock = 0;
+        };
+
+        /** @brief Runs a pulse channel's sequencer up to (excluding) a CPU cycle. */
+        void runPulse(Pulse& pulse, int channel, uint64_t end);
+
+        /** @brief Runs the triangle channel's sequencer up to (excluding) a CPU cycle. */
+        void runTriangle(uint64_t end);
+
+        /** @brief Runs the noise channel's shift register up to (excluding) a CPU cycle. */
+        void runNoise(uint64_t end);
+
+        /** @brief Runs the DMC's output unit up to (excluding) a CPU cycle. */
+        void runDMC(uint64_t end);
+
+        /** @brief Fills the DMC sample buffer from memory if it is empty and bytes remain. */
+        void fetchDMCSample();
+
+        /** @brief Clocks the frame counter sequencer at its current step. */
+        void clockFrameCounter();
+
+        /** @brief Clocks envelopes and the triangle's linear counter. */
+        void clockQuarterFrame();
+
+        /** @brief Clocks length counters and sweep units. */
+        void clockHalfFrame();
+
+        /** @brief Re-emits every channel's level after its state changed outside its sequencer. */
+        void updateLevels();
+
+        /**
+         * @brief Records a channel's new output level as a step in the synthesised signal.
+         * @param channel Channel index (0-1 pulse, 2 triangle, 3 noise, 4 DMC).
+         * @param level The channel's output level.
+         * @param time CPU cycle at which the level changes.
+         */
+        void setLevel(int channel, int level, uint64_t time);
+
+        /** @brief Resamples the completed samples of the synthesiser into the output buffer. */
+        void flushSamples();
+
+        /** @brief Raises the IRQ line through the callback. */
+        void raiseIRQ();
+
+        Pulse pulse1;
+        Pulse pulse2;
+        Triangle triangle;
+        Noise noise;
+        DMC dmc;
+
+        bool fiveStepMode = false;     // Frame counter sequence: 5-step (no IRQ) or 4-step
+        bool frameIRQInhibit = false;
+        bool frameIRQ = false;         // Frame counter IRQ flag ($4015 bit 6)
+        bool DMCIRQ = false;           // DMC IRQ flag ($4015 bit 7)
+        uint8_t frameStep = 0;         // Next step of the frame counter sequence
+        uint64_t frameSequenceStart = 0; // CPU cycle at which the current sequence started
+
+        std::array<int, 5> levels{};   // Last output level of each channel
+        uint64_t timestamp = 0;        // CPU cycle the APU has been run up to
+        uint64_t frameStart = 0;       // CPU cycle of the synthesiser's frame start
+
+        uint32_t sampleRate;
+        bool rateControl = false;
+        bool outputEnabled = true;
+        BandLimitedSynth synth;
+        Resampler resampler;
+        AudioRingBuffer output;
+        std::vector<int16_t> frameSamples;     // Scratch space for the synthesiser's samples
+        std::vector<int16_t> resampledSamples; // Scratch space for the output-rate samples
+
+        std::function<void()> triggerIRQ;               // IRQ callback function
+        std::function<uint8_t(uint16_t)> memoryRead;    // DMC sample fetch callback
+};
+
+#endif // APU_H
@@ -0,0 +1,59 @@
+#include "audio_ring_buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+AudioRingBuffer::AudioRingBuffer(size_t capacity)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("Audio buffer capacity must be non-zero.");
+    }
+
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    samples.resize(size, 0);
+    mask = size - 1;
+}
+
+size_t AudioRingBuffer::push(const int16_t* data, size_t count)
+{
+    size_t write = writePosition.load(std::memory_order_relaxed);
+    size_t read = readPosition.load(std::memory_order_acquire);
+    count = std::min(count, samples.size() - (write - read));
+
+    // Copy in at most two pieces, around the end of the storage
+    size_t start = write & mask;
+    size_t first = std::min(count, samples.size() - start);
+    std::memcpy(&samples[start], data, first * sizeof(int16_t));
+    std::memcpy(&samples[0], data + first, (count - first) * sizeof(int16_t));
+
+    writePosition.store(write + count, std::memory_order_release);
+    return count;
+}
+
+size_t AudioRingBuffer::pop(int16_t* data, size_t count)
+{
+    size_t read = readPosition.load(std::memory_order_relaxed);
+    size_t write = writePosition.load(std::memory_order_acquire);
+    count = std::min(count, write - read);
+
+    size_t start = read & mask;
+    size_t first = std::min(count, samples.size() - start);
+    std::memcpy(data, &samples[start], first * sizeof(int16_t));
+    std::memcpy(data + first, &samples[0], (count - first) * sizeof(int16_t));
+
+    readPosition.store(read + count, std::memory_order_release);
+    return count;
+}
+
+size_t AudioRingBuffer::size() const
+{
+    return writePosition.load(std::memory_order_acquire) - readPosition.load(std::memory_order_acquire);
+}
+
+size_t AudioRingBuffer::capacity() const
+{
+    return samples.size();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file audio_ring_buffer.h
+ * @brief Defines the lock-free single-producer/single-consumer ring buffer carrying audio samples.
+ */
+
+#ifndef AUDIO_RING_BUFFER_H
+#define AUDIO_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class AudioRingBuffer
+ * @brief Lock-free ring buffer of 16-bit samples between the emulation and audio threads.
+ *
+ * Exactly one thread may push (the emulator) and one thread may pop (the
+ * audio output). Neither side ever waits for the other: a push into a full
+ * buffer drops the samples that do not fit, and a pop from an empty buffer
+ * returns fewer samples than requested.
+ */
+class AudioRingBuffer {
+public:
+    /**
+     * @brief Deleted default constructor.
+     */
+    AudioRingBuffer() = delete;
+
+    /**
+     * @brief Constructs a ring buffer holding at least the given number of samples.
+     * @param capacity Minimum capacity in samples; rounded up to a power of two.
+     */
+    explicit AudioRingBuffer(size_t capacity);
+
+    /**
+     * @brief Appends samples (producer thread only).
+     * @param data The samples to append.
+     * @param count Number of samples.
+     * @return The number of samples written; less than count if the buffer filled up.
+     */
+    size_t push(const int16_t* data, size_t count);
+
+    /**
+     * @brief Removes the oldest samples (consumer thread only).
+     * @param data Destination for the samples.
+     * @param count Maximum number of samples to remove.
+     * @return The number of samples read; less than count if the buffer ran empty.
+     */
+    size_t pop(int16_t* data, size_t count);
+
+    /**
+     * @brief Gets the number of samples buffered.
+     *
+     * Exact on the consumer thread; a lower bound on the producer thread.
+     *
+     * @return The number of samples that can be popped.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the capacity of the buffer.
+     * @return The maximum number of samples buffered.
+     */
+    size_t capacity() const;
+
+private:
+    std::vector<int16_t> samples; /**< Sample storage; its size is a power of two. */
+    size_t mask;                  /**< samples.size() - 1, to wrap positions. */
+
+    // Positions increase monotonically and are wrapped on access; each is
+    // written by one side only and kept on its own cache line.
+    alignas(64) std::atomic<size_t> writePosition{0}; /**< Written by the producer. */
+    alignas(64) std::atomic<size_t> readPosition{0};  /**< Written by the consumer. */
+};
+
+#endif // AUDIO_RING_BUFFER_H
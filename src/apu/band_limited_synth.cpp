@@ -0,0 +1,100 @@
+#include "band_limited_synth.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+/* Fraction of the output sample rate passed by the kernels (0.5 is Nyquist) */
+constexpr double CUTOFF = 0.45;
+
+/* Corner frequency of the DC-removing high-pass, in Hz */
+constexpr double DC_CUTOFF_HZ = 20.0;
+
+BandLimitedSynth::BandLimitedSynth(double clockRate, double sampleRate, uint32_t maxFrameClocks)
+    : sampleRate(sampleRate)
+{
+    if (clockRate <= 0.0 || sampleRate <= 0.0 || sampleRate > clockRate) {
+        throw std::invalid_argument("Sample rate must be positive and no higher than the clock rate.");
+    }
+    factor = static_cast<uint64_t>(sampleRate / clockRate * 4294967296.0 + 0.5);
+    dcRate = static_cast<float>(1.0 - std::exp(-2.0 * M_PI * DC_CUTOFF_HZ / sampleRate));
+
+    /* Room for two frames of samples (one unread) plus the kernel tail */
+    size_t frameSamples = ((static_cast<uint64_t>(maxFrameClocks) * factor) >> 32) + 1;
+    buffer.assign(2 * frameSamples + KERNEL_WIDTH, 0.0f);
+
+    /* Blackman-windowed sinc impulses, one per sub-sample phase, each summing to 1 */
+    kernel.resize(PHASES * KERNEL_WIDTH);
+    for (int phase = 0; phase < PHASES; ++phase) {
+        double fraction = static_cast<double>(phase) / PHASES;
+        double sum = 0.0;
+        for (int k = 0; k < KERNEL_WIDTH; ++k) {
+            double x = k - KERNEL_WIDTH / 2 - fraction; // Distance from the impulse centre
+            double t = (k - fraction) / KERNEL_WIDTH;   // Position within the window (0-1)
+            double sinc = (x == 0.0) ? 2.0 * CUTOFF : std::sin(2.0 * M_PI * CUTOFF * x) / (M_PI * x);
+            double window = 0.42 - 0.5 * std::cos(2.0 * M_PI * t) + 0.08 * std::cos(4.0 * M_PI * t);
+            kernel[phase * KERNEL_WIDTH + k] = static_cast<float>(sinc * window);
+            sum += sinc * window;
+        }
+        for (int k = 0; k < KERNEL_WIDTH; ++k) {
+            kernel[phase * KERNEL_WIDTH + k] = static_cast<float>(kernel[phase * KERNEL_WIDTH + k] / sum);
+        }
+    }
+}
+
+void BandLimitedSynth::addDelta(uint32_t time, float delta)
+{
+    uint64_t position = offset + time * factor;
+    const float* taps = &kernel[((position >> (32 - PHASE_BITS)) & (PHASES - 1)) * KERNEL_WIDTH];
+    float* out = &buffer[position >> 32];
+    for (int k = 0; k < KERNEL_WIDTH; ++k) {
+        out[k] += taps[k] * delta;
+    }
+}
+
+void BandLimitedSynth::endFrame(uint32_t duration)
+{
+    offset += duration * factor;
+
+    /* Keep at most one frame unread so the next frame always fits */
+    size_t limit = buffer.size() / 2 - KERNEL_WIDTH;
+    if (samplesAvailable() > limit) {
+        removeSamples(nullptr, samplesAvailable() - limit);
+    }
+}
+
+size_t BandLimitedSynth::samplesAvailable() const
+{
+    return offset >> 32;
+}
+
+size_t BandLimitedSynth::readSamples(int16_t* out, size_t count)
+{
+    count = std::min(count, samplesAvailable());
+    removeSamples(out, count);
+    return count;
+}
+
+double BandLimitedSynth::getSampleRate() const
+{
+    return sampleRate;
+}
+
+void BandLimitedSynth::removeSamples(int16_t* out, size_t count)
+{
+    /* Integrate the differences into levels and remove the DC offset */
+    for (size_t i = 0; i < count; ++i) {
+        integrator += buffer[i];
+        dcLevel += (integrator - dcLevel) * dcRate;
+        if (out) {
+            float sample = (integrator - dcLevel) * 32767.0f;
+            out[i] = static_cast<int16_t>(std::clamp(sample, -32768.0f, 32767.0f));
+        }
+    }
+
+    /* Move the unread samples and the kernel tails of recent steps to the front */
+    size_t pending = samplesAvailable() - count + KERNEL_WIDTH;
+    std::memmove(buffer.data(), buffer.data() + count, pending * sizeof(float));
+    std::fill(buffer.begin() + pending, buffer.begin() + std::min(pending + count, buffer.size()), 0.0f);
+    offset -= static_cast<uint64_t>(count) << 32;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file band_limited_synth.h
+ * @brief Defines the band-limited step synthesiser turning APU level changes into output samples.
+ */
+
+#ifndef BAND_LIMITED_SYNTH_H
+#define BAND_LIMITED_SYNTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class BandLimitedSynth
+ * @brief Converts a signal described by its level changes (steps) into samples at a lower rate.
+ *
+ * The APU's channels are square, triangle-step and noise waveforms that only
+ * change level at discrete clock cycles. Instead of producing a sample per
+ * clock and filtering, each change is added to the output as a band-limited
+ * step: a pre-computed windowed-sinc kernel, chosen by the sub-sample phase
+ * of the change, is accumulated into a difference buffer which is integrated
+ * when samples are read. The cost is proportional to the number of level
+ * changes, not the clock rate, and steps between samples do not alias.
+ *
+ * Times are given in input clocks relative to the start of the current frame;
+ * endFrame() closes the frame and makes its samples available.
+ */
+class BandLimitedSynth {
+public:
+    static constexpr int KERNEL_WIDTH = 16; /**< Output samples touched by one step. */
+    static constexpr int PHASE_BITS = 6;    /**< Sub-sample resolution of step positions. */
+    static constexpr int PHASES = 1 << PHASE_BITS;
+
+    /**
+     * @brief Deleted default constructor.
+     */
+    BandLimitedSynth() = delete;
+
+    /**
+     * @brief Constructs a synthesiser.
+     * @param clockRate Input clock rate in Hz (the rate step times are given in).
+     * @param sampleRate Output sample rate in Hz.
+     * @param maxFrameClocks Longest frame, in input clocks, that will be passed to endFrame().
+     */
+    BandLimitedSynth(double clockRate, double sampleRate, uint32_t maxFrameClocks);
+
+    /**
+     * @brief Adds a step to the output.
+     * @param time Clocks since the start of the frame; must not exceed maxFrameClocks.
+     * @param delta Change in output level (full scale is 1.0).
+     */
+    void addDelta(uint32_t time, float delta);
+
+    /**
+     * @brief Ends the current frame; the next frame starts where it ended.
+     * @param duration Length of the frame in clocks.
+     */
+    void endFrame(uint32_t duration);
+
+    /**
+     * @brief Gets the number of completed samples waiting to be read.
+     * @return The number of samples readSamples() can return.
+     */
+    size_t samplesAvailable() const;
+
+    /**
+     * @brief Reads and removes completed samples, with the DC offset removed.
+     * @param out Destination for the samples.
+     * @param count Maximum number of samples to read.
+     * @return The number of samples read.
+     */
+    size_t readSamples(int16_t* out, size_t count);
+
+    /**
+     * @brief Gets the output sample rate.
+     * @return Samples per second.
+     */
+    double getSampleRate() const;
+
+private:
+    /** @brief Band-limited impulses, one row of KERNEL_WIDTH taps per phase. */
+    std::vector<float> kernel;
+
+    /** @brief Step differences accumulated per output sample, not yet integrated. */
+    std::vector<float> buffer;
+
+    double sampleRate;   /**< Output sample rate in Hz. */
+    uint64_t factor;     /**< Output samples per clock, 32.32 fixed point. */
+    uint64_t offset = 0; /**< Position of the frame start in output samples, 32.32 fixed point. */
+    float integrator = 0.0f; /**< Running sum of the differences: the current output level. */
+    float dcLevel = 0.0f;    /**< Slowly tracked average level, subtracted as a high-pass. */
+    float dcRate;            /**< Per-sample rate at which dcLevel follows the output. */
+
+    /**
+     * @brief Removes integrated samples from the front of the buffer.
+     * @param out Destination for the samples, or nullptr to drop them.
+     * @param count Number of samples; at most samplesAvailable().
+     */
+    void removeSamples(int16_t* out, size_t count);
+};
+
+#endif // BAND_LIMITED_SYNTH_H
@@ -0,0 +1,165 @@
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if !defined(NES_APU_SCALAR_ONLY) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RESAMPLER_X86 1
+#include <immintrin.h>
+#endif
+
+/* Fraction of the lower of the two rates' Nyquist band kept by the filter */
+constexpr double PASSBAND = 0.9;
+
+/* Bits of the 32-bit position fraction selecting the phase; the rest interpolates between phases */
+constexpr int PHASE_SHIFT = 32 - 6;
+static_assert((1 << 6) == Resampler::PHASES, "PHASE_SHIFT must match PHASES");
+
+namespace {
+
+#ifdef RESAMPLER_X86
+
+__attribute__((target("sse2")))
+inline float horizontalSum(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+    return _mm_cvtss_f32(v);
+}
+
+__attribute__((target("sse2")))
+float resampleSSE2(const float* samples, const float* phase, const float* nextPhase, float fraction) {
+    __m128 sum = _mm_setzero_ps();
+    __m128 nextSum = _mm_setzero_ps();
+    for (int k = 0; k < Resampler::TAPS; k += 4) {
+        __m128 s = _mm_loadu_ps(samples + k);
+        sum = _mm_add_ps(sum, _mm_mul_ps(s, _mm_loadu_ps(phase + k)));
+        nextSum = _mm_add_ps(nextSum, _mm_mul_ps(s, _mm_loadu_ps(nextPhase + k)));
+    }
+    float a = horizontalSum(sum);
+    float b = horizontalSum(nextSum);
+    return a + (b - a) * fraction;
+}
+
+__attribute__((target("avx2")))
+float resampleAVX2(const float* samples, const float* phase, const float* nextPhase, float fraction) {
+    __m256 sum = _mm256_setzero_ps();
+    __m256 nextSum = _mm256_setzero_ps();
+    for (int k = 0; k < Resampler::TAPS; k += 8) {
+        __m256 s = _mm256_loadu_ps(samples + k);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(s, _mm256_loadu_ps(phase + k)));
+        nextSum = _mm256_add_ps(nextSum, _mm256_mul_ps(s, _mm256_loadu_ps(nextPhase + k)));
+    }
+    float a = horizontalSum(_mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+    float b = horizontalSum(_mm_add_ps(_mm256_castps256_ps128(nextSum), _mm256_extractf128_ps(nextSum, 1)));
+    return a + (b - a) * fraction;
+}
+
+bool hostSupportsAVX2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+bool hostSupportsSSE2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+#endif // RESAMPLER_X86
+
+} // namespace
+
+float resampleScalar(const float* samples, const float* phase, const float* nextPhase, float fraction) {
+    float a = 0.0f;
+    float b = 0.0f;
+    for (int k = 0; k < Resampler::TAPS; ++k) {
+        a += samples[k] * phase[k];
+        b += samples[k] * nextPhase[k];
+    }
+    return a + (b - a) * fraction;
+}
+
+ResampleKernel selectResampleKernel() {
+#ifdef RESAMPLER_X86
+    if (hostSupportsAVX2()) {
+        return resampleAVX2;
+    }
+    if (hostSupportsSSE2()) {
+        return resampleSSE2;
+    }
+#endif
+    return resampleScalar;
+}
+
+Resampler::Resampler(double inputRate, double outputRate)
+    : inputRate(inputRate), outputRate(outputRate), kernel(selectResampleKernel())
+{
+    if (inputRate <= 0.0 || outputRate <= 0.0) {
+        throw std::invalid_argument("Resampler rates must be positive.");
+    }
+    setRateAdjustment(1.0);
+
+    /* Blackman-windowed sinc low-pass below the lower Nyquist frequency, one row per phase */
+    double cutoff = 0.5 * PASSBAND * std::min(inputRate, outputRate) / inputRate; // Cycles per input sample
+    taps.resize((PHASES + 1) * TAPS);
+    for (int phase = 0; phase <= PHASES; ++phase) {
+        double sum = 0.0;
+        for (int k = 0; k < TAPS; ++k) {
+            // Output position: phase / PHASES past the sample at TAPS / 2 - 1
+            double x = k - (TAPS / 2 - 1) - static_cast<double>(phase) / PHASES;
+            double sinc = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+            double window = 0.42 + 0.5 * std::cos(2.0 * M_PI * x / TAPS) + 0.08 * std::cos(4.0 * M_PI * x / TAPS);
+            taps[phase * TAPS + k] = static_cast<float>(sinc * window);
+            sum += sinc * window;
+        }
+        for (int k = 0; k < TAPS; ++k) {
+            taps[phase * TAPS + k] = static_cast<float>(taps[phase * TAPS + k] / sum); // Unity gain at DC
+        }
+    }
+
+    /* Silence before the first input sample, so the first output is centred on it */
+    history.assign(TAPS / 2 - 1, 0.0f);
+}
+
+void Resampler::setRateAdjustment(double adjustment) {
+    step = static_cast<uint64_t>(inputRate / (outputRate * adjustment) * 4294967296.0 + 0.5);
+}
+
+size_t Resampler::process(const int16_t* input, size_t count, std::vector<int16_t>& output) {
+    /* Append the block to the samples kept from the previous one */
+    size_t kept = history.size();
+    history.resize(kept + count);
+    for (size_t i = 0; i < count; ++i) {
+        history[kept + i] = input[i] * (1.0f / 32768.0f);
+    }
+
+    /* Filter every output whose window is complete */
+    size_t produced = 0;
+    while ((position >> 32) + TAPS <= history.size()) {
+        uint32_t fraction = static_cast<uint32_t>(position);
+        const float* phase = &taps[(fraction >> PHASE_SHIFT) * TAPS];
+        float between = (fraction & ((1u << PHASE_SHIFT) - 1)) * (1.0f / (1u << PHASE_SHIFT));
+
+        float sample = kernel(&history[position >> 32], phase, phase + TAPS, between) * 32768.0f;
+        output.push_back(static_cast<int16_t>(std::clamp(sample, -32768.0f, 32767.0f)));
+        position += step;
+        produced++;
+    }
+
+    /* Drop the samples the window has moved past */
+    size_t consumed = std::min<size_t>(position >> 32, history.size());
+    history.erase(history.begin(), history.begin() + consumed);
+    position -= static_cast<uint64_t>(consumed) << 32;
+    return produced;
+}
+
+const char* Resampler::getKernelName() const {
+#ifdef RESAMPLER_X86
+    if (kernel == resampleAVX2) {
+        return "avx2";
+    }
+    if (kernel == resampleSSE2) {
+        return "sse2";
+    }
+#endif
+    return "scalar";
+}
@@ -0,0 +1,102 @@
+/**
+ * @file resampler.h
+ * @brief Defines the polyphase FIR resampler converting APU audio to the host sample rate.
+ *
+ * The filter is a dot product over a window of input samples. A scalar
+ * kernel is always available; SSE2 and AVX2 kernels are compiled on x86 and
+ * the widest one supported by the host is selected at runtime.
+ */
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Filters one output sample.
+ * @param samples The TAPS input samples under the filter.
+ * @param phase Filter taps of the phase at or before the output position.
+ * @param nextPhase Filter taps of the following phase.
+ * @param fraction Position between the two phases (0-1).
+ * @return The output sample.
+ */
+using ResampleKernel = float (*)(const float* samples, const float* phase, const float* nextPhase, float fraction);
+
+/**
+ * @class Resampler
+ * @brief Converts a block of samples from one rate to another with a windowed-sinc polyphase filter.
+ *
+ * Each output sample is filtered from the input samples around its
+ * fractional position, using taps interpolated between the two nearest of
+ * PHASES pre-computed filter phases. The conversion ratio can be nudged
+ * while running (dynamic rate control) without rebuilding the filter,
+ * so the output can track a consumer whose clock drifts from the
+ * emulator's. Input is taken in blocks of any size; samples whose window
+ * is incomplete are kept for the next block.
+ */
+class Resampler {
+public:
+    static constexpr int TAPS = 32;   /**< Input samples under the filter; a multiple of 8. */
+    static constexpr int PHASES = 64; /**< Filter phases per input sample. */
+
+    /**
+     * @brief Deleted default constructor.
+     */
+    Resampler() = delete;
+
+    /**
+     * @brief Constructs a resampler.
+     * @param inputRate Input sample rate in Hz.
+     * @param outputRate Nominal output sample rate in Hz.
+     */
+    Resampler(double inputRate, double outputRate);
+
+    /**
+     * @brief Scales the output rate for the following blocks.
+     * @param adjustment Factor applied to the nominal output rate, e.g. 1.002 for 0.2% more samples.
+     */
+    void setRateAdjustment(double adjustment);
+
+    /**
+     * @brief Resamples a block of input samples.
+     * @param input The input samples.
+     * @param count Number of input samples.
+     * @param output Vector the output samples are appended to.
+     * @return The number of output samples appended.
+     */
+    size_t process(const int16_t* input, size_t count, std::vector<int16_t>& output);
+
+    /**
+     * @brief Gets the name of the selected filter kernel ("scalar", "sse2" or "avx2").
+     * @return The kernel's name.
+     */
+    const char* getKernelName() const;
+
+private:
+    /** @brief Filter taps, (PHASES + 1) rows of TAPS; the last row is the first shifted by one sample. */
+    std::vector<float> taps;
+
+    /** @brief Input samples not yet passed by the filter window, starting at the window of the next output. */
+    std::vector<float> history;
+
+    double inputRate;     /**< Input sample rate in Hz. */
+    double outputRate;    /**< Nominal output sample rate in Hz. */
+    uint64_t step;        /**< Input samples per output sample, 32.32 fixed point. */
+    uint64_t position = 0; /**< Fractional position of the next output within history[0], 32.32 fixed point. */
+    ResampleKernel kernel; /**< Selected filter kernel. */
+};
+
+/**
+ * @brief Portable filter kernel.
+ */
+float resampleScalar(const float* samples, const float* phase, const float* nextPhase, float fraction);
+
+/**
+ * @brief Selects the fastest filter kernel supported by the host CPU.
+ * @return The kernel to use.
+ */
+ResampleKernel selectResampleKernel();
+
+#endif // RESAMPLER_H
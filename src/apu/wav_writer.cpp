@@ -0,0 +1,65 @@
+#include "wav_writer.h"
+#include <stdexcept>
+
+constexpr uint32_t HEADER_SIZE = 44;
+
+/* Multi-byte header fields are little-endian regardless of the host */
+static void putLE(std::ofstream& file, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        file.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+WavWriter::WavWriter(const std::string& filepath, uint32_t sampleRate)
+    : file(filepath, std::ios::binary | std::ios::trunc)
+{
+    if (!file) {
+        throw std::runtime_error("Failed to create WAV file: " + filepath);
+    }
+
+    file.write("RIFF", 4);
+    putLE(file, 0, 4);              // RIFF size, completed on close
+    file.write("WAVEfmt ", 8);
+    putLE(file, 16, 4);             // fmt chunk size
+    putLE(file, 1, 2);              // PCM
+    putLE(file, 1, 2);              // Mono
+    putLE(file, sampleRate, 4);
+    putLE(file, sampleRate * 2, 4); // Byte rate
+    putLE(file, 2, 2);              // Block align
+    putLE(file, 16, 2);             // Bits per sample
+    file.write("data", 4);
+    putLE(file, 0, 4);              // Data size, completed on close
+}
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+void WavWriter::write(const int16_t* samples, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        putLE(file, static_cast<uint16_t>(samples[i]), 2);
+    }
+    dataBytes += static_cast<uint32_t>(count * 2);
+}
+
+size_t WavWriter::drain(AudioRingBuffer& ring) {
+    int16_t block[1024];
+    size_t total = 0;
+    while (size_t count = ring.pop(block, 1024)) {
+        write(block, count);
+        total += count;
+    }
+    return total;
+}
+
+void WavWriter::close() {
+    if (!file.is_open()) {
+        return;
+    }
+
+    file.seekp(4);
+    putLE(file, HEADER_SIZE - 8 + dataBytes, 4);
+    file.seekp(40);
+    putLE(file, dataBytes, 4);
+    file.close();
+}
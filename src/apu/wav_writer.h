@@ -0,0 +1,66 @@
+/**
+ * @file wav_writer.h
+ * @brief Defines the WAV file writer used to dump the emulator's audio in headless runs.
+ */
+
+#ifndef WAV_WRITER_H
+#define WAV_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "audio_ring_buffer.h"
+
+/**
+ * @class WavWriter
+ * @brief Writes mono 16-bit PCM samples to a RIFF WAVE file.
+ *
+ * The header is written with zero sizes when the file is opened and
+ * completed when it is closed, so samples can be streamed in as they are
+ * produced.
+ */
+class WavWriter {
+public:
+    /**
+     * @brief Deleted default constructor.
+     */
+    WavWriter() = delete;
+
+    /**
+     * @brief Creates the file and writes a provisional header.
+     * @param filepath Path of the WAV file to create.
+     * @param sampleRate Sample rate in Hz.
+     */
+    WavWriter(const std::string& filepath, uint32_t sampleRate);
+
+    /**
+     * @brief Destructor; completes the header if close() was not called.
+     */
+    ~WavWriter();
+
+    /**
+     * @brief Appends samples to the file.
+     * @param samples The samples.
+     * @param count Number of samples.
+     */
+    void write(const int16_t* samples, size_t count);
+
+    /**
+     * @brief Appends every sample waiting in a ring buffer, acting as its consumer.
+     * @param ring The ring buffer to drain.
+     * @return The number of samples written.
+     */
+    size_t drain(AudioRingBuffer& ring);
+
+    /**
+     * @brief Completes the header with the final sizes and closes the file.
+     */
+    void close();
+
+private:
+    std::ofstream file;
+    uint32_t dataBytes = 0; /**< Size of the sample data written so far. */
+};
+
+#endif // WAV_WRITER_H
@@ -8,8 +8,12 @@
 #include <thread>
 #include <chrono>
 #include "ppu.h"
+#include "apu.h"
 
 int main() {
+    // Keep the last instructions executed for post-mortem dumps
+    auto trace = std::make_shared<TraceRingBuffer>(64);
+
     try {
         // Load the cartridge
         //auto cartridge = std::make_shared<Cartridge>("../roms/Super Mario Bros.nes");
@@ -17,18 +21,25 @@ int main() {
 
         // Create the CPU and link it to the bus
         auto ppu = std::make_shared<PPU>();
+        auto apu = std::make_shared<APU>();
 
         // Create the BusInterface and attach the cartridge
-        auto bus = std::make_shared<BusInterface>(cartridge, ppu);
+        auto bus = std::make_shared<BusInterface>(cartridge, ppu, apu);
 
         // Create the CPU and link it to the bus
         auto cpu = std::make_shared<CPU6502>(bus);
+        cpu->setTraceSink(trace);
 
         // Set IRQ callback
         ppu->setIRQCallback([cpu]() {
             cpu->triggerIRQ();
         });
 
+        // Frame counter and DMC IRQs share the CPU's IRQ line
+        apu->setIRQCallback([cpu]() {
+            cpu->triggerIRQ();
+        });
+
         // Register the NMI callback from the PPU to the CPU
         ppu->setNMICallback([cpu] {
             cpu->triggerNMI();
@@ -40,7 +51,8 @@ int main() {
         // Reset the CPU and PPU
         cpu->reset();
         ppu->reset();
-        std::cout << "CPU and PPU reset complete.\n";
+        apu->reset();
+        std::cout << "CPU, PPU and APU reset complete.\n";
 
         // Print initial state
         std::cout << "Initial instruction view:\n";
@@ -57,16 +69,13 @@ int main() {
             
             // Simulate instruction execution
             // std::cout << "\nExecuting instruction...\n";
-            cpu->step(); // Simulate one CPU instruction execution
-
-            // Execute 3 PPU steps for each CPU step
-            for (int i = 0; i < 3; ++i) {
-                ppu->step();
-            }
+            cpu->runCycles(1); // Execute one whole instruction and catch the PPU up with it
         }
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        std::cerr << "Last executed instructions:\n";
+        trace->dump(std::cerr);
         return 1;
     }
 
@@ -0,0 +1,107 @@
+#include "Headless/headless_runner.h"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+
+static void printUsage(const char* program) {
+    std::fprintf(stderr,
+        "Usage: %s <rom> [options]\n"
+        "  --frames N           Run at most N frames (default 600)\n"
+        "  --until-pc ADDR      Stop once the PC is ADDR at the end of a frame\n"
+        "  --until-mem ADDR=VAL Stop once the byte at ADDR equals VAL\n"
+        "  --wav FILE           Write the audio to a WAV file\n"
+        "  --save               Load and store battery RAM in the ROM's .sav file\n"
+        "  --load-state FILE    Start from a snapshot of the same ROM instead of power-on\n"
+        "  --save-state FILE    Write a snapshot of the machine at the end of the run\n"
+        "  --rewind N           Step back N frames at the end of the run (before --save-state)\n"
+        "Numbers may be decimal or 0x-prefixed hexadecimal.\n"
+        "Exit status: 0 on success, 1 on error, 2 if a stop condition was given but not met.\n",
+        program);
+}
+
+static unsigned long parseNumber(const std::string& text) {
+    size_t end = 0;
+    unsigned long value = std::stoul(text, &end, 0);
+    if (end != text.size()) {
+        throw std::invalid_argument("Invalid number: " + text);
+    }
+    return value;
+}
+
+int main(int argc, char** argv) {
+    HeadlessOptions options;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (arg == "--frames" && hasValue) {
+                options.frameLimit = parseNumber(argv[++i]);
+            } else if (arg == "--until-pc" && hasValue) {
+                options.stopAtPC = true;
+                options.stopPC = static_cast<uint16_t>(parseNumber(argv[++i]));
+            } else if (arg == "--until-mem" && hasValue) {
+                std::string condition = argv[++i];
+                size_t separator = condition.find('=');
+                if (separator == std::string::npos) {
+                    throw std::invalid_argument("Expected ADDR=VAL: " + condition);
+                }
+                options.stopOnMemory = true;
+                options.stopAddress = static_cast<uint16_t>(parseNumber(condition.substr(0, separator)));
+                options.stopValue = static_cast<uint8_t>(parseNumber(condition.substr(separator + 1)));
+            } else if (arg == "--wav" && hasValue) {
+                options.wavPath = argv[++i];
+            } else if (arg == "--load-state" && hasValue) {
+                options.loadStatePath = argv[++i];
+            } else if (arg == "--save-state" && hasValue) {
+                options.saveStatePath = argv[++i];
+            } else if (arg == "--rewind" && hasValue) {
+                options.rewindFrames = parseNumber(argv[++i]);
+            } else if (arg == "--save") {
+                options.persistSaveRAM = true;
+            } else if (arg[0] != '-' && options.romPath.empty()) {
+                options.romPath = arg;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.romPath.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        HeadlessRunner runner(options);
+        HeadlessResult result = runner.run();
+
+        // The only output: one report line, and one more for --rewind
+        std::printf("%s: %llu frames, %llu instructions, %llu cycles in %.3f s "
+                    "(%.1f frames/s, %.2f M instructions/s), frame hash %016llx%s\n",
+                    options.romPath.c_str(),
+                    static_cast<unsigned long long>(result.frames),
+                    static_cast<unsigned long long>(result.instructions),
+                    static_cast<unsigned long long>(result.cycles),
+                    result.seconds, result.framesPerSecond(), result.instructionsPerSecond() / 1e6,
+                    static_cast<unsigned long long>(result.frameHash),
+                    result.conditionMet ? ", stop condition met" : "");
+        if (options.rewindFrames > 0) {
+            std::printf("Rewound %llu frames (history of %.1f KB)\n",
+                        static_cast<unsigned long long>(result.rewound), result.rewindBytes / 1024.0);
+        }
+
+        bool conditionGiven = options.stopAtPC || options.stopOnMemory;
+        return (conditionGiven && !result.conditionMet) ? 2 : 0;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+}
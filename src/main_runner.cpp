@@ -0,0 +1,122 @@
+#include "Headless/batch_runner.h"
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void printUsage(const char* program) {
+    std::fprintf(stderr,
+        "Usage: %s [options] <rom | @joblist>...\n"
+        "  --threads N          Worker threads (default: one per hardware thread)\n"
+        "  --frames N           Default frame limit per job (default 600)\n"
+        "  --until-pc ADDR      Default stop condition: PC is ADDR at the end of a frame\n"
+        "  --until-mem ADDR=VAL Default stop condition: the byte at ADDR equals VAL\n"
+        "  --format json|csv    Report format (default json)\n"
+        "  --output FILE        Write the report to FILE instead of stdout\n"
+        "A job list has one job per line: <rom> [frames=N] [until-pc=ADDR] [until-mem=ADDR=VAL] [hash=HEX];\n"
+        "text after '#' is ignored. Exit status: 0 if every job passed, 1 on usage errors, 2 otherwise.\n",
+        program);
+}
+
+/* Jobs from a list file, one per non-empty line */
+static void readJobList(const std::string& path, const BatchJob& defaults, std::vector<BatchJob>& jobs) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open job list: " + path);
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            jobs.push_back(parseJob(line, defaults));
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    BatchJob defaults;
+    size_t threads = 0;
+    std::string format = "json";
+    std::string outputPath;
+    std::vector<std::string> sources;
+    std::vector<BatchJob> jobs;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (arg == "--threads" && hasValue) {
+                threads = parseJobNumber(argv[++i]);
+            } else if (arg == "--frames" && hasValue) {
+                defaults.options.frameLimit = parseJobNumber(argv[++i]);
+            } else if (arg == "--until-pc" && hasValue) {
+                defaults = parseJob(". until-pc=" + std::string(argv[++i]), defaults);
+            } else if (arg == "--until-mem" && hasValue) {
+                defaults = parseJob(". until-mem=" + std::string(argv[++i]), defaults);
+            } else if (arg == "--format" && hasValue) {
+                format = argv[++i];
+            } else if (arg == "--output" && hasValue) {
+                outputPath = argv[++i];
+            } else if (arg[0] != '-') {
+                sources.push_back(arg);
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+
+        // Defaults apply to every job, whichever option order they were given in
+        for (const std::string& source : sources) {
+            if (source[0] == '@') {
+                readJobList(source.substr(1), defaults, jobs);
+            } else {
+                BatchJob job = defaults;
+                job.options.romPath = source;
+                jobs.push_back(job);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (jobs.empty() || (format != "json" && format != "csv")) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BatchResult> results = runBatch(jobs, pool);
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath);
+        if (!file) {
+            std::fprintf(stderr, "Error: Failed to create report: %s\n", outputPath.c_str());
+            return 1;
+        }
+    }
+    std::ostream& out = outputPath.empty() ? std::cout : file;
+
+    if (format == "csv") {
+        writeCSVReport(out, results);
+    } else {
+        writeJSONReport(out, results, wallSeconds, pool);
+    }
+
+    for (const BatchResult& result : results) {
+        if (result.status != JobStatus::Pass) {
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -1,94 +1,148 @@
 #include "raylib.h"
-#include <vector>
+#include "Frontend/run_ahead.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
 #include <string>
-#include <iomanip>
-#include <sstream>
 
 // NES screen dimensions
-constexpr int NES_WIDTH = 256;
-constexpr int NES_HEIGHT = 240;
-
-// Instruction memory
-std::vector<std::string> instructionMemory = {
-    "NOP", "LDA #$44", "STA $0200", "LDX #$02", "JMP $C000",
-    "AND #$0F", "ASL", "BNE $FD", "BRK", "RTS"
-};
-
-// Function to get CPU register values as strings
-std::vector<std::string> GetCPURegisters() {
-    return {
-        "A: 0x34",
-        "X: 0x02",
-        "Y: 0xFF",
-        "PC: 0x8003",
-        "SP: 0xFD"
-    };
+constexpr int NES_WIDTH = PPU::SCREEN_WIDTH;
+constexpr int NES_HEIGHT = PPU::SCREEN_HEIGHT;
+
+// Audio device callback source (raylib callbacks take no user pointer)
+static AudioRingBuffer* audioOutput = nullptr;
+
+// Pulls the emulator's samples on the audio thread; silence when it runs dry
+static void fillAudio(void* buffer, unsigned int frames) {
+    int16_t* samples = static_cast<int16_t*>(buffer);
+    size_t count = audioOutput->pop(samples, frames);
+    std::fill(samples + count, samples + frames, 0);
+}
+
+// Controller 1 from the keyboard: X/Z = A/B, right shift = Select, enter = Start, arrows
+static uint8_t ReadButtons() {
+    static const int KEYS[8] = { KEY_X, KEY_Z, KEY_RIGHT_SHIFT, KEY_ENTER, KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT };
+    uint8_t buttons = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (IsKeyDown(KEYS[i])) {
+            buttons |= 1 << i;
+        }
+    }
+    return buttons;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    std::string romPath;
+    unsigned runAheadFrames = 0;
+    bool secondInstance = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--run-ahead" && i + 1 < argc) {
+            runAheadFrames = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--second-instance") {
+            secondInstance = true;
+        } else if (arg[0] != '-' && romPath.empty()) {
+            romPath = arg;
+        } else {
+            romPath.clear();
+            break;
+        }
+    }
+    if (romPath.empty()) {
+        std::fprintf(stderr,
+            "Usage: %s <rom> [--run-ahead N] [--second-instance]\n"
+            "  --run-ahead N        Present each frame as it will be N frames later (hides the game's input lag)\n"
+            "  --second-instance    Emulate the frames ahead on a second machine on another thread\n"
+            "Keys: arrows, X (A), Z (B), right shift (Select), enter (Start); +/- change the run-ahead frames.\n",
+            argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<RunAhead> emulator;
+    try {
+        emulator = std::make_unique<RunAhead>(romPath, runAheadFrames, secondInstance);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
     // Double NES resolution
     const int scaledNESWidth = NES_WIDTH * 2;
     const int scaledNESHeight = NES_HEIGHT * 2;
 
-    // Right column for instructions and registers
-    const int instructionColumnWidth = 200; // Wider column to accommodate instructions and registers
-    const int windowWidth = scaledNESWidth + instructionColumnWidth;
+    // Right column for run-ahead settings and frame timing
+    const int infoColumnWidth = 240;
+    const int windowWidth = scaledNESWidth + infoColumnWidth;
     const int windowHeight = scaledNESHeight;
 
     InitWindow(windowWidth, windowHeight, "NES Emulator");
     SetTargetFPS(60);
 
-    // Current instruction index
-    int instructionPointer = 0;
-    const int instructionsVisible = 2; // Number of instructions before and after
+    // Screen texture, updated from the presented RGBA frame
+    Image blank = GenImageColor(NES_WIDTH, NES_HEIGHT, BLACK);
+    ImageFormat(&blank, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    Texture2D screen = LoadTextureFromImage(blank);
+    UnloadImage(blank);
+
+    // Mono 16-bit stream at the APU's output rate
+    InitAudioDevice();
+    audioOutput = &emulator->getAudioOutput();
+    AudioStream stream = LoadAudioStream(emulator->getSampleRate(), 16, 1);
+    SetAudioStreamCallback(stream, fillAudio);
+    PlayAudioStream(stream);
 
     while (!WindowShouldClose()) {
-        // Check for spacebar press to advance the instruction
-        if (IsKeyPressed(KEY_SPACE)) {
-            instructionPointer++;
-            if (instructionPointer >= instructionMemory.size()) {
-                instructionPointer = 0; // Loop back to the start
-            }
+        if (IsKeyPressed(KEY_EQUAL) || IsKeyPressed(KEY_KP_ADD)) {
+            emulator->setFrames(emulator->getFrames() + 1);
+        }
+        if ((IsKeyPressed(KEY_MINUS) || IsKeyPressed(KEY_KP_SUBTRACT)) && emulator->getFrames() > 0) {
+            emulator->setFrames(emulator->getFrames() - 1);
+        }
+
+        try {
+            emulator->runFrame(ReadButtons());
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "Error: %s\n", e.what());
+            break;
         }
+        UpdateTexture(screen, emulator->getFrameRGBA());
 
         // Begin drawing
         BeginDrawing();
         ClearBackground(RAYWHITE);
 
         // Draw NES screen on the left
-        DrawRectangle(0, 0, scaledNESWidth, scaledNESHeight, DARKGRAY);
-        DrawRectangleLinesEx({0, 0, (float)scaledNESWidth, (float)scaledNESHeight}, 2, BLACK);
+        DrawTextureEx(screen, {0, 0}, 0.0f, 2.0f, WHITE);
 
-        // Draw instruction and register column on the right
+        // Draw run-ahead and timing column on the right
         int columnX = scaledNESWidth;
-        DrawRectangle(columnX, 0, instructionColumnWidth, windowHeight, LIGHTGRAY);
-        DrawRectangleLinesEx({(float)columnX, 0, (float)instructionColumnWidth, (float)windowHeight}, 2, BLACK);
-
-        // Draw instructions
-        int instructionsStartY = 20; // Starting Y position for instructions
-        int lineHeight = 30; // Line height for instructions
+        DrawRectangle(columnX, 0, infoColumnWidth, windowHeight, LIGHTGRAY);
+        DrawRectangleLinesEx({(float)columnX, 0, (float)infoColumnWidth, (float)windowHeight}, 2, BLACK);
 
-        for (int i = -instructionsVisible; i <= instructionsVisible; ++i) {
-            int idx = instructionPointer + i;
-            if (idx < 0 || idx >= instructionMemory.size()) continue;
+        const FrameTiming& timing = emulator->getTiming();
+        int lineHeight = 30;
+        int y = 20;
+        DrawText(TextFormat("Run-ahead: %u", emulator->getFrames()), columnX + 10, y, 20, BLACK);
+        DrawText(emulator->usesSecondInstance() ? "Second instance" : "Single instance", columnX + 10, y += lineHeight, 20, DARKGRAY);
 
-            // Highlight current instruction
-            Color textColor = (i == 0) ? WHITE : DARKGRAY;
-            DrawText(instructionMemory[idx].c_str(), columnX + 10, instructionsStartY + (i + instructionsVisible) * lineHeight, 20, textColor);
-        }
+        DrawText("Frame timing (ms):", columnX + 10, y += lineHeight * 2, 20, BLACK);
+        DrawText(TextFormat("Total     %6.2f", timing.total), columnX + 10, y += lineHeight, 20, DARKGRAY);
+        DrawText(TextFormat("Real      %6.2f", timing.real), columnX + 10, y += lineHeight, 20, DARKGRAY);
+        DrawText(TextFormat("Ahead     %6.2f", timing.ahead), columnX + 10, y += lineHeight, 20, DARKGRAY);
+        DrawText(TextFormat("Snapshot  %6.2f", timing.snapshot), columnX + 10, y += lineHeight, 20, DARKGRAY);
 
-        // Draw CPU registers below instructions
-        int registersStartY = instructionsStartY + (instructionsVisible * 2 + 1) * lineHeight + 40; // Position below instructions
-        DrawText("CPU Registers:", columnX + 10, registersStartY, 20, BLACK);
-
-        std::vector<std::string> registers = GetCPURegisters();
-        for (size_t i = 0; i < registers.size(); ++i) {
-            DrawText(registers[i].c_str(), columnX + 10, registersStartY + 30 + (i * lineHeight), 20, BLACK);
-        }
+        // Below 1x the host cannot keep up: reduce the run-ahead frames
+        double headroom = timing.headroom();
+        DrawText(TextFormat("Headroom  %5.1fx", headroom), columnX + 10, y += lineHeight * 2, 20, headroom >= 1.0 ? DARKGREEN : RED);
 
         EndDrawing();
     }
 
+    UnloadAudioStream(stream);
+    CloseAudioDevice();
+    UnloadTexture(screen);
     CloseWindow();
     return 0;
 }
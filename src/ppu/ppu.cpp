@@ -1,4 +1,8 @@
 #include "ppu.h"
+#include "cartridge.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <unwind.h>
 #include <dlfcn.h>
@@ -7,14 +11,168 @@
 
 constexpr int TOTAL_CYCLES_PER_SCANLINE = 341;
 constexpr int VISIBLE_SCANLINES = 240;
-constexpr int TOTAL_SCANLINES = 261;
+constexpr int TOTAL_SCANLINES = 262;
 constexpr int VBLANK_START_SCANLINE = 241;
-constexpr int VBLANK_END_SCANLINE = 260;
+constexpr int VBLANK_END_SCANLINE = 261; // First line after VBlank: the flags clear as it starts
+constexpr int PRE_RENDER_SCANLINE = 261;
+
+/* Registers and timing of the PPU snapshot section, in a fixed layout */
+struct PPUState {
+    uint64_t frameCount;
+    uint64_t timestamp;
+    int32_t lineOriginX;
+    int32_t renderedX;
+    uint32_t VRAMSize;
+    uint16_t vramAddress;
+    uint16_t tempAddress;
+    uint16_t lineAddress;
+    uint16_t currentCycle;
+    uint16_t currentScanline;
+    uint8_t PPUCTRL;
+    uint8_t PPUMASK;
+    uint8_t PPUSTATUS;
+    uint8_t OAMADDR;
+    uint8_t OAMDATA;
+    uint8_t PPUDATA;
+    uint8_t fineX;
+    uint8_t writeToggle;
+    uint8_t lineFetched;
+    uint8_t reserved[9];
+};
+
+static constexpr uint32_t PPU_SECTION = sectionID("PPU ");
+static constexpr uint32_t PPU_SECTION_VERSION = 1;
+
+/* Map a palette address to palette RAM; sprite backdrop entries mirror the background ones */
+static inline uint8_t paletteIndex(uint16_t address) {
+    uint8_t index = address & 0x1F;
+    return ((index & 0x13) == 0x10) ? (index & 0x0F) : index;
+}
 
 PPU::PPU() 
-    : PPUCTRL(0), PPUMASK(0), PPUSTATUS(0), OAMADDR(0), PPUSCROLL(0), PPUADDR(0), PPUDATA(0), triggerNMI(nullptr) {
+    : PPUCTRL(0), PPUMASK(0), PPUSTATUS(0), OAMADDR(0), PPUDATA(0), triggerNMI(nullptr) {
     VRAM.resize(2048, 0); // Initialize 2 KB of VRAM
     OAM.resize(256, 0);   // Initialize 256 bytes of OAM
+    frameBuffer.resize(SCREEN_WIDTH * SCREEN_HEIGHT, 0);
+    compositeKernel = selectCompositeKernel();
+
+    // Vertical mirroring until a cartridge is connected
+    nametables = { &VRAM[0x000], &VRAM[0x400], &VRAM[0x000], &VRAM[0x400] };
+}
+
+void PPU::connectCartridge(std::shared_ptr<Cartridge> cartridge) {
+    this->cartridge = cartridge;
+    countA12Rises = cartridge->countsA12Rises();
+
+    // Four-screen boards add 2 KB of VRAM for the other two nametables
+    VRAM.assign(cartridge->isFourScreenVRAM() ? 4096 : 2048, 0);
+    updateMirroring();
+}
+
+void PPU::updateMirroring() {
+    switch (cartridge->getMirroring()) {
+        case Mirroring::Horizontal:
+            nametables = { &VRAM[0x000], &VRAM[0x000], &VRAM[0x400], &VRAM[0x400] };
+            break;
+        case Mirroring::Vertical:
+            nametables = { &VRAM[0x000], &VRAM[0x400], &VRAM[0x000], &VRAM[0x400] };
+            break;
+        case Mirroring::SingleScreenLower:
+            nametables = { &VRAM[0x000], &VRAM[0x000], &VRAM[0x000], &VRAM[0x000] };
+            break;
+        case Mirroring::SingleScreenUpper:
+            nametables = { &VRAM[0x400], &VRAM[0x400], &VRAM[0x400], &VRAM[0x400] };
+            break;
+        case Mirroring::FourScreen:
+            nametables = { &VRAM[0x000], &VRAM[0x400], &VRAM[0x800], &VRAM[0xC00] };
+            break;
+    }
+}
+
+void PPU::saveState(SnapshotWriter& writer) const {
+    PPUState state{};
+    state.frameCount = frameCount;
+    state.timestamp = timestamp;
+    state.lineOriginX = lineOriginX;
+    state.renderedX = renderedX;
+    state.VRAMSize = static_cast<uint32_t>(VRAM.size());
+    state.vramAddress = vramAddress;
+    state.tempAddress = tempAddress;
+    state.lineAddress = lineAddress;
+    state.currentCycle = currentCycle;
+    state.currentScanline = currentScanline;
+    state.PPUCTRL = PPUCTRL;
+    state.PPUMASK = PPUMASK;
+    state.PPUSTATUS = PPUSTATUS;
+    state.OAMADDR = OAMADDR;
+    state.OAMDATA = OAMDATA;
+    state.PPUDATA = PPUDATA;
+    state.fineX = fineX;
+    state.writeToggle = writeToggle;
+    state.lineFetched = lineFetched;
+
+    writer.beginSection(PPU_SECTION, PPU_SECTION_VERSION);
+    writer.write(state);
+    writer.writeBytes(VRAM.data(), VRAM.size());
+    writer.writeBytes(OAM.data(), OAM.size());
+    writer.write(paletteRAM);
+    writer.write(lineBackground);
+    writer.write(lineSprites);
+    writer.endSection();
+}
+
+void PPU::loadState(SnapshotReader& reader) {
+    reader.beginSection(PPU_SECTION, PPU_SECTION_VERSION);
+
+    PPUState state;
+    reader.read(state);
+    if (state.VRAMSize != VRAM.size()) {
+        throw std::runtime_error("Snapshot PPU has a different amount of VRAM.");
+    }
+    reader.readBytes(VRAM.data(), VRAM.size());
+    reader.readBytes(OAM.data(), OAM.size());
+    reader.read(paletteRAM);
+    reader.read(lineBackground);
+    reader.read(lineSprites);
+    reader.endSection();
+
+    frameCount = state.frameCount;
+    timestamp = state.timestamp;
+    lineOriginX = state.lineOriginX;
+    renderedX = state.renderedX;
+    vramAddress = state.vramAddress;
+    tempAddress = state.tempAddress;
+    lineAddress = state.lineAddress;
+    currentCycle = state.currentCycle;
+    currentScanline = state.currentScanline;
+    PPUCTRL = state.PPUCTRL;
+    PPUMASK = state.PPUMASK;
+    PPUSTATUS = state.PPUSTATUS;
+    OAMADDR = state.OAMADDR;
+    OAMDATA = state.OAMDATA;
+    PPUDATA = state.PPUDATA;
+    fineX = state.fineX;
+    writeToggle = state.writeToggle != 0;
+    lineFetched = state.lineFetched != 0;
+    updateMirroring();
+}
+
+const uint8_t* PPU::getFrameBuffer() const {
+    return frameBuffer.data();
+}
+
+void PPU::setRGBAOutput(bool enabled) {
+    if (!enabled) {
+        frameBufferRGBA.clear();
+        frameBufferRGBA.shrink_to_fit();
+    } else if (frameBufferRGBA.empty()) {
+        frameBufferRGBA.resize(SCREEN_WIDTH * SCREEN_HEIGHT, 0);
+        convertToRGBA(frameBuffer.data(), frameBufferRGBA.data(), frameBuffer.size());
+    }
+}
+
+const uint32_t* PPU::getFrameBufferRGBA() const {
+    return frameBufferRGBA.empty() ? nullptr : frameBufferRGBA.data();
 }
 
 void PPU::setNMICallback(const std::function<void()>& callback) {
@@ -30,9 +188,11 @@ void PPU::reset() {
     PPUMASK = 0;
     PPUSTATUS = 0;
     OAMADDR = 0;
-    PPUSCROLL = 0;
-    PPUADDR = 0;
     PPUDATA = 0;
+    vramAddress = 0;
+    tempAddress = 0;
+    fineX = 0;
+    writeToggle = false;
 }
 
 /*
@@ -52,7 +212,7 @@ End of VBlank: The flag is cleared at the end of VBlank, and rendering for the n
 | Post-Render Line     | 256 pixels             | 1 scanline                | 240                            |
 | VBlank Period        | 256 pixels             | 20 scanlines              | 241–260                        |
 | Pre-Render Line      | 256 pixels             | 1 scanline                | 261                            |
-| Total Frame          | 256 pixels             | 261 scanlines             | 0–261                          |
+| Total Frame          | 256 pixels             | 262 scanlines             | 0–261                          |
 +----------------------+-------------------------+---------------------------+---------------------------------+
 
 Notes:
@@ -62,11 +222,40 @@ Notes:
 - Pre-Render Line: The last scanline (261) is used to prepare the PPU for the next frame's rendering cycle.
 */
 void PPU::step() {
-    // Increment the cycle counter
-    currentCycle++;
+    run(1);
+}
+
+bool PPU::run(uint32_t cycles) {
+    bool frameCompleted = false;
+    timestamp += cycles;
+
+    while (cycles > 0) {
+        // Stop at the mapper's A12 rise if it is still ahead on this scanline
+        uint16_t a12Cycle = a12RiseCycle(currentScanline);
+        uint16_t stopCycle = (a12Cycle > currentCycle) ? a12Cycle : TOTAL_CYCLES_PER_SCANLINE;
+
+        // Stay within the current scanline when the batch ends before the stop
+        uint32_t remaining = stopCycle - currentCycle;
+        if (cycles < remaining) {
+            currentCycle += cycles;
+            break;
+        }
+        cycles -= remaining;
+
+        if (stopCycle == a12Cycle) {
+            currentCycle = a12Cycle;
+            if (cartridge->notifyA12Rise() && triggerIRQ) {
+                triggerIRQ(); // Mapper scanline counter reached zero
+            }
+            continue;
+        }
 
-    // Check if we've completed a scanline
-    if (currentCycle >= TOTAL_CYCLES_PER_SCANLINE) {
+        // Complete the scanline
+        if (currentScanline < VISIBLE_SCANLINES) {
+            finishScanline();
+        } else if (currentScanline == PRE_RENDER_SCANLINE && isRenderingEnabled()) {
+            vramAddress = tempAddress; // Reload the scroll position for the new frame
+        }
         currentCycle = 0;
         currentScanline++;
 
@@ -74,30 +263,325 @@ void PPU::step() {
         if (currentScanline >= TOTAL_SCANLINES) {
             currentScanline = 0;
         }
+
+        if (currentScanline < VISIBLE_SCANLINES) {
+            beginScanline();
+        }
+
+        // Handle VBlank period
+        if (currentScanline == VBLANK_START_SCANLINE) {
+            // Enter VBlank
+            PPUSTATUS |= (1<<7); // Set VBlank flag
+            frameCount++;
+            frameCompleted = true;
+            if ((PPUCTRL & 0x80) && triggerNMI) {
+                triggerNMI(); // Trigger NMI via callback when enabled in PPUCTRL
+            }
+        }
+
+        if (currentScanline == VBLANK_END_SCANLINE) {
+            // Exit VBlank
+            PPUSTATUS &= ~((1<<7) | (1<<6) | (1<<5)); // Clear VBlank, sprite 0 hit and sprite overflow flags
+        }
+    }
+
+    return frameCompleted;
+}
+
+bool PPU::catchUp(uint64_t targetCycle) {
+    bool frameCompleted = false;
+
+    // Run in chunks that fit run()'s 32-bit cycle count
+    while (timestamp < targetCycle) {
+        uint64_t pending = targetCycle - timestamp;
+        frameCompleted |= run(static_cast<uint32_t>(std::min<uint64_t>(pending, UINT32_MAX)));
     }
 
-    // Handle VBlank period
-    if (currentScanline == VBLANK_START_SCANLINE && currentCycle == 0) {
-        // Enter VBlank
-        PPUSTATUS |= (1<<7); // Set VBlank flag
-        if (triggerNMI) {
-            triggerNMI(); // Trigger NMI via callback
+    return frameCompleted;
+}
+
+uint64_t PPU::getTimestamp() const {
+    return timestamp;
+}
+
+uint64_t PPU::nextEventCycle() const {
+    // Number of scanline boundaries until the counter reaches a given scanline
+    auto boundariesUntil = [this](int scanline) {
+        return (scanline - currentScanline - 1 + TOTAL_SCANLINES) % TOTAL_SCANLINES + 1;
+    };
+
+    int boundaries = std::min(boundariesUntil(VBLANK_START_SCANLINE), boundariesUntil(VBLANK_END_SCANLINE));
+    uint64_t lineStart = timestamp - currentCycle;
+    uint64_t event = lineStart + static_cast<uint64_t>(boundaries) * TOTAL_CYCLES_PER_SCANLINE;
+
+    // An earlier A12 rise, on this scanline or a following rendered one
+    if (countA12Rises && isRenderingEnabled()) {
+        int scanline = currentScanline;
+        for (uint64_t start = lineStart; start < event; start += TOTAL_CYCLES_PER_SCANLINE) {
+            uint16_t a12Cycle = a12RiseCycle(scanline);
+            if (a12Cycle && start + a12Cycle > timestamp) {
+                return std::min(event, start + a12Cycle);
+            }
+            scanline = (scanline + 1) % TOTAL_SCANLINES;
         }
     }
+    return event;
+}
 
-    if (currentScanline == VBLANK_END_SCANLINE && currentCycle == 0) {
-        // Exit VBlank
-        PPUSTATUS &= ~(1<<7); // Clear VBlank flag
+uint64_t PPU::nextStatusChangeCycle() const {
+    uint64_t event = nextEventCycle();
+    if (!isRenderingEnabled() || currentScanline >= VISIBLE_SCANLINES) {
+        return event; // Sprite flags are only set on rendered visible scanlines
     }
 
-    // Rendering logic
-    if (currentScanline < VISIBLE_SCANLINES) {
-        // Calculate pixel output based on scrollX and scrollY
-        int pixelX = (currentCycle + scrollX) % 256; // Adjust for horizontal scroll
-        int pixelY = (currentScanline + scrollY) % 240; // Adjust for vertical scroll
+    // First scanline from here on that may set a sprite flag still clear
+    int height = (PPUCTRL & 0x20) ? 16 : 8;
+    int first = VISIBLE_SCANLINES;
+    if (!(PPUSTATUS & (1<<6))) {
+        int top = OAM[0] + 1; // OAM holds the sprite's top line minus one
+        if (top + height > currentScanline) {
+            first = std::max<int>(top, currentScanline);
+        }
+    }
+    if (!(PPUSTATUS & (1<<5))) {
+        std::array<uint8_t, VISIBLE_SCANLINES> counts{};
+        for (int i = 0; i < 64; ++i) {
+            int top = OAM[i * 4] + 1;
+            for (int line = std::max<int>(top, currentScanline); line < std::min(top + height, first); ++line) {
+                if (++counts[line] > 8) {
+                    first = line; // Sprite overflow
+                    break;
+                }
+            }
+        }
+    }
 
-        // Fetch and render the pixel from VRAM based on pixelX and pixelY
-        // Example: Fetch tile data and attributes here
+    if (first < VISIBLE_SCANLINES) {
+        uint64_t lineStart = timestamp - currentCycle;
+        uint64_t change = (first == currentScanline)
+            ? timestamp
+            : lineStart + static_cast<uint64_t>(first - currentScanline) * TOTAL_CYCLES_PER_SCANLINE;
+        event = std::min(event, change);
+    }
+    return event;
+}
+
+uint16_t PPU::a12RiseCycle(int scanline) const {
+    if (!countA12Rises || !isRenderingEnabled()) {
+        return 0;
+    }
+    if (scanline >= VISIBLE_SCANLINES && scanline != PRE_RENDER_SCANLINE) {
+        return 0;
+    }
+
+    // 8x16 sprites mostly fetch from $1000 for unused sprite slots (tile $FF)
+    bool spritesHigh = (PPUCTRL & 0x20) || (PPUCTRL & 0x08);
+    bool backgroundHigh = PPUCTRL & 0x10;
+    if (spritesHigh && !backgroundHigh) {
+        return 260;
+    }
+    if (backgroundHigh && !spritesHigh) {
+        return 324;
+    }
+    return 0;
+}
+
+uint64_t PPU::getFrameCount() const {
+    return frameCount;
+}
+
+/*
+Rendering is done a scanline at a time instead of a pixel per step(). At the
+start of a visible scanline the scroll position (v) is latched; when the PPU
+moves past the end of the line, its background tiles are fetched in bulk
+(33 nametable, attribute and pattern byte pairs), its sprites are evaluated,
+and all 256 pixels are composed into the framebuffer in one pass.
+
+Register writes in the middle of a visible scanline switch that line to an
+exact mode: the pixels displayed before the write are output first with the
+old state, then the line is refetched and continues from the write's column.
+Reads of PPUSTATUS do the same so that sprite 0 hit is seen at its pixel.
+*/
+bool PPU::isMidScanline() const {
+    return currentScanline < VISIBLE_SCANLINES && currentCycle < SCREEN_WIDTH;
+}
+
+void PPU::writeOAMDMA(const uint8_t* data) {
+    size_t first = OAM.size() - OAMADDR;
+    std::memcpy(&OAM[OAMADDR], data, first);
+    std::memcpy(&OAM[0], data + first, OAMADDR);
+}
+
+void PPU::flushScanline() {
+    if (isMidScanline()) {
+        renderSpan(currentCycle);
+        lineFetched = false;
+    }
+}
+
+void PPU::beginScanline() {
+    lineAddress = vramAddress;
+    lineOriginX = 0;
+    renderedX = 0;
+    lineFetched = false;
+}
+
+void PPU::finishScanline() {
+    renderSpan(SCREEN_WIDTH);
+
+    if (isRenderingEnabled()) {
+        incrementY();
+        vramAddress = (vramAddress & ~0x041F) | (tempAddress & 0x041F); // Reload coarse X and nametable X
+    }
+}
+
+void PPU::renderSpan(int endX) {
+    endX = std::min(endX, SCREEN_WIDTH);
+    if (renderedX >= endX) {
+        return;
+    }
+
+    if (!lineFetched) {
+        if (isRenderingEnabled() && cartridge) {
+            fetchBackground();
+            fetchSprites();
+        }
+        lineFetched = true;
+    }
+
+    // Priority mux, sprite 0 hit and palette lookup for the whole span
+    size_t lineOffset = currentScanline * SCREEN_WIDTH;
+    CompositeSpan span = {
+        lineBackground.data(), lineSprites.data(), renderedX, endX, PPUMASK, paletteRAM.data(),
+        &frameBuffer[lineOffset], frameBufferRGBA.empty() ? nullptr : &frameBufferRGBA[lineOffset]
+    };
+    if (compositeKernel(span)) {
+        PPUSTATUS |= (1<<6); // Sprite 0 hit
+    }
+
+    renderedX = endX;
+}
+
+void PPU::fetchBackground() {
+    uint8_t pixels[33 * 8];
+
+    uint16_t address = lineAddress;
+    uint16_t patternBase = (PPUCTRL & 0x10) ? 0x1000 : 0x0000;
+    uint16_t fineY = (address >> 12) & 0x07;
+    int tiles = (SCREEN_WIDTH - lineOriginX + fineX + 7) / 8;
+
+    // Fetch nametable, attribute and decoded pattern rows for every tile on the line
+    for (int i = 0; i < tiles; ++i) {
+        uint16_t coarseX = address & 0x1F;
+        uint16_t coarseY = (address >> 5) & 0x1F;
+        const uint8_t* nametable = nametables[(address >> 10) & 0x03];
+
+        uint8_t tile = nametable[(coarseY << 5) | coarseX];
+        uint8_t attribute = nametable[0x3C0 | ((coarseY >> 2) << 3) | (coarseX >> 2)];
+        uint8_t palette = ((attribute >> (((coarseY & 0x02) << 1) | (coarseX & 0x02))) & 0x03) << 2;
+
+        const uint8_t* row = cartridge->getCHRTileRow(patternBase | (tile << 4) | fineY);
+        for (int p = 0; p < 8; ++p) {
+            pixels[i * 8 + p] = palette | row[p];
+        }
+
+        // Coarse X increment, wrapping into the horizontally adjacent nametable
+        if (coarseX == 31) {
+            address = (address & ~0x001F) ^ 0x0400;
+        } else {
+            address++;
+        }
+    }
+
+    // Copy the pixels into the line, shifted by the fine X scroll
+    std::memcpy(&lineBackground[lineOriginX], &pixels[fineX], SCREEN_WIDTH - lineOriginX);
+}
+
+void PPU::fetchSprites() {
+    lineSprites.fill(0);
+
+    int height = (PPUCTRL & 0x20) ? 16 : 8;
+    int count = 0;
+
+    for (int i = 0; i < 64; ++i) {
+        const uint8_t* sprite = &OAM[i * 4];
+        int row = currentScanline - sprite[0] - 1; // OAM holds the sprite's top line minus one
+        if (row < 0 || row >= height) {
+            continue;
+        }
+        if (++count > 8) {
+            PPUSTATUS |= (1<<5); // Sprite overflow
+            break;
+        }
+
+        uint8_t tile = sprite[1];
+        uint8_t attributes = sprite[2];
+        int x = sprite[3];
+
+        if (attributes & 0x80) {
+            row = height - 1 - row; // Vertical flip
+        }
+
+        uint16_t patternAddress;
+        if (height == 16) {
+            patternAddress = ((tile & 0x01) << 12) | ((tile & 0xFE) << 4) | ((row & 0x08) << 1) | (row & 0x07);
+        } else {
+            patternAddress = ((PPUCTRL & 0x08) ? 0x1000 : 0x0000) | (tile << 4) | row;
+        }
+        const uint8_t* pixels = cartridge->getCHRTileRow(patternAddress);
+
+        uint8_t flags = ((attributes & 0x03) << 2) | (attributes & 0x20) | (i == 0 ? 0x40 : 0x00);
+        for (int p = 0; p < 8 && x + p < SCREEN_WIDTH; ++p) {
+            uint8_t colour = pixels[(attributes & 0x40) ? 7 - p : p]; // Horizontal flip
+
+            // Lower OAM indices have priority over later sprites
+            if (colour && !(lineSprites[x + p] & 0x03)) {
+                lineSprites[x + p] = flags | colour;
+            }
+        }
+    }
+}
+
+void PPU::incrementY() {
+    if ((vramAddress & 0x7000) != 0x7000) {
+        vramAddress += 0x1000; // Fine Y
+        return;
+    }
+
+    vramAddress &= ~0x7000;
+    uint16_t coarseY = (vramAddress >> 5) & 0x1F;
+    if (coarseY == 29) {
+        coarseY = 0;
+        vramAddress ^= 0x0800; // Switch vertical nametable
+    } else if (coarseY == 31) {
+        coarseY = 0;
+    } else {
+        coarseY++;
+    }
+    vramAddress = (vramAddress & ~0x03E0) | (coarseY << 5);
+}
+
+uint8_t PPU::ppuRead(uint16_t address) const {
+    address &= 0x3FFF;
+    if (address < 0x2000) {
+        return cartridge ? cartridge->readCHRROM(address) : 0;
+    }
+    if (address < 0x3F00) {
+        return nametables[(address >> 10) & 0x03][address & 0x03FF];
+    }
+    return paletteRAM[paletteIndex(address)];
+}
+
+void PPU::ppuWrite(uint16_t address, uint8_t value) {
+    address &= 0x3FFF;
+    if (address < 0x2000) {
+        if (cartridge) {
+            cartridge->writeCHRRAM(address, value);
+        }
+    } else if (address < 0x3F00) {
+        nametables[(address >> 10) & 0x03][address & 0x03FF] = value;
+    } else {
+        paletteRAM[paletteIndex(address)] = value & 0x3F;
     }
 }
 
@@ -107,16 +591,29 @@ uint8_t PPU::readRegister(uint16_t address) {
     switch (reg) {
         case 0x2002: // PPUSTATUS
             {
+                // Output the pixels drawn so far so a sprite 0 hit is seen at its exact column
+                if (isMidScanline() && isRenderingEnabled() && !(PPUSTATUS & (1<<6))) {
+                    renderSpan(currentCycle);
+                }
                 uint8_t status = PPUSTATUS;
                 PPUSTATUS &= 0x7F; // Clear the vertical blank flag (bit 7)
+                writeToggle = false;
                 return status;
             }
         case 0x2004: // OAMDATA
             return OAM[OAMADDR]; // Read from OAM at current OAMADDR
         case 0x2007: // PPUDATA
             {
-                uint8_t data = VRAM[PPUADDR % 2048]; // Read from VRAM
-                PPUADDR += (PPUCTRL & 0x04) ? 32 : 1; // Increment PPUADDR by 1 or 32
+                uint16_t vramAddr = vramAddress & 0x3FFF;
+                uint8_t data;
+                if (vramAddr >= 0x3F00) {
+                    data = ppuRead(vramAddr); // Palette reads are not buffered
+                    PPUDATA = ppuRead(vramAddr - 0x1000); // Buffer gets the nametable byte underneath
+                } else {
+                    data = PPUDATA; // Return the previous fetch
+                    PPUDATA = ppuRead(vramAddr);
+                }
+                vramAddress = (vramAddress + ((PPUCTRL & 0x04) ? 32 : 1)) & 0x7FFF; // Increment by 1 or 32
                 return data;
             }
         default:
@@ -167,9 +664,23 @@ uint8_t PPU::readRegister(uint16_t address) {
 
 void PPU::writeRegister(uint16_t address, uint8_t value) {
     uint16_t reg = address & 0x2007; // Handle mirroring within $2000-$2007
+
+    // A write during the visible part of a scanline splits it: pixels up to
+    // here keep the old state and the rest of the line is refetched
+    bool midScanline = isMidScanline();
+    if (midScanline) {
+        renderSpan(currentCycle);
+        lineFetched = false;
+    }
+
     switch (reg) {
         case 0x2000: // PPUCTRL
+            // Enabling NMI while already in VBlank raises it immediately
+            if (!(PPUCTRL & 0x80) && (value & 0x80) && (PPUSTATUS & 0x80) && triggerNMI) {
+                triggerNMI();
+            }
             PPUCTRL = value;
+            tempAddress = (tempAddress & ~0x0C00) | ((value & 0x03) << 10); // Nametable select
             break;
         case 0x2001: // PPUMASK
             PPUMASK = value;
@@ -182,15 +693,32 @@ void PPU::writeRegister(uint16_t address, uint8_t value) {
             break;
         case 0x2005: // PPUSCROLL
             if (!writeToggle) {
-                scrollX = value; // First write: Fine X scroll
+                // First write: coarse and fine X scroll
+                tempAddress = (tempAddress & ~0x001F) | (value >> 3);
+                fineX = value & 0x07;
             } else {
-                scrollY = value; // Second write: Fine Y scroll
+                // Second write: coarse and fine Y scroll
+                tempAddress = (tempAddress & ~0x73E0) | ((value & 0x07) << 12) | ((value & 0xF8) << 2);
+            }
+            writeToggle = !writeToggle; // Toggle latch
+            break;
+        case 0x2006: // PPUADDR
+            if (!writeToggle) {
+                tempAddress = (tempAddress & 0x00FF) | ((value & 0x3F) << 8); // First write: high byte
+            } else {
+                tempAddress = (tempAddress & 0xFF00) | value; // Second write: low byte
+                vramAddress = tempAddress;
+                if (midScanline) {
+                    // The rest of the line is drawn from the new address
+                    lineAddress = vramAddress;
+                    lineOriginX = renderedX;
+                }
             }
             writeToggle = !writeToggle; // Toggle latch
             break;
         case 0x2007: // PPUDATA
-            VRAM[PPUADDR % 2048] = value; // Write to VRAM
-            PPUADDR += (PPUCTRL & 0x04) ? 32 : 1; // Increment PPUADDR
+            ppuWrite(vramAddress, value);
+            vramAddress = (vramAddress + ((PPUCTRL & 0x04) ? 32 : 1)) & 0x7FFF; // Increment by 1 or 32
             break;
         default:
             std::ostringstream oss;
@@ -9,9 +9,16 @@
 #ifndef PPU_H
 #define PPU_H
 
+#include <array>
 #include <cstdint>
 #include <vector>
 #include <functional>
+#include <memory>
+#include "ppu_composite.h"
+
+class Cartridge;
+class SnapshotWriter;
+class SnapshotReader;
 
 /**
  * @class PPU
@@ -24,6 +31,9 @@
 class PPU
 {
     public:
+        static constexpr int SCREEN_WIDTH = 256;  /**< Visible pixels per scanline. */
+        static constexpr int SCREEN_HEIGHT = 240; /**< Visible scanlines per frame. */
+
         /**
          * @brief Constructs a new PPU object.
          *
@@ -46,6 +56,66 @@ class PPU
          */
         void step();
 
+        /**
+         * @brief Advances the PPU by a batch of cycles.
+         *
+         * Equivalent to calling step() the given number of times, but moves
+         * through each scanline in one stride and only stops at scanline
+         * boundaries to handle VBlank events.
+         *
+         * @param cycles Number of PPU cycles to run.
+         * @return True if a frame was completed (VBlank entered) during the batch.
+         */
+        bool run(uint32_t cycles);
+
+        /**
+         * @brief Advances the PPU until its timestamp reaches a target cycle.
+         *
+         * Used for catch-up synchronisation: the PPU is left idle while the CPU
+         * runs and is only brought forward when its state becomes observable.
+         *
+         * @param targetCycle Absolute PPU cycle to run up to.
+         * @return True if a frame was completed (VBlank entered) while catching up.
+         */
+        bool catchUp(uint64_t targetCycle);
+
+        /**
+         * @brief Gets the number of PPU cycles executed since power-on.
+         * @return The PPU timestamp.
+         */
+        uint64_t getTimestamp() const;
+
+        /**
+         * @brief Predicts the absolute PPU cycle of the next VBlank start or end, or mapper A12 rise.
+         *
+         * VBlank start is where the NMI is raised and the frame completes, so the
+         * PPU must be caught up no later than this cycle.
+         *
+         * When the mapper counts scanlines, the next A12 rise is also an event,
+         * so that its IRQ is raised on the right scanline.
+         *
+         * @return The PPU timestamp at which the next event occurs.
+         */
+        uint64_t nextEventCycle() const;
+
+        /**
+         * @brief Predicts the earliest PPU cycle at which a PPUSTATUS flag may change other than by a read.
+         *
+         * Besides the VBlank start and end of nextEventCycle(), sprite 0 hit and
+         * sprite overflow may be set on visible scanlines while rendering: the
+         * first scanline sprite 0 covers and the first one with more than eight
+         * sprites bound when that can happen.
+         *
+         * @return A PPU timestamp no later than the next change.
+         */
+        uint64_t nextStatusChangeCycle() const;
+
+        /**
+         * @brief Gets the number of frames completed since power-on.
+         * @return The frame counter.
+         */
+        uint64_t getFrameCount() const;
+
         /**
          * @brief Reads from a memory-mapped PPU register.
          * 
@@ -62,11 +132,145 @@ class PPU
          */
         void writeRegister(uint16_t address, uint8_t value);
 
+        /**
+         * @brief Writes a 256-byte page to OAM as an OAM DMA does.
+         *
+         * The bytes go through OAMDATA, so the copy starts at OAMADDR and
+         * wraps around, leaving OAMADDR unchanged.
+         *
+         * @param data The source page.
+         */
+        void writeOAMDMA(const uint8_t* data);
+
+        /**
+         * @brief Connects the cartridge supplying pattern tables and nametable mirroring.
+         * @param cartridge The loaded cartridge.
+         */
+        void connectCartridge(std::shared_ptr<Cartridge> cartridge);
+
+        /**
+         * @brief Outputs the pixels of the current scanline displayed so far.
+         *
+         * Called before the cartridge switches CHR banks so that the rest of the
+         * line is refetched with the new banks, as for a mid-scanline register write.
+         */
+        void flushScanline();
+
+        /**
+         * @brief Re-reads the nametable mirroring from the cartridge's mapper.
+         */
+        void updateMirroring();
+
+        /**
+         * @brief Gets the rendered frame as NES palette indices.
+         *
+         * The buffer holds SCREEN_WIDTH x SCREEN_HEIGHT bytes in row-major order,
+         * each a 6-bit system palette index. It is complete once a frame has been
+         * reported (VBlank entered).
+         *
+         * @return Pointer to the first pixel of the frame.
+         */
+        const uint8_t* getFrameBuffer() const;
+
+        /**
+         * @brief Enables or disables an RGBA8888 copy of the frame.
+         *
+         * When enabled, scanlines are converted to RGBA in the same pass that
+         * composites them, instead of converting whole frames afterwards.
+         *
+         * @param enabled True to produce the RGBA frame.
+         */
+        void setRGBAOutput(bool enabled);
+
+        /**
+         * @brief Gets the rendered frame as RGBA8888 pixels.
+         * @return Pointer to the first pixel, or nullptr if RGBA output is disabled.
+         */
+        const uint32_t* getFrameBufferRGBA() const;
+
+        /**
+         * @brief Writes the registers, timing and video memories to a snapshot section.
+         *
+         * The frame buffers are not saved: they are output, rebuilt by the
+         * next frame rendered.
+         *
+         * @param writer The snapshot being written.
+         */
+        void saveState(SnapshotWriter& writer) const;
+
+        /**
+         * @brief Restores the section written by saveState().
+         *
+         * Call after the cartridge state has been restored, since the
+         * nametable mapping follows the mapper's mirroring.
+         *
+         * @param reader The snapshot being read.
+         */
+        void loadState(SnapshotReader& reader);
+
         // Register a callback for triggering NMI
         void setNMICallback(const std::function<void()>& callback);
         void setIRQCallback(const std::function<void()>& callback);
 
     private:
+        /**
+         * @brief Reads a byte from the PPU address space ($0000-$3FFF).
+         * @param address PPU address.
+         * @return The byte at the address.
+         */
+        uint8_t ppuRead(uint16_t address) const;
+
+        /**
+         * @brief Writes a byte to the PPU address space ($0000-$3FFF).
+         * @param address PPU address.
+         * @param value The byte to write.
+         */
+        void ppuWrite(uint16_t address, uint8_t value);
+
+        /** @brief Returns true if background or sprite rendering is enabled in PPUMASK. */
+        bool isRenderingEnabled() const { return (PPUMASK & 0x18) != 0; }
+
+        /** @brief Returns true if the beam is inside the visible part of a visible scanline. */
+        bool isMidScanline() const;
+
+        /** @brief Latches the scroll position at the start of a visible scanline. */
+        void beginScanline();
+
+        /** @brief Renders the rest of the scanline and applies the end-of-line scroll updates. */
+        void finishScanline();
+
+        /**
+         * @brief Outputs the pixels of the current scanline up to (excluding) a column.
+         *
+         * Normally called once per scanline for all 256 pixels. When a register is
+         * written mid-scanline, the line is split into spans at the exact pixel of
+         * the write so that each span is rendered with the state it was displayed with.
+         *
+         * @param endX Column to render up to.
+         */
+        void renderSpan(int endX);
+
+        /** @brief Fetches the background tiles of the current scanline and expands them into lineBackground. */
+        void fetchBackground();
+
+        /** @brief Evaluates and fetches the sprites of the current scanline into lineSprites. */
+        void fetchSprites();
+
+        /** @brief Increments the coarse and fine Y scroll in the VRAM address (loopy "inc vert(v)"). */
+        void incrementY();
+
+        /**
+         * @brief Gets the cycle of a scanline at which PPU A12 rises, if the mapper counts it.
+         *
+         * A12 rises when pattern fetches move from the $0000 table to the $1000
+         * table: at the sprite fetches (cycle 260) when sprites use $1000, or at
+         * the next line's background fetches (cycle 324) when the background does.
+         *
+         * @param scanline The scanline (0-261).
+         * @return The cycle, or 0 if there is no counted rise on the scanline.
+         */
+        uint16_t a12RiseCycle(int scanline) const;
+
         std::function<void()> triggerNMI; // NMI callback function
         std::function<void()> triggerIRQ; // IRQ callback function
 
@@ -87,27 +291,62 @@ class PPU
         /** @brief OAM data register (OAMDATA). Used to access sprite attribute data. */
         uint8_t OAMDATA;    // $2004
 
-        /** @brief Scroll register (PPUSCROLL). Sets the scroll position for the background. */
-        uint8_t PPUSCROLL;  // $2005
+        /** @brief Data register (PPUDATA) read buffer. Reads below the palette return the previous fetch. */
+        uint8_t PPUDATA;    // $2007
 
-        /** @brief Address register (PPUADDR). Holds the address for VRAM read/write operations. */
-        uint8_t PPUADDR;    // $2006
+        /** @brief Current VRAM address (loopy "v"). Also holds the scroll position while rendering. */
+        uint16_t vramAddress = 0;
 
-        /** @brief Data register (PPUDATA). Used to read or write data to/from VRAM. */
-        uint8_t PPUDATA;    // $2007
+        /** @brief Temporary VRAM address (loopy "t"). Scroll and address writes land here first. */
+        uint16_t tempAddress = 0;
+
+        /** @brief Fine X scroll (0-7), written through PPUSCROLL. */
+        uint8_t fineX = 0;
 
-        /** @brief Video RAM (VRAM). 2 KB of memory for storing tile data and other graphics-related data. */
+        /** @brief Video RAM (VRAM). 2 KB of nametable memory, or 4 KB with a four-screen cartridge. */
         std::vector<uint8_t> VRAM;
 
         /** @brief Object Attribute Memory (OAM). 256 bytes for storing sprite attributes. */
         std::vector<uint8_t> OAM;
 
+        /** @brief Palette RAM. 32 bytes of background and sprite palette indices. */
+        std::array<uint8_t, 32> paletteRAM{};
+
+        /** @brief The four logical nametables ($2000/$2400/$2800/$2C00) mapped into VRAM by mirroring. */
+        std::array<uint8_t*, 4> nametables{};
+
+        /** @brief Cartridge providing CHR data. */
+        std::shared_ptr<Cartridge> cartridge;
+
+        /** @brief The cartridge's mapper counts A12 rises (scanline IRQ). */
+        bool countA12Rises = false;
+
+        /** @brief Rendered frame, one system palette index per pixel. */
+        std::vector<uint8_t> frameBuffer;
+
+        /** @brief Rendered frame as RGBA8888; empty unless RGBA output is enabled. */
+        std::vector<uint32_t> frameBufferRGBA;
+
+        /** @brief Compositing kernel selected for the host CPU. */
+        CompositeKernel compositeKernel;
+
+        /** @brief Background pixels of the current scanline: palette (bits 2-3) and colour (bits 0-1). */
+        std::array<uint8_t, SCREEN_WIDTH> lineBackground{};
+
+        /** @brief Sprite pixels of the current scanline: colour (bits 0-3), behind background (bit 5), sprite 0 (bit 6). */
+        std::array<uint8_t, SCREEN_WIDTH> lineSprites{};
+
+        uint16_t lineAddress = 0;   // VRAM address the current scanline is scrolled from
+        int lineOriginX = 0;        // Column at which lineAddress took effect
+        int renderedX = 0;          // Columns of the current scanline already output
+        bool lineFetched = false;   // lineBackground/lineSprites are valid for the current state
+
         uint16_t currentCycle = 0;     // Current cycle in the scanline (0-340)
-        uint16_t currentScanline = 0;  // Current scanline (0-260)
+        uint16_t currentScanline = 0;  // Current scanline (0-261)
+        uint64_t frameCount = 0;       // Frames completed (VBlank entries)
+        uint64_t timestamp = 0;        // PPU cycles executed since power-on
 
         bool writeToggle = false; // Tracks alternating writes to PPUSCROLL/PPUADDR
-        uint8_t scrollX = 0;      // Fine X scroll
-        uint8_t scrollY = 0;      // Fine Y scroll
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include "ppu_composite.h"
+
+#if !defined(NES_PPU_SCALAR_ONLY) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PPU_COMPOSITE_X86 1
+#include <immintrin.h>
+#endif
+
+/* Pack a colour as RGBA8888 with R in the lowest byte */
+static constexpr uint32_t rgba(uint8_t r, uint8_t g, uint8_t b) {
+    return r | (g << 8) | (b << 16) | (0xFFu << 24);
+}
+
+const uint32_t SYSTEM_PALETTE_RGBA[64] = {
+    rgba( 84,  84,  84), rgba(  0,  30, 116), rgba(  8,  16, 144), rgba( 48,   0, 136),
+    rgba( 68,   0, 100), rgba( 92,   0,  48), rgba( 84,   4,   0), rgba( 60,  24,   0),
+    rgba( 32,  42,   0), rgba(  8,  58,   0), rgba(  0,  64,   0), rgba(  0,  60,   0),
+    rgba(  0,  50,  60), rgba(  0,   0,   0), rgba(  0,   0,   0), rgba(  0,   0,   0),
+    rgba(152, 150, 152), rgba(  8,  76, 196), rgba( 48,  50, 236), rgba( 92,  30, 228),
+    rgba(136,  20, 176), rgba(160,  20, 100), rgba(152,  34,  32), rgba(120,  60,   0),
+    rgba( 84,  90,   0), rgba( 40, 114,   0), rgba(  8, 124,   0), rgba(  0, 118,  40),
+    rgba(  0, 102, 120), rgba(  0,   0,   0), rgba(  0,   0,   0), rgba(  0,   0,   0),
+    rgba(236, 238, 236), rgba( 76, 154, 236), rgba(120, 124, 236), rgba(176,  98, 236),
+    rgba(228,  84, 236), rgba(236,  88, 180), rgba(236, 106, 100), rgba(212, 136,  32),
+    rgba(160, 170,   0), rgba(116, 196,   0), rgba( 76, 208,  32), rgba( 56, 204, 108),
+    rgba( 56, 180, 204), rgba( 60,  60,  60), rgba(  0,   0,   0), rgba(  0,   0,   0),
+    rgba(236, 238, 236), rgba(168, 204, 236), rgba(188, 188, 236), rgba(212, 178, 236),
+    rgba(236, 174, 236), rgba(236, 174, 212), rgba(236, 180, 176), rgba(228, 196, 144),
+    rgba(204, 210, 120), rgba(180, 222, 120), rgba(168, 226, 144), rgba(152, 226, 180),
+    rgba(160, 214, 228), rgba(160, 162, 160), rgba(  0,   0,   0), rgba(  0,   0,   0),
+};
+
+/*
+Every kernel reduces a pixel to a 5-bit colour (0 = universal background,
+1-15 = background palettes, 17-31 = sprite palettes) and then looks that
+colour up in tables built once per span from palette RAM and PPUMASK.
+*/
+namespace {
+
+struct SpanTables {
+    alignas(32) uint8_t index[32]; /**< Colour to system palette index (greyscale applied). */
+    alignas(32) uint32_t rgba[32]; /**< Colour to RGBA8888. */
+    uint8_t backgroundMask;        /**< Background pixel mask for columns 8-255. */
+    uint8_t backgroundLeftMask;    /**< Background pixel mask for columns 0-7. */
+    uint8_t spriteMask;            /**< Sprite pixel mask for columns 8-255. */
+    uint8_t spriteLeftMask;        /**< Sprite pixel mask for columns 0-7. */
+};
+
+void prepareTables(const CompositeSpan& span, SpanTables& tables) {
+    uint8_t greyscaleMask = (span.mask & 0x01) ? 0x30 : 0x3F;
+    for (int colour = 0; colour < 32; ++colour) {
+        tables.index[colour] = span.palette[colour] & greyscaleMask;
+        tables.rgba[colour] = SYSTEM_PALETTE_RGBA[tables.index[colour]];
+    }
+
+    tables.backgroundMask = (span.mask & 0x08) ? 0xFF : 0x00;
+    tables.backgroundLeftMask = ((span.mask & 0x0A) == 0x0A) ? 0xFF : 0x00;
+    tables.spriteMask = (span.mask & 0x10) ? 0xFF : 0x00;
+    tables.spriteLeftMask = ((span.mask & 0x14) == 0x14) ? 0xFF : 0x00;
+}
+
+inline bool compositePixel(const CompositeSpan& span, const SpanTables& tables, int x) {
+    uint8_t background = span.background[x] & (x < 8 ? tables.backgroundLeftMask : tables.backgroundMask);
+    uint8_t sprite = span.sprites[x] & (x < 8 ? tables.spriteLeftMask : tables.spriteMask);
+
+    bool hit = false;
+    uint8_t colour = 0;
+    if (sprite & 0x03) {
+        hit = (sprite & 0x40) && (background & 0x03) && x != 255;
+        colour = ((background & 0x03) && (sprite & 0x20)) ? background : (0x10 | (sprite & 0x0F));
+    } else if (background & 0x03) {
+        colour = background;
+    }
+
+    span.indices[x] = tables.index[colour];
+    if (span.rgba) {
+        span.rgba[x] = tables.rgba[colour];
+    }
+    return hit;
+}
+
+/* Sprite 0 hit never occurs at column 255; clear its bit from a block hit mask */
+inline uint32_t maskColumn255(uint32_t hits, int x, int width) {
+    return (x <= 255 && 255 < x + width) ? (hits & ~(1u << (255 - x))) : hits;
+}
+
+#ifdef PPU_COMPOSITE_X86
+
+/* Composites 16 pixels from column x; returns true on sprite 0 hit */
+__attribute__((target("sse2")))
+inline bool compositeBlockSSE2(const CompositeSpan& span, const SpanTables& tables, int x) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaqueBits = _mm_set1_epi8(0x03);
+    const __m128i behindBit = _mm_set1_epi8(0x20);
+    const __m128i sprite0Bit = _mm_set1_epi8(0x40);
+    const __m128i spriteColourBits = _mm_set1_epi8(0x0F);
+    const __m128i spritePalette = _mm_set1_epi8(0x10);
+
+    __m128i background = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(span.background + x)),
+                                       _mm_set1_epi8(static_cast<char>(tables.backgroundMask)));
+    __m128i sprite = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(span.sprites + x)),
+                                   _mm_set1_epi8(static_cast<char>(tables.spriteMask)));
+
+    __m128i backgroundClear = _mm_cmpeq_epi8(_mm_and_si128(background, opaqueBits), zero);
+    __m128i spriteClear = _mm_cmpeq_epi8(_mm_and_si128(sprite, opaqueBits), zero);
+    __m128i inFront = _mm_cmpeq_epi8(_mm_and_si128(sprite, behindBit), zero);
+    __m128i sprite0 = _mm_cmpeq_epi8(_mm_and_si128(sprite, sprite0Bit), sprite0Bit);
+
+    // Both opaque and the sprite pixel belongs to sprite 0
+    __m128i hits = _mm_andnot_si128(backgroundClear, _mm_andnot_si128(spriteClear, sprite0));
+
+    // Priority mux: opaque sprite pixels win unless behind an opaque background pixel
+    __m128i useSprite = _mm_andnot_si128(spriteClear, _mm_or_si128(backgroundClear, inFront));
+    __m128i backgroundColour = _mm_andnot_si128(backgroundClear, background);
+    __m128i spriteColour = _mm_or_si128(_mm_and_si128(sprite, spriteColourBits), spritePalette);
+    __m128i colour = _mm_or_si128(_mm_and_si128(useSprite, spriteColour), _mm_andnot_si128(useSprite, backgroundColour));
+
+    // SSE2 has no byte shuffle, so the palette lookup stays a table read per pixel
+    alignas(16) uint8_t colours[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(colours), colour);
+    for (int i = 0; i < 16; ++i) {
+        span.indices[x + i] = tables.index[colours[i]];
+    }
+    if (span.rgba) {
+        for (int i = 0; i < 16; ++i) {
+            span.rgba[x + i] = tables.rgba[colours[i]];
+        }
+    }
+
+    return maskColumn255(static_cast<uint32_t>(_mm_movemask_epi8(hits)), x, 16) != 0;
+}
+
+/* Composites 32 pixels from column x; returns true on sprite 0 hit */
+__attribute__((target("avx2")))
+inline bool compositeBlockAVX2(const CompositeSpan& span, const SpanTables& tables, int x) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i opaqueBits = _mm256_set1_epi8(0x03);
+    const __m256i behindBit = _mm256_set1_epi8(0x20);
+    const __m256i sprite0Bit = _mm256_set1_epi8(0x40);
+    const __m256i spriteColourBits = _mm256_set1_epi8(0x0F);
+    const __m256i spritePalette = _mm256_set1_epi8(0x10);
+
+    // Palette lookup tables for pshufb: colours 0-15 and 16-31, repeated in both lanes
+    const __m256i indexLow = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(tables.index)));
+    const __m256i indexHigh = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(tables.index + 16)));
+
+    __m256i background = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(span.background + x)),
+                                          _mm256_set1_epi8(static_cast<char>(tables.backgroundMask)));
+    __m256i sprite = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(span.sprites + x)),
+                                      _mm256_set1_epi8(static_cast<char>(tables.spriteMask)));
+
+    __m256i backgroundClear = _mm256_cmpeq_epi8(_mm256_and_si256(background, opaqueBits), zero);
+    __m256i spriteClear = _mm256_cmpeq_epi8(_mm256_and_si256(sprite, opaqueBits), zero);
+    __m256i inFront = _mm256_cmpeq_epi8(_mm256_and_si256(sprite, behindBit), zero);
+    __m256i sprite0 = _mm256_cmpeq_epi8(_mm256_and_si256(sprite, sprite0Bit), sprite0Bit);
+
+    // Both opaque and the sprite pixel belongs to sprite 0
+    __m256i hits = _mm256_andnot_si256(backgroundClear, _mm256_andnot_si256(spriteClear, sprite0));
+
+    // Priority mux: opaque sprite pixels win unless behind an opaque background pixel
+    __m256i useSprite = _mm256_andnot_si256(spriteClear, _mm256_or_si256(backgroundClear, inFront));
+    __m256i backgroundColour = _mm256_andnot_si256(backgroundClear, background);
+    __m256i spriteColour = _mm256_or_si256(_mm256_and_si256(sprite, spriteColourBits), spritePalette);
+    __m256i colour = _mm256_blendv_epi8(backgroundColour, spriteColour, useSprite);
+
+    // Palette lookup: shuffle within each 16-entry half, then select the half by bit 4
+    __m256i nibble = _mm256_and_si256(colour, spriteColourBits);
+    __m256i upperHalf = _mm256_cmpeq_epi8(_mm256_and_si256(colour, spritePalette), spritePalette);
+    __m256i index = _mm256_blendv_epi8(_mm256_shuffle_epi8(indexLow, nibble), _mm256_shuffle_epi8(indexHigh, nibble), upperHalf);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(span.indices + x), index);
+
+    if (span.rgba) {
+        // Widen 8 colours at a time to 32-bit lanes and gather their RGBA values
+        alignas(32) uint8_t colours[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(colours), colour);
+        for (int i = 0; i < 32; i += 8) {
+            __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(colours + i)));
+            __m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(tables.rgba), lanes, 4);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(span.rgba + x + i), pixels);
+        }
+    }
+
+    return maskColumn255(static_cast<uint32_t>(_mm256_movemask_epi8(hits)), x, 32) != 0;
+}
+
+/*
+Vector kernels composite columns 0-7 one pixel at a time (they have their own
+clipping masks), then whole blocks. A short remainder is covered by one more
+block overlapping pixels already composited, which recomputes the same values.
+*/
+template <int Width, bool (*Block)(const CompositeSpan&, const SpanTables&, int)>
+bool compositeBlocks(const CompositeSpan& span) {
+    SpanTables tables;
+    prepareTables(span, tables);
+
+    bool hit = false;
+    int x = span.startX;
+    for (; x < span.endX && x < 8; ++x) {
+        hit |= compositePixel(span, tables, x);
+    }
+
+    int blockStart = x;
+    for (; x + Width <= span.endX; x += Width) {
+        hit |= Block(span, tables, x);
+    }
+    if (x < span.endX && span.endX - Width >= blockStart) {
+        hit |= Block(span, tables, span.endX - Width);
+        x = span.endX;
+    }
+
+    for (; x < span.endX; ++x) {
+        hit |= compositePixel(span, tables, x);
+    }
+    return hit;
+}
+
+__attribute__((target("sse2")))
+bool compositeSSE2(const CompositeSpan& span) {
+    return compositeBlocks<16, compositeBlockSSE2>(span);
+}
+
+__attribute__((target("avx2")))
+bool compositeAVX2(const CompositeSpan& span) {
+    return compositeBlocks<32, compositeBlockAVX2>(span);
+}
+
+__attribute__((target("avx2")))
+void convertAVX2(const uint8_t* indices, uint32_t* rgba, size_t count) {
+    const __m256i indexBits = _mm256_set1_epi32(0x3F);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i)));
+        lanes = _mm256_and_si256(lanes, indexBits);
+        __m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(SYSTEM_PALETTE_RGBA), lanes, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i), pixels);
+    }
+    for (; i < count; ++i) {
+        rgba[i] = SYSTEM_PALETTE_RGBA[indices[i] & 0x3F];
+    }
+}
+
+bool hostSupportsAVX2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+bool hostSupportsSSE2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+#endif // PPU_COMPOSITE_X86
+
+void convertScalar(const uint8_t* indices, uint32_t* rgba, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        rgba[i] = SYSTEM_PALETTE_RGBA[indices[i] & 0x3F];
+    }
+}
+
+} // namespace
+
+bool compositeScalar(const CompositeSpan& span) {
+    SpanTables tables;
+    prepareTables(span, tables);
+
+    bool hit = false;
+    for (int x = span.startX; x < span.endX; ++x) {
+        hit |= compositePixel(span, tables, x);
+    }
+    return hit;
+}
+
+CompositeKernel selectCompositeKernel() {
+#ifdef PPU_COMPOSITE_X86
+    if (hostSupportsAVX2()) {
+        return compositeAVX2;
+    }
+    if (hostSupportsSSE2()) {
+        return compositeSSE2;
+    }
+#endif
+    return compositeScalar;
+}
+
+const char* compositeKernelName([[maybe_unused]] CompositeKernel kernel) {
+#ifdef PPU_COMPOSITE_X86
+    if (kernel == compositeAVX2) {
+        return "avx2";
+    }
+    if (kernel == compositeSSE2) {
+        return "sse2";
+    }
+#endif
+    return "scalar";
+}
+
+void convertToRGBA(const uint8_t* indices, uint32_t* rgba, size_t count) {
+#ifdef PPU_COMPOSITE_X86
+    static const bool useAVX2 = hostSupportsAVX2();
+    if (useAVX2) {
+        convertAVX2(indices, rgba, count);
+        return;
+    }
+#endif
+    // A 64-entry table lookup per pixel; SSE2 has no byte gather to improve on it
+    convertScalar(indices, rgba, count);
+}
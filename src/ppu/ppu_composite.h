@@ -0,0 +1,74 @@
+/**
+ * @file ppu_composite.h
+ * @brief Scanline compositing kernels: background/sprite priority, palette lookup and RGBA conversion.
+ *
+ * The kernels are data-parallel across the pixels of a scanline. A scalar
+ * kernel is always available; SSE2 and AVX2 kernels are compiled on x86 and
+ * the widest one supported by the host is selected at runtime.
+ */
+
+#ifndef PPU_COMPOSITE_H
+#define PPU_COMPOSITE_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief NES system palette as RGBA8888 (bytes R, G, B, A in memory on little-endian hosts).
+ */
+extern const uint32_t SYSTEM_PALETTE_RGBA[64];
+
+/**
+ * @struct CompositeSpan
+ * @brief Inputs and outputs for compositing a run of pixels of one scanline.
+ *
+ * All line pointers address column 0 of the scanline; only columns
+ * [startX, endX) are read and written.
+ */
+struct CompositeSpan {
+    const uint8_t* background; /**< Background pixels: palette (bits 2-3) and colour (bits 0-1). */
+    const uint8_t* sprites;    /**< Sprite pixels: colour (bits 0-3), behind background (bit 5), sprite 0 (bit 6). */
+    int startX;                /**< First column to composite. */
+    int endX;                  /**< Column after the last one to composite. */
+    uint8_t mask;              /**< PPUMASK: show/clip background and sprites, greyscale. */
+    const uint8_t* palette;    /**< The 32 bytes of palette RAM. */
+    uint8_t* indices;          /**< Output system palette indices. */
+    uint32_t* rgba;            /**< Output RGBA8888 pixels, or nullptr to skip conversion. */
+};
+
+/**
+ * @brief Composites a span of a scanline.
+ * @param span The span to composite.
+ * @return True if sprite 0 hit occurred within the span.
+ */
+using CompositeKernel = bool (*)(const CompositeSpan& span);
+
+/**
+ * @brief Portable compositing kernel, one pixel at a time.
+ * @param span The span to composite.
+ * @return True if sprite 0 hit occurred within the span.
+ */
+bool compositeScalar(const CompositeSpan& span);
+
+/**
+ * @brief Selects the fastest compositing kernel supported by the host CPU.
+ * @return The kernel to use for all scanlines.
+ */
+CompositeKernel selectCompositeKernel();
+
+/**
+ * @brief Gets the name of a compositing kernel ("scalar", "sse2" or "avx2").
+ * @param kernel A kernel returned by selectCompositeKernel().
+ * @return The kernel's name.
+ */
+const char* compositeKernelName(CompositeKernel kernel);
+
+/**
+ * @brief Converts system palette indices to RGBA8888.
+ * @param indices Input palette indices (only the low 6 bits are used).
+ * @param rgba Output pixels.
+ * @param count Number of pixels.
+ */
+void convertToRGBA(const uint8_t* indices, uint32_t* rgba, size_t count);
+
+#endif // PPU_COMPOSITE_H
@@ -0,0 +1,194 @@
+#include "headless_runner.h"
+#include "Cpu/cpu6502_opcodes.h"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Reports a failed check and counts it; the test fails if any check did */
+static int failures = 0;
+#define CHECK(condition)                                                         \
+    do {                                                                         \
+        if (!(condition)) {                                                      \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+/* The 151 documented 6502 opcodes */
+static const uint8_t OFFICIAL_OPCODES[] = {
+    0x00, 0x01, 0x05, 0x06, 0x08, 0x09, 0x0A, 0x0D, 0x0E, 0x10, 0x11, 0x15, 0x16, 0x18, 0x19, 0x1D,
+    0x1E, 0x20, 0x21, 0x24, 0x25, 0x26, 0x28, 0x29, 0x2A, 0x2C, 0x2D, 0x2E, 0x30, 0x31, 0x35, 0x36,
+    0x38, 0x39, 0x3D, 0x3E, 0x40, 0x41, 0x45, 0x46, 0x48, 0x49, 0x4A, 0x4C, 0x4D, 0x4E, 0x50, 0x51,
+    0x55, 0x56, 0x58, 0x59, 0x5D, 0x5E, 0x60, 0x61, 0x65, 0x66, 0x68, 0x69, 0x6A, 0x6C, 0x6D, 0x6E,
+    0x70, 0x71, 0x75, 0x76, 0x78, 0x79, 0x7D, 0x7E, 0x81, 0x84, 0x85, 0x86, 0x88, 0x8A, 0x8C, 0x8D,
+    0x8E, 0x90, 0x91, 0x94, 0x95, 0x96, 0x98, 0x99, 0x9A, 0x9D, 0xA0, 0xA1, 0xA2, 0xA4, 0xA5, 0xA6,
+    0xA8, 0xA9, 0xAA, 0xAC, 0xAD, 0xAE, 0xB0, 0xB1, 0xB4, 0xB5, 0xB6, 0xB8, 0xB9, 0xBA, 0xBC, 0xBD,
+    0xBE, 0xC0, 0xC1, 0xC4, 0xC5, 0xC6, 0xC8, 0xC9, 0xCA, 0xCC, 0xCD, 0xCE, 0xD0, 0xD1, 0xD5, 0xD6,
+    0xD8, 0xD9, 0xDD, 0xDE, 0xE0, 0xE1, 0xE4, 0xE5, 0xE6, 0xE8, 0xE9, 0xEA, 0xEC, 0xED, 0xEE, 0xF0,
+    0xF1, 0xF5, 0xF6, 0xF8, 0xF9, 0xFD, 0xFE,
+};
+
+constexpr uint16_t CODE_START = 0x8000;
+
+/* Writes a 16 KB NROM image running code from $8000, with every vector pointing at vectorTarget */
+static void writeROM(const std::string& path, const std::vector<uint8_t>& code, uint16_t vectorTarget) {
+    std::vector<uint8_t> prg(0x4000, 0xEA);
+    std::copy(code.begin(), code.end(), prg.begin());
+    for (int i = 0; i < 3; ++i) {
+        prg[0x3FFA + 2 * i] = vectorTarget & 0xFF;
+        prg[0x3FFB + 2 * i] = vectorTarget >> 8;
+    }
+    prg[0x3FFC] = CODE_START & 0xFF;
+    prg[0x3FFD] = CODE_START >> 8;
+
+    std::vector<uint8_t> rom = {'N', 'E', 'S', 0x1A, 1, 1, 0, 0};
+    rom.resize(16, 0);
+    rom.insert(rom.end(), prg.begin(), prg.end());
+    rom.resize(rom.size() + 0x2000, 0);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(reinterpret_cast<const char*>(rom.data()), rom.size())) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+/* Runs a ROM until its PC rests on the given spin loop; returns false if it never gets there or throws */
+static bool runsTo(const std::string& path, uint16_t spinLoop, std::string& error) {
+    HeadlessOptions options;
+    options.romPath = path;
+    options.frameLimit = 2;
+    options.stopAtPC = true;
+    options.stopPC = spinLoop;
+    try {
+        HeadlessRunner runner(options);
+        return runner.run().conditionMet;
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+}
+
+/*
+ * Executes one instruction of every documented opcode between a setup and a
+ * spin loop. Operands point at RAM: zero page $20, absolute $0300, and the
+ * pointer at $10 for the indirect modes. Control flow instructions land on
+ * the spin loop, set up through the stack or the vectors where needed.
+ */
+static void testEveryOfficialOpcode() {
+    CHECK(sizeof(OFFICIAL_OPCODES) == 151);
+
+    for (uint8_t opcode : OFFICIAL_OPCODES) {
+        const OpcodeInfo& info = OPCODE_TABLE[opcode];
+        std::vector<uint8_t> code;
+        auto emit = [&code](std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); };
+
+        /* Operand size decides where the spin loop lands: setup, opcode, operand */
+        size_t operandSize = 0;
+        switch (info.addressingMode) {
+            case AddressingMode::Implied:
+            case AddressingMode::Accumulator:
+                operandSize = info.instruction == Instruction::BRK ? 1 : 0;
+                break;
+            case AddressingMode::Absolute:
+            case AddressingMode::AbsoluteX:
+            case AddressingMode::AbsoluteY:
+            case AddressingMode::Indirect:
+                operandSize = 2;
+                break;
+            default:
+                operandSize = 1;
+                break;
+        }
+        constexpr size_t SETUP_SIZE = 34;
+        uint16_t spinLoop = static_cast<uint16_t>(CODE_START + SETUP_SIZE + 1 + operandSize);
+        uint8_t spinLow = spinLoop & 0xFF, spinHigh = spinLoop >> 8;
+        uint16_t rtsTarget = spinLoop - 1;
+
+        /* Setup: stack, pointers, a return frame for RTS and RTI, cleared registers */
+        emit({0x78, 0xD8, 0xA2, 0xFF, 0x9A});                             // SEI; CLD; LDX #$FF; TXS
+        emit({0xA9, 0x00, 0x85, 0x10, 0xA9, 0x03, 0x85, 0x11});           // ($10) = $0300
+        emit({0xA9, spinLow, 0x85, 0x12, 0xA9, spinHigh, 0x85, 0x13});    // ($12) = spin loop
+        if (info.instruction == Instruction::RTS) {
+            emit({0xA9, uint8_t(rtsTarget >> 8), 0x48, 0xA9, uint8_t(rtsTarget & 0xFF), 0x48}); // Return address - 1
+        } else {
+            emit({0xA9, spinHigh, 0x48, 0xA9, spinLow, 0x48});            // Return address for RTI
+        }
+        emit({0xA9, 0x24, uint8_t(info.instruction == Instruction::RTS ? 0xEA : 0x48)}); // Status for RTI
+        emit({0xA2, 0x00, 0xA0, 0x00});                                   // LDX #0; LDY #0
+        CHECK(code.size() == SETUP_SIZE);
+
+        /* The instruction under test */
+        code.push_back(opcode);
+        if (info.instruction == Instruction::JMP && info.addressingMode == AddressingMode::Indirect) {
+            emit({0x12, 0x00});
+        } else if (info.instruction == Instruction::JMP || info.instruction == Instruction::JSR) {
+            emit({spinLow, spinHigh});
+        } else if (info.addressingMode == AddressingMode::Relative) {
+            emit({0x00});
+        } else if (operandSize == 2) {
+            emit({0x00, 0x03});
+        } else if (operandSize == 1) {
+            bool indirect = info.addressingMode == AddressingMode::IndirectX || info.addressingMode == AddressingMode::IndirectY;
+            emit({uint8_t(indirect ? 0x10 : info.addressingMode == AddressingMode::Immediate ? 0x01 : 0x20)});
+        }
+
+        /* Spin loop: JMP to itself */
+        CHECK(CODE_START + code.size() == spinLoop);
+        emit({0x4C, spinLow, spinHigh});
+
+        std::string path = "cpu_opcode_test.nes";
+        writeROM(path, code, spinLoop);
+        std::string error;
+        if (!runsTo(path, spinLoop, error)) {
+            std::fprintf(stderr, "Opcode 0x%02X did not run to $%04X%s%s\n", opcode, spinLoop,
+                         error.empty() ? "" : ": ", error.c_str());
+            failures++;
+        }
+    }
+}
+
+/* ROR A rotates the accumulator through the carry */
+static void testRotateRightAccumulator() {
+    std::vector<uint8_t> code = {
+        0x78, 0xD8, 0xA2, 0xFF, 0x9A,       // SEI; CLD; LDX #$FF; TXS
+        0x38, 0xA9, 0x81, 0x6A,             // SEC; LDA #$81; ROR A      -> A = $C0, C = 1
+        0x90, 0x11,                         // BCC fail
+        0x6A,                               // ROR A                     -> A = $E0, C = 0
+        0xB0, 0x0E,                         // BCS fail
+        0x10, 0x0C,                         // BPL fail
+        0xC9, 0xE0, 0xD0, 0x08,             // CMP #$E0; BNE fail
+        0xA9, 0x5A, 0x8D, 0x00, 0x03,       // LDA #$5A; STA $0300
+        0x4C, 0x19, 0x80,                   // spin: JMP spin ($8019)
+                                            // fail ($801C): JMP fail
+        0x4C, 0x1C, 0x80,
+    };
+    std::string path = "cpu_opcode_test_ror.nes";
+    writeROM(path, code, 0x801C);
+
+    HeadlessOptions options;
+    options.romPath = path;
+    options.frameLimit = 2;
+    options.stopOnMemory = true;
+    options.stopAddress = 0x0300;
+    options.stopValue = 0x5A;
+    HeadlessRunner runner(options);
+    CHECK(runner.run().conditionMet);
+}
+
+int main() {
+    try {
+        testEveryOfficialOpcode();
+        testRotateRightAccumulator();
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    if (failures) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "headless_runner.h"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Number of failed cases; the test fails if any did */
+static int failures = 0;
+
+/* Fixed routines, at the same place in every ROM */
+constexpr uint16_t DELAY = 0xF000;   // About 330000 cycles: longer than a frame IRQ period or a DMC sample
+constexpr uint16_t IRQ = 0xF100;
+constexpr uint16_t NMI = 0xF200;
+
+/* Acknowledgements */
+const std::vector<uint8_t> READ_4015 = {0xAD, 0x15, 0x40};                     // LDA $4015
+const std::vector<uint8_t> INHIBIT_FRAME_IRQ = {0xA9, 0x40, 0x8D, 0x17, 0x40};  // LDA #$40; STA $4017
+const std::vector<uint8_t> DISABLE_DMC_IRQ = {0xA9, 0x00, 0x8D, 0x10, 0x40};    // LDA #$00; STA $4010
+const std::vector<uint8_t> STOP_DMC = {0xA9, 0x00, 0x8D, 0x15, 0x40};           // LDA #$00; STA $4015
+const std::vector<uint8_t> WRITE_E000 = {0x8D, 0x00, 0xE0};                     // STA $E000
+
+/* Sources, each raised while SEI masks it */
+const std::vector<uint8_t> WAIT = {0x20, DELAY & 0xFF, DELAY >> 8};            // JSR delay
+const std::vector<uint8_t> DMC_IRQ = {
+    0xA9, 0x40, 0x8D, 0x17, 0x40,                                               // Frame IRQ off
+    0xA9, 0x80, 0x8D, 0x10, 0x40, 0xA9, 0x00, 0x8D, 0x12, 0x40, 0x8D, 0x13, 0x40, // IRQ on, 1-byte sample at $C000
+    0xA9, 0x10, 0x8D, 0x15, 0x40,                                               // Start it
+    0x20, DELAY & 0xFF, DELAY >> 8,
+};
+const std::vector<uint8_t> MAPPER_IRQ = {
+    0xA9, 0x40, 0x8D, 0x17, 0x40,                                               // Frame IRQ off
+    0xA9, 0x08, 0x8D, 0x00, 0xC0, 0x8D, 0x01, 0xC0, 0x8D, 0x01, 0xE0,           // Latch 8, reload, enable
+    0xA9, 0x08, 0x8D, 0x00, 0x20, 0xA9, 0x18, 0x8D, 0x01, 0x20,                 // Sprites at $1000, rendering on
+    0x20, DELAY & 0xFF, DELAY >> 8,
+};
+
+/*
+ * Builds an MMC3 ROM that raises an IRQ with interrupts masked, runs the
+ * acknowledgement, then unmasks them for a few instructions. The IRQ
+ * handler counts its entries and acknowledges the source; the ROM stores
+ * $5A at $0300 if the count is as expected.
+ */
+static std::vector<uint8_t> makeROM(const std::vector<uint8_t>& source, const std::vector<uint8_t>& acknowledge,
+                                    const std::vector<uint8_t>& handlerAcknowledge, uint8_t expectedIRQs,
+                                    uint8_t acknowledgeOnEntry = 1) {
+    std::vector<uint8_t> code = {0x78, 0xD8, 0xA2, 0xFF, 0x9A, 0xA9, 0x00, 0x85, 0x10}; // SEI; CLD; stack; count = 0
+    code.insert(code.end(), source.begin(), source.end());
+    code.insert(code.end(), acknowledge.begin(), acknowledge.end());
+    code.insert(code.end(), {0x58, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0x78}); // CLI; 8 x NOP; SEI
+    code.insert(code.end(), {0xA5, 0x10, 0xC9, expectedIRQs, 0xD0, 0x08});             // LDA count; CMP; BNE fail
+    uint16_t spin = static_cast<uint16_t>(0xE000 + code.size() + 5);
+    code.insert(code.end(), {0xA9, 0x5A, 0x8D, 0x00, 0x03});                           // LDA #$5A; STA $0300
+    code.insert(code.end(), {0x4C, uint8_t(spin & 0xFF), uint8_t(spin >> 8)});        // spin: JMP spin
+    uint16_t fail = spin + 3;
+    code.insert(code.end(), {0x4C, uint8_t(fail & 0xFF), uint8_t(fail >> 8)});         // fail: JMP fail
+
+    /* The handler acknowledges on its Nth entry; until then the line stays asserted and it is re-entered */
+    std::vector<uint8_t> handler = {0x48, 0xE6, 0x10, 0xA5, 0x10, 0xC9, acknowledgeOnEntry, 0x90,
+                                    uint8_t(handlerAcknowledge.size())};               // PHA; INC count; BCC done
+    handler.insert(handler.end(), handlerAcknowledge.begin(), handlerAcknowledge.end());
+    handler.insert(handler.end(), {0x68, 0x40});                                       // done: PLA; RTI
+
+    const std::vector<uint8_t> delay = {0xA2, 0x00, 0xA0, 0x00, 0x88, 0xD0, 0xFD, 0xCA, 0xD0, 0xFA, 0x60};
+
+    std::vector<uint8_t> prg(0x8000, 0xEA);
+    std::copy(code.begin(), code.end(), prg.begin() + 0x6000);
+    std::copy(delay.begin(), delay.end(), prg.begin() + (DELAY - 0x8000));
+    std::copy(handler.begin(), handler.end(), prg.begin() + (IRQ - 0x8000));
+    prg[NMI - 0x8000] = 0x40; // RTI
+    const uint16_t vectors[] = {NMI, 0xE000, IRQ};
+    for (int i = 0; i < 3; ++i) {
+        prg[0x7FFA + 2 * i] = vectors[i] & 0xFF;
+        prg[0x7FFB + 2 * i] = vectors[i] >> 8;
+    }
+
+    std::vector<uint8_t> rom = {'N', 'E', 'S', 0x1A, 2, 1, 0x40, 0};
+    rom.resize(16, 0);
+    rom.insert(rom.end(), prg.begin(), prg.end());
+    rom.resize(rom.size() + 0x2000, 0);
+    return rom;
+}
+
+static void check(const char* name, const std::vector<uint8_t>& rom) {
+    const std::string path = "irq_test.nes";
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(reinterpret_cast<const char*>(rom.data()), rom.size())) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+    file.close();
+
+    HeadlessOptions options;
+    options.romPath = path;
+    options.frameLimit = 60;
+    options.stopOnMemory = true;
+    options.stopAddress = 0x0300;
+    options.stopValue = 0x5A;
+    HeadlessRunner runner(options);
+    if (!runner.run().conditionMet) {
+        std::fprintf(stderr, "IRQ case failed: %s\n", name);
+        failures++;
+    }
+}
+
+int main() {
+    try {
+        /* Acknowledged while masked: the line is high again, CLI takes no IRQ */
+        check("frame IRQ acknowledged by a $4015 read", makeROM(WAIT, READ_4015, READ_4015, 0));
+        check("frame IRQ acknowledged by the $4017 inhibit bit", makeROM(WAIT, INHIBIT_FRAME_IRQ, READ_4015, 0));
+        check("DMC IRQ acknowledged by a $4010 write", makeROM(DMC_IRQ, DISABLE_DMC_IRQ, DISABLE_DMC_IRQ, 0));
+        check("DMC IRQ acknowledged by a $4015 write", makeROM(DMC_IRQ, STOP_DMC, DISABLE_DMC_IRQ, 0));
+        check("MMC3 IRQ acknowledged by a $E000 write", makeROM(MAPPER_IRQ, WRITE_E000, WRITE_E000, 0));
+
+        /* Not acknowledged: CLI takes the IRQ once, its handler acknowledges it */
+        check("frame IRQ taken after CLI", makeROM(WAIT, {}, READ_4015, 1));
+        check("DMC IRQ taken after CLI", makeROM(DMC_IRQ, {}, DISABLE_DMC_IRQ, 1));
+        check("MMC3 IRQ taken after CLI", makeROM(MAPPER_IRQ, {}, WRITE_E000, 1));
+
+        /* A level: RTI with the line still asserted takes the IRQ again */
+        check("frame IRQ retaken until acknowledged", makeROM(WAIT, {}, READ_4015, 3, 3));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    if (failures) {
+        std::fprintf(stderr, "%d cases failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
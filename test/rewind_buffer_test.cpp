@@ -0,0 +1,163 @@
+#include "rewind_buffer.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/* Reports a failed check and counts it; the test fails if any check did */
+static int failures = 0;
+#define CHECK(condition)                                                         \
+    do {                                                                         \
+        if (!(condition)) {                                                      \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+constexpr size_t SNAPSHOT_SIZE = 4096;
+
+/* Builds a history where each snapshot differs from the one before it by a few bytes, a block, or entirely */
+static std::vector<std::vector<uint8_t>> makeHistory(size_t frames, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<std::vector<uint8_t>> history(1, std::vector<uint8_t>(SNAPSHOT_SIZE));
+    for (auto& byte : history[0]) {
+        byte = random() & 0xFF;
+    }
+
+    while (history.size() < frames) {
+        std::vector<uint8_t> next = history.back();
+        switch (random() % 8) {
+            case 0: // Unchanged frame
+                break;
+            case 1: // New snapshot
+                for (auto& byte : next) {
+                    byte = random() & 0xFF;
+                }
+                break;
+            case 2: { // One block, including the last bytes of the snapshot
+                size_t start = random() % SNAPSHOT_SIZE;
+                for (size_t i = start; i < SNAPSHOT_SIZE && i < start + 300; ++i) {
+                    next[i] = random() & 0xFF;
+                }
+                break;
+            }
+            default: // A few scattered bytes, gaps shorter and longer than a skip
+                for (int changes = random() % 40; changes > 0; --changes) {
+                    next[random() % SNAPSHOT_SIZE] ^= 1 + random() % 255;
+                }
+                break;
+        }
+        history.push_back(std::move(next));
+    }
+    return history;
+}
+
+/* Pushes a history, then rewinds one frame at a time past the oldest stored frame */
+static void testRoundTrip(size_t budget, uint32_t seed) {
+    constexpr size_t FRAMES = 300;
+    auto history = makeHistory(FRAMES, seed);
+
+    RewindBuffer buffer(budget);
+    for (const auto& snapshot : history) {
+        buffer.push(snapshot.data(), snapshot.size());
+        CHECK(buffer.getUsedBytes() <= buffer.getBudget());
+    }
+    CHECK(buffer.getSnapshot() == history.back());
+    size_t reach = buffer.getFrameCount();
+    CHECK(reach < FRAMES);
+    if (budget >= 1024 * 1024) {
+        CHECK(reach == FRAMES - 1); // Large enough to hold the whole history
+    }
+
+    for (size_t back = 1; back <= reach; ++back) {
+        CHECK(buffer.rewind(1) == 1);
+        CHECK(buffer.getSnapshot() == history[FRAMES - 1 - back]);
+    }
+    CHECK(buffer.getFrameCount() == 0);
+    CHECK(buffer.getUsedBytes() == 0);
+
+    /* Past the oldest frame: nothing left to step back, the snapshot stays */
+    CHECK(buffer.rewind(1) == 0);
+    CHECK(buffer.getSnapshot() == history[FRAMES - 1 - reach]);
+
+    /* Recording resumes from the rewound frame */
+    buffer.push(history.back().data(), history.back().size());
+    CHECK(buffer.getFrameCount() == 1);
+    CHECK(buffer.rewind(5) == 1);
+    CHECK(buffer.getSnapshot() == history[FRAMES - 1 - reach]);
+}
+
+/* Rewinding several frames at once stops at the oldest one */
+static void testRewindPastOldest() {
+    auto history = makeHistory(50, 7);
+    RewindBuffer buffer(1024 * 1024);
+    for (const auto& snapshot : history) {
+        buffer.push(snapshot.data(), snapshot.size());
+    }
+
+    CHECK(buffer.rewind(10) == 10);
+    CHECK(buffer.getSnapshot() == history[39]);
+    CHECK(buffer.rewind(1000) == 39);
+    CHECK(buffer.getSnapshot() == history[0]);
+    CHECK(buffer.rewind(1000) == 0);
+    CHECK(buffer.getSnapshot() == history[0]);
+}
+
+/* A delta that does not fit in the arena cuts the history at the new frame */
+static void testRecordLargerThanArena() {
+    std::mt19937 random(11);
+    std::vector<uint8_t> first(SNAPSHOT_SIZE), second(SNAPSHOT_SIZE);
+    for (size_t i = 0; i < SNAPSHOT_SIZE; ++i) {
+        first[i] = random() & 0xFF;
+        second[i] = ~first[i];
+    }
+    std::vector<uint8_t> third = second;
+    third[100] ^= 0x55;
+
+    RewindBuffer buffer(256);
+    buffer.push(first.data(), first.size());
+    buffer.push(second.data(), second.size());
+    CHECK(buffer.getFrameCount() == 0);
+    CHECK(buffer.getUsedBytes() == 0);
+    CHECK(buffer.getSnapshot() == second);
+    CHECK(buffer.rewind(1) == 0);
+    CHECK(buffer.getSnapshot() == second);
+
+    /* Small deltas are recorded again afterwards */
+    buffer.push(third.data(), third.size());
+    CHECK(buffer.getFrameCount() == 1);
+    CHECK(buffer.rewind(2) == 1);
+    CHECK(buffer.getSnapshot() == second);
+}
+
+/* A snapshot of another size (another ROM) starts a new history */
+static void testSizeChange() {
+    std::vector<uint8_t> small(100, 1), large(200, 2), larger(200, 3);
+    RewindBuffer buffer(4096);
+    buffer.push(small.data(), small.size());
+    buffer.push(small.data(), small.size());
+    CHECK(buffer.getFrameCount() == 1);
+
+    buffer.push(large.data(), large.size());
+    CHECK(buffer.getFrameCount() == 0);
+    buffer.push(larger.data(), larger.size());
+    CHECK(buffer.rewind(3) == 1);
+    CHECK(buffer.getSnapshot() == large);
+}
+
+int main() {
+    const size_t budgets[] = {64, 1024, 16 * 1024, 64 * 1024, RewindBuffer::DEFAULT_BUDGET};
+    uint32_t seed = 1;
+    for (size_t budget : budgets) {
+        testRoundTrip(budget, seed++);
+        testRoundTrip(budget, seed++);
+    }
+    testRewindPastOldest();
+    testRecordLargerThanArena();
+    testSizeChange();
+
+    if (failures) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
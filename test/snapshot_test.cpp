@@ -0,0 +1,184 @@
+#include "headless_runner.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Reports a failed check and counts it; the test fails if any check did */
+static int failures = 0;
+#define CHECK(condition)                                                         \
+    do {                                                                         \
+        if (!(condition)) {                                                      \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+constexpr uint64_t FRAMES_PER_RUN = 30;
+
+/*
+ * Builds a 32 KB PRG / 8 KB CHR ROM whose code runs from $E000. With
+ * rendering, the NMI, OAM DMA, a pulse channel and the APU frame IRQ
+ * enabled, every component has state that moves from frame to frame.
+ * The MMC3 build also switches banks every pass, writes PRG-RAM and
+ * takes scanline IRQs.
+ */
+static std::vector<uint8_t> makeROM(bool mmc3, uint8_t seed) {
+    std::vector<uint8_t> code;
+    auto emit = [&code](std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); };
+    auto address = [&code]() { return static_cast<uint16_t>(0xE000 + code.size()); };
+
+    /* Reset: wait two vblanks for the PPU to warm up */
+    emit({0x78, 0xD8, 0xA2, 0xFF, 0x9A});                         // SEI; CLD; LDX #$FF; TXS
+    emit({0x2C, 0x02, 0x20, 0x10, 0xFB});                         // BIT $2002; BPL -5
+    emit({0x2C, 0x02, 0x20, 0x10, 0xFB});
+    if (mmc3) {
+        emit({0xA9, 0x20, 0x8D, 0x00, 0xC0});                     // LDA #$20; STA $C000 (IRQ latch)
+        emit({0x8D, 0x01, 0xC0, 0x8D, 0x01, 0xE0});               // STA $C001 (reload); STA $E001 (IRQ on)
+        emit({0xA9, 0x80, 0x8D, 0x01, 0xA0});                     // LDA #$80; STA $A001 (PRG-RAM on)
+    }
+    emit({0xA9, 0x0F, 0x8D, 0x15, 0x40});                         // LDA #$0F; STA $4015
+    emit({0xA9, 0xBF, 0x8D, 0x00, 0x40});                         // LDA #$BF; STA $4000
+    emit({0xA9, seed, 0x8D, 0x02, 0x40});                         // LDA #seed; STA $4002
+    emit({0xA9, 0x08, 0x8D, 0x03, 0x40});                         // LDA #$08; STA $4003
+    emit({0xA9, 0x88, 0x8D, 0x00, 0x20});                         // LDA #$88; STA $2000 (NMI, sprites at $1000)
+    emit({0xA9, 0x1E, 0x8D, 0x01, 0x20});                         // LDA #$1E; STA $2001 (rendering on)
+    emit({0x58});                                                 // CLI
+
+    /* Main loop: mix two counters into the OAM page and PRG-RAM */
+    uint16_t loop = address();
+    emit({0xE6, 0x10, 0xA6, 0x10, 0x8A, 0x45, 0x11});             // INC $10; LDX $10; TXA; EOR $11
+    emit({0x9D, 0x00, 0x02});                                     // STA $0200,X
+    if (mmc3) {
+        emit({0x9D, 0x00, 0x60});                                 // STA $6000,X
+        emit({0x8A, 0x29, 0x07, 0x8D, 0x00, 0x80});               // TXA; AND #$07; STA $8000 (bank select)
+        emit({0xA5, 0x11, 0x8D, 0x01, 0x80});                     // LDA $11; STA $8001 (bank data)
+    }
+    emit({0x4C, uint8_t(loop & 0xFF), uint8_t(loop >> 8)});       // JMP loop
+
+    /* NMI: OAM DMA, scroll and pitch follow the frame counter */
+    uint16_t nmi = address();
+    emit({0x48, 0xE6, 0x11});                                     // PHA; INC $11
+    emit({0xA9, 0x00, 0x8D, 0x03, 0x20, 0xA9, 0x02, 0x8D, 0x14, 0x40}); // LDA #0; STA $2003; LDA #2; STA $4014
+    emit({0xA5, 0x11, 0x8D, 0x05, 0x20, 0x8D, 0x05, 0x20});       // LDA $11; STA $2005; STA $2005
+    emit({0x8D, 0x02, 0x40, 0x68, 0x40});                         // STA $4002; PLA; RTI
+
+    /* IRQ: acknowledge the mapper and the APU frame counter */
+    uint16_t irq = address();
+    emit({0x48, 0x8D, 0x00, 0xE0, 0x8D, 0x01, 0xE0});             // PHA; STA $E000; STA $E001
+    emit({0xAD, 0x15, 0x40, 0xE6, 0x12, 0x68, 0x40});             // LDA $4015; INC $12; PLA; RTI
+
+    std::vector<uint8_t> prg(0x8000, 0xEA);
+    std::copy(code.begin(), code.end(), prg.begin() + 0x6000);
+    const uint16_t vectors[] = {nmi, 0xE000, irq};
+    for (int i = 0; i < 3; ++i) {
+        prg[0x7FFA + 2 * i] = vectors[i] & 0xFF;
+        prg[0x7FFB + 2 * i] = vectors[i] >> 8;
+    }
+
+    std::vector<uint8_t> rom = {'N', 'E', 'S', 0x1A, 2, 1, uint8_t(mmc3 ? 0x40 : 0x00), 0};
+    rom.resize(16, 0);
+    rom.insert(rom.end(), prg.begin(), prg.end());
+    for (int i = 0; i < 0x2000; ++i) {
+        rom.push_back(static_cast<uint8_t>(i * 7 + seed));
+    }
+    return rom;
+}
+
+static void writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+static std::vector<uint8_t> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static std::vector<uint8_t> runAndSave(HeadlessRunner& runner) {
+    std::vector<uint8_t> snapshot;
+    runner.run();
+    snapshot.resize(runner.saveState(snapshot));
+    return snapshot;
+}
+
+/* Restoring a snapshot and running on reproduces the original run, in the same instance and in a new one */
+static void testDeterminism(const std::string& romPath) {
+    HeadlessOptions options;
+    options.romPath = romPath;
+    options.frameLimit = FRAMES_PER_RUN;
+
+    HeadlessRunner runner(options);
+    std::vector<uint8_t> first = runAndSave(runner);
+    std::vector<uint8_t> second = runAndSave(runner);
+    std::vector<uint8_t> third = runAndSave(runner);
+    CHECK(first != second);
+    CHECK(second != third);
+
+    /* Same instance */
+    runner.loadState(first);
+    CHECK(runAndSave(runner) == second);
+    CHECK(runAndSave(runner) == third);
+
+    /* New instance, through the snapshot files --load-state and --save-state use */
+    std::string statePath = romPath + ".state";
+    std::string resumedPath = romPath + ".resumed.state";
+    writeFile(statePath, first);
+    options.loadStatePath = statePath;
+    options.saveStatePath = resumedPath;
+    HeadlessRunner resumed(options);
+    resumed.run();
+    CHECK(readFile(resumedPath) == second);
+    CHECK(runAndSave(resumed) == third);
+}
+
+/* A snapshot only loads into a machine running the ROM it was taken from */
+static void testOtherROMRejected(const std::string& romPath, const std::string& otherROMPath) {
+    HeadlessOptions options;
+    options.romPath = romPath;
+    options.frameLimit = FRAMES_PER_RUN;
+    HeadlessRunner runner(options);
+    std::vector<uint8_t> snapshot = runAndSave(runner);
+
+    std::string statePath = romPath + ".state";
+    writeFile(statePath, snapshot);
+    options.romPath = otherROMPath;
+    options.loadStatePath = statePath;
+    bool rejected = false;
+    try {
+        HeadlessRunner other(options);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+int main() {
+    const std::string mmc3Path = "snapshot_test_mmc3.nes";
+    const std::string nromPath = "snapshot_test_nrom.nes";
+    const std::string variantPath = "snapshot_test_mmc3_variant.nes";
+    writeFile(mmc3Path, makeROM(true, 0x50));
+    writeFile(nromPath, makeROM(false, 0x50));
+    writeFile(variantPath, makeROM(true, 0x51)); // Same mapper and sizes, different contents
+
+    try {
+        testDeterminism(mmc3Path);
+        testDeterminism(nromPath);
+        testOtherROMRejected(mmc3Path, nromPath);
+        testOtherROMRejected(nromPath, mmc3Path);
+        testOtherROMRejected(mmc3Path, variantPath);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    if (failures) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}